@@ -85,10 +85,10 @@ fi
 
 # Build specific extended tests for code correctness validation
 if [[ $BUILD_SANITIZERS -ne 0 ]]; then
-	cmake_build build-asan test_connection test_crypto
-	cmake_build build-ubsan test_connection test_crypto
+	cmake_build build-asan test_connection test_crypto test_thinker
+	cmake_build build-ubsan test_connection test_crypto test_thinker
 	if [[ -d build-tsan ]]; then
-		cmake_build build-tsan test_connection test_crypto
+		cmake_build build-tsan test_connection test_crypto test_thinker
 	fi
 fi
 
@@ -97,6 +97,7 @@ build-cmake-ref/tests/test_crypto
 [[ $BUILD_LIBSODIUM -ne 0 ]] && build-cmake-sodium/tests/test_crypto
 build-cmake-sodium25519/tests/test_crypto
 build-cmake/tests/test_crypto
+build-cmake/tests/test_thinker
 build-cmake/tests/test_connection
 
 # Run sanitized builds
@@ -104,6 +105,7 @@ if [[ $BUILD_SANITIZERS -ne 0 ]]; then
 	for SANITIZER in asan ubsan tsan; do
 		[[ -d build-${SANITIZER} ]] || continue
 		build-${SANITIZER}/tests/test_crypto
+		build-${SANITIZER}/tests/test_thinker
 		build-${SANITIZER}/tests/test_connection
 	done
 fi
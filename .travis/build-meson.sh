@@ -39,6 +39,7 @@ ninja -v -C build-meson-ref
 
 # Run basic tests
 build-meson/tests/test_crypto
+build-meson/tests/test_thinker
 [[ $BUILD_LIBSODIUM -ne 0 ]] && build-meson-sodium/tests/test_crypto
 build-meson-sodium25519/tests/test_crypto
 build-meson-ref/tests/test_crypto
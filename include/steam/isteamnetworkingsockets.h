@@ -219,6 +219,11 @@ public:
 	///
 	/// The pOutMessageNumber is an optional pointer to receive the
 	/// message number assigned to the message, if sending was successful.
+	/// If k_ESteamNetworkingConfig_LockFreeSendQueueSize is set, the message
+	/// number is not known yet, and 0 is returned for a message that was
+	/// queued.  The only error returned in that mode is k_EResultLimitExceeded
+	/// (the queue is full); other errors are discovered later, and counted by
+	/// SteamNetworkingSockets_GetLockFreeSendStats.
 	///
 	/// Returns:
 	/// - k_EResultInvalidParam: invalid connection handle, or the individual message is too big.
@@ -262,7 +267,10 @@ public:
 	/// value is placed into the array.  For example, the array will hold
 	/// -k_EResultInvalidState if the connection was in an invalid state.
 	/// See ISteamNetworkingSockets::SendMessageToConnection for possible
-	/// failure codes.
+	/// failure codes.  (If k_ESteamNetworkingConfig_LockFreeSendQueueSize
+	/// is set, then 0 is placed into the array for messages that were queued.
+	/// Use SteamNetworkingSockets_GetLockFreeSendStats to find out if any of
+	/// them failed later.)
 	virtual void SendMessages( int nMessages, SteamNetworkingMessage_t *const *pMessages, int64 *pOutMessageNumberOrResult ) = 0;
 
 	/// Flush any messages waiting on the Nagle timer and send them
@@ -432,6 +440,9 @@ public:
 	/// (But the messages are not grouped by connection, so they will not necessarily
 	/// appear consecutively in the list; they may be interleaved with messages for
 	/// other connections.)
+	///
+	/// If k_ESteamNetworkingConfig_PollGroupRecvRingSize was set when the poll group
+	/// was created, this usually doesn't need to take the global lock.
 	virtual int ReceiveMessagesOnPollGroup( HSteamNetPollGroup hPollGroup, SteamNetworkingMessage_t **ppOutMessages, int nMaxMessages ) = 0; 
 
 #ifdef STEAMNETWORKINGSOCKETS_ENABLE_SDR
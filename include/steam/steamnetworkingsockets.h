@@ -23,12 +23,205 @@ STEAMNETWORKINGSOCKETS_INTERFACE bool GameNetworkingSockets_Init( const SteamNet
 // Close all connections and listen sockets and free all resources
 STEAMNETWORKINGSOCKETS_INTERFACE void GameNetworkingSockets_Kill();
 
+//
+// Manual polling.  Normally the library runs its own service thread.  In
+// manual poll mode, no service thread is started, and you must call one of
+// the functions below regularly.
+//
+
+/// Turn manual poll mode on or off.  Turning it on stops the service thread.
+STEAMNETWORKINGSOCKETS_INTERFACE void SteamNetworkingSockets_SetManualPollMode( bool bFlag );
+
+/// Wait up to msMaxWaitTime for something to do, and do it.
+STEAMNETWORKINGSOCKETS_INTERFACE void SteamNetworkingSockets_Poll( int msMaxWaitTime );
+
+/// Get a descriptor that you can add to your own epoll (or poll/select) loop,
+/// for readability.  It becomes readable when any of our sockets has data,
+/// or when we need SteamNetworkingSockets_ProcessReady to be called earlier
+/// than the time returned by SteamNetworkingSockets_GetNextThinkTime.
+/// Returns -1 if this is not available on this platform, or when io_uring
+/// is being used (k_ESteamNetworkingConfig_UDPIOUring), in which case you
+/// must use SteamNetworkingSockets_Poll.
+STEAMNETWORKINGSOCKETS_INTERFACE int SteamNetworkingSockets_GetPollFD();
+
+/// Get the time (see SteamNetworkingUtils()->GetLocalTimestamp) at which
+/// SteamNetworkingSockets_ProcessReady should next be called, even if the
+/// descriptor is not readable.  Returns INT64_MAX if there is nothing scheduled.
+STEAMNETWORKINGSOCKETS_INTERFACE SteamNetworkingMicroseconds SteamNetworkingSockets_GetNextThinkTime();
+
+/// Process whatever is ready, without ever sleeping.  Call this when the
+/// descriptor from SteamNetworkingSockets_GetPollFD is readable, or when the
+/// next think time is reached.  Only valid in manual poll mode.
+STEAMNETWORKINGSOCKETS_INTERFACE void SteamNetworkingSockets_ProcessReady();
+
 //
 // Statistics about the global lock.
 //
 STEAMNETWORKINGSOCKETS_INTERFACE void SteamNetworkingSockets_SetLockWaitWarningThreshold( SteamNetworkingMicroseconds usecThreshold );
 STEAMNETWORKINGSOCKETS_INTERFACE void SteamNetworkingSockets_SetLockAcquiredCallback( void (*callback)( SteamNetworkingMicroseconds usecWaited ) );
 
+/// Lock times are kept in log-scale histograms.  Bucket 0 counts times of
+/// 0us, bucket 1 counts 1us, and bucket n counts times from 2^(n-1) up to
+/// 2^n-1 microseconds.  The last bucket also counts everything longer.
+const int k_nSteamNetworkingSocketsLockHistogramBuckets = 24;
+
+/// How long the lock was waited for and held, by tag.  The tag is the name
+/// of the API call or internal operation, e.g. "ServiceThread" or
+/// "RecvUDPPacket".  Wait time is charged to the tag that was trying to get
+/// the lock.  Each time the lock is released, the hold time is charged to
+/// every tag that was attached while it was held.  (Recursive locking by
+/// the same thread is not counted separately, and neither are attempts to
+/// lock that timed out.)
+struct SteamNetworkingSocketsLockStats
+{
+	char m_szTag[ 64 ];
+
+	int64 m_nWaits;
+	int64 m_usecWaitTotal;
+	int64 m_usecWaitMax;
+	int64 m_nWaitHistogram[ k_nSteamNetworkingSocketsLockHistogramBuckets ];
+
+	int64 m_nHolds;
+	int64 m_usecHoldTotal;
+	int64 m_usecHoldMax;
+	int64 m_nHoldHistogram[ k_nSteamNetworkingSocketsLockHistogramBuckets ];
+};
+
+/// Fill in stats for up to nMaxTags tags, in no particular order.  Returns the
+/// number of distinct tags seen, which might be more than nMaxTags.  These are
+/// totals since the library was loaded, or SteamNetworkingSockets_ResetLockStats
+/// was called.
+STEAMNETWORKINGSOCKETS_INTERFACE int SteamNetworkingSockets_GetLockStats( SteamNetworkingSocketsLockStats *pStats, int nMaxTags );
+
+/// Clear lock stats for all tags
+STEAMNETWORKINGSOCKETS_INTERFACE void SteamNetworkingSockets_ResetLockStats();
+
+/// Stats for a poll group's lock-free delivery ring.
+/// (See k_ESteamNetworkingConfig_PollGroupRecvRingSize)
+struct SteamNetworkingPollGroupRecvRingStats
+{
+	/// Number of slots in the ring (0 if the poll group doesn't have one),
+	/// how many are in use right now, and the most that were ever in use.
+	int m_nRingSize;
+	int m_nRingDepth;
+	int m_nRingMaxDepth;
+
+	/// Number of messages delivered through the ring.
+	int64 m_nMessagesRing;
+
+	/// Number of messages that went into the ordinary queue instead,
+	/// because the ring was full, or earlier messages were still waiting
+	/// in the ordinary queue.  Fetching these needs the lock.
+	int64 m_nMessagesQueued;
+
+	/// Number of times a message didn't fit because the ring was full.
+	/// If this is increasing, you aren't polling often enough, or the ring
+	/// is too small.
+	int64 m_nRingFull;
+};
+
+/// Get stats for a poll group's delivery ring.  Returns false if the handle
+/// is bad.
+STEAMNETWORKINGSOCKETS_INTERFACE bool SteamNetworkingSockets_GetPollGroupRecvRingStats( HSteamNetPollGroup hPollGroup, SteamNetworkingPollGroupRecvRingStats *pStats );
+
+/// Results for messages sent without the lock.  Those calls return before
+/// the message is actually sent, so this is how to find out if any of them
+/// failed later.  (See k_ESteamNetworkingConfig_LockFreeSendQueueSize)
+struct SteamNetworkingLockFreeSendStats
+{
+	/// Number of messages taken from the queue and passed on to be sent
+	int64 m_nMessages;
+
+	/// Number of those that failed, and were discarded.  (E.g. because
+	/// the connection's send buffer was full, or the connection was closed.)
+	/// How many of them were sent reliably, and the result code of the most
+	/// recent failure, or k_EResultOK if nothing has failed.
+	int64 m_nFailed;
+	int64 m_nFailedReliable;
+	EResult m_eLastFailure;
+};
+
+/// Get totals for messages sent without the lock to a connection, since it
+/// was created.  Pass k_HSteamNetConnection_Invalid to get totals for all
+/// connections since the library was loaded.  These also count messages to
+/// handles that were bad by the time they were sent.  Returns false if the
+/// handle is bad.
+STEAMNETWORKINGSOCKETS_INTERFACE bool SteamNetworkingSockets_GetLockFreeSendStats( HSteamNetConnection hConn, SteamNetworkingLockFreeSendStats *pStats );
+
+//
+// Statistics about the low level UDP sockets.  These are totals for all
+// sockets, accumulated since the library was loaded.
+//
+struct SteamNetworkingSocketsUDPStats
+{
+	/// Number of receive system calls that returned data, and the total number
+	/// of datagrams they returned.  The ratio is the average number of packets
+	/// pulled out of the kernel per system call.
+	int64 m_nRecvCalls;
+	int64 m_nRecvPackets;
+
+	/// Number of send system calls, and the total number of datagrams sent.
+	/// These will differ when sends are batched.  A batch send that had to
+	/// be retried is only counted once.
+	/// (See k_ESteamNetworkingConfig_UDPSendBatchSize)
+	int64 m_nSendCalls;
+	int64 m_nSendPackets;
+
+	/// Number of passes where the service thread polled without blocking
+	/// because it was busy polling, and the number of those passes that
+	/// actually found something to do.
+	/// (See k_ESteamNetworkingConfig_ServiceThreadBusyPoll)
+	int64 m_nBusyPollSpins;
+	int64 m_nBusyPollUseful;
+
+	/// Number of datagrams the kernel dropped because a socket's receive
+	/// buffer was full, i.e. because we weren't pulling them out fast
+	/// enough.  Linux only.  (SO_RXQ_OVFL)
+	int64 m_nKernelDrops;
+
+	/// Number of times the service thread (or SteamNetworkingSockets_Poll)
+	/// actually went to sleep and woke back up, and the number of those
+	/// wakeups where some periodic processing was due.  Sample these twice
+	/// to get wakeups per second.  (See k_ESteamNetworkingConfig_TimerSlack)
+	int64 m_nWakeups;
+	int64 m_nThinkerWakeups;
+
+	/// Number of datagrams that were sent as segments of a coalesced
+	/// (UDP GSO) send.  These are included in m_nSendPackets.
+	/// (See k_ESteamNetworkingConfig_UDPSendGSO)
+	int64 m_nSendGSOSegments;
+
+	/// Number of batch send system calls that were retried, because they
+	/// were interrupted or because UDP GSO turned out not to work.  These
+	/// are not included in m_nSendCalls.
+	int64 m_nSendRetries;
+};
+STEAMNETWORKINGSOCKETS_INTERFACE void SteamNetworkingSockets_GetUDPStats( SteamNetworkingSocketsUDPStats *pStats );
+
+//
+// Statistics about each low level UDP socket that is currently open.
+//
+struct SteamNetworkingSocketsUDPSocketStats
+{
+	/// Local address the socket is bound to
+	SteamNetworkingIPAddr m_addrLocal;
+
+	/// Number of datagrams received on this socket
+	int64 m_nRecvPackets;
+
+	/// Number of datagrams the kernel dropped on this socket because the
+	/// receive buffer was full.  Linux only.  (SO_RXQ_OVFL)
+	int64 m_nKernelDrops;
+
+	/// Size of the kernel receive buffer, as reported by SO_RCVBUF.
+	/// (See k_ESteamNetworkingConfig_UDPRecvBufferMax)
+	int m_cbRecvBuffer;
+};
+
+/// Fill in stats for up to nMaxSockets sockets.  Returns the number of
+/// sockets that are open, which might be more than nMaxSockets.
+STEAMNETWORKINGSOCKETS_INTERFACE int SteamNetworkingSockets_GetUDPSocketStats( SteamNetworkingSocketsUDPSocketStats *pStats, int nMaxSockets );
+
 }
 
 /// Callback dispatch mechanism.  Override this and then use
@@ -1108,6 +1108,197 @@ enum ESteamNetworkingConfigValue
 	/// (We chose a random delay between 0 and this value)
 	k_ESteamNetworkingConfig_FakePacketDup_TimeMax = 28,
 
+	//
+	// Low level UDP socket tuning.  These are global options, since they
+	// are applied at a low level where we don't have much context.
+	//
+
+	/// [global int32] Max number of outbound UDP packets to queue on a socket and
+	/// then send with a single system call.  The queue is flushed when it fills up,
+	/// and whenever the global lock is released (at the end of each pass of the
+	/// service thread, or at the end of an API call that sent packets).
+	/// 0 or 1 (the default) disables batching, and each packet is sent immediately.
+	/// Only supported on Linux (sendmmsg), it is ignored on other platforms.
+	k_ESteamNetworkingConfig_UDPSendBatchSize = 39,
+
+	/// [global int32] 0 or 1.  Use UDP generic segmentation offload, if the
+	/// kernel supports it.  Runs of outbound packets of the same size to the
+	/// same destination (such as a connection sending a large reliable stream)
+	/// are handed to the kernel as a single buffer, and segmented by the kernel
+	/// or the NIC.  Enabling this implies that sends are queued, as described
+	/// for k_ESteamNetworkingConfig_UDPSendBatchSize.  If GSO is not supported,
+	/// or fails, packets are sent normally.  Default is 0 (off).  Linux only.
+	k_ESteamNetworkingConfig_UDPSendGSO = 40,
+
+	/// [global int32] 0 or 1.  Enable UDP generic receive offload on sockets
+	/// opened after this is set.  The kernel may then coalesce a run of datagrams
+	/// from the same sender into a single buffer (up to 64KB), which we split back
+	/// into individual packets.  This reduces per-packet kernel overhead for high
+	/// throughput downloads.  Default is 0 (off).  Linux only.
+	k_ESteamNetworkingConfig_UDPRecvGRO = 41,
+
+	/// [global int32] 0 or 1.  Use io_uring for raw UDP sockets.  Receives
+	/// are kept armed as multishot requests with kernel provided buffers,
+	/// sends are queued and submitted together when the lock is released,
+	/// and the service thread waits on the completion queue.  This is read when
+	/// low level support is initialized, so it must be set before the first
+	/// interface is created.  If the kernel doesn't support the features we
+	/// need, we fall back to ordinary socket calls.  Default is 0 (off).  Linux only.
+	k_ESteamNetworkingConfig_UDPIOUring = 42,
+
+	/// [global int32] 0 or 1.  Ask the kernel to timestamp datagrams as they
+	/// arrive on sockets opened after this is set.  Receive times are then
+	/// measured from when the packet hit the socket rather than when we got
+	/// around to processing it, so time spent waiting on the global lock or
+	/// processing earlier packets in a batch doesn't inflate ping or jitter.
+	/// Packets delayed by the fake lag simulation use the time they are
+	/// delivered.  Default is 0 (off).  Linux only.
+	k_ESteamNetworkingConfig_UDPRecvKernelTimestamps = 45,
+
+	/// [global int32] Spin window for the service thread, in microseconds.
+	/// On Linux, the service thread sleeps until exactly when the next bit of
+	/// periodic processing (sending a paced packet, flushing an ack, etc) is
+	/// due, rather than rounding to the nearest millisecond.  However, the
+	/// kernel might wake us late by up to its timer slack (50us by default).
+	/// If the next deadline is closer than this, we don't sleep, and just check
+	/// the sockets without blocking until it arrives.  This costs CPU, but
+	/// gives tighter packet spacing.  Default is 0 (never spin).  Max is 1000.
+	k_ESteamNetworkingConfig_ServiceThreadSpinWindow = 46,
+
+	/// [global int32] Busy poll mode for the service thread, for when you
+	/// would rather dedicate a core than add latency.  Whenever the service
+	/// thread finds something to do (packets to process or a thinker that is
+	/// due), it keeps polling the sockets without blocking for this many
+	/// microseconds, rather than going to sleep.  After it has been idle this
+	/// long, it goes back to blocking.  The effectiveness of this can be
+	/// measured with SteamNetworkingSocketsUDPStats::m_nBusyPollSpins and
+	/// m_nBusyPollUseful.  Doesn't affect manual poll mode.  Default is 0 (off).
+	k_ESteamNetworkingConfig_ServiceThreadBusyPoll = 47,
+
+	/// [global int32] Set SO_BUSY_POLL to this many microseconds on raw UDP
+	/// sockets opened after this is set.  When we try to receive and there's
+	/// nothing queued, the kernel will busy poll the device queue for up to
+	/// this long.  Raising this above net.core.busy_read usually requires
+	/// CAP_NET_ADMIN.  If it fails, we continue without it.  Default is 0
+	/// (off).  Linux only.
+	k_ESteamNetworkingConfig_UDPSocketBusyPoll = 48,
+
+	/// [global string] Name of a network interface (e.g. "eth0") on which to
+	/// receive and send IPv4 datagrams for raw UDP sockets using AF_XDP,
+	/// bypassing most of the kernel network stack.  We attach a small XDP
+	/// program that redirects UDP datagrams addressed to the ports of our
+	/// sockets to a single queue of the interface.  Everything else, including
+	/// IPv6, continues to go through ordinary sockets.  Traffic must be steered
+	/// to that queue (e.g. with ethtool flow rules, or by using a single queue).
+	/// Only sockets bound to the "any" address are eligible.  Requires
+	/// CAP_NET_ADMIN and CAP_BPF (or root).  Can't be used with io_uring.
+	/// Must be set before the library is initialized.  If it fails, we
+	/// continue without it.  Default is "" (off).  Linux only.
+	k_ESteamNetworkingConfig_XDP_Interface = 49,
+
+	/// [global int32] Queue of k_ESteamNetworkingConfig_XDP_Interface to
+	/// bind to.  Default is 0.
+	k_ESteamNetworkingConfig_XDP_Queue = 50,
+
+	/// [global int32] When a raw UDP socket reports that the kernel dropped
+	/// datagrams because its receive buffer was full, double the receive
+	/// buffer, up to this many bytes.  Growing past net.core.rmem_max
+	/// requires CAP_NET_ADMIN.  Default is 0 (off).  Linux only.
+	/// (See SteamNetworkingSockets_GetUDPSocketStats)
+	k_ESteamNetworkingConfig_UDPRecvBufferMax = 51,
+
+	/// [global string] CPUs the service thread may run on, e.g. "2" or
+	/// "0,4-7".  A common tuning step is to pin it next to the core that
+	/// handles the NIC's interrupts.  Default is "" (leave it alone).
+	/// Takes effect when the thread starts.  Linux only.
+	k_ESteamNetworkingConfig_ServiceThreadAffinity = 52,
+
+	/// [global int32] Scheduling policy for the service thread.  0 = default
+	/// (just try to raise the priority a bit), 1 = SCHED_FIFO, 2 = SCHED_RR.
+	/// Real-time policies require CAP_SYS_NICE; if that fails, we fall back to
+	/// the default.  Takes effect when the thread starts.  POSIX only.
+	k_ESteamNetworkingConfig_ServiceThreadSchedPolicy = 53,
+
+	/// [global int32] Priority to use with SCHED_FIFO or SCHED_RR.
+	/// Default is 0, which picks a priority 3/4 of the way up the range.
+	k_ESteamNetworkingConfig_ServiceThreadSchedPriority = 54,
+
+	/// [global string] Name of the service thread, as seen by debuggers and
+	/// tools like top.  Names are truncated to 15 characters.  Default is
+	/// "SteamNetworking".  Linux only.
+	k_ESteamNetworkingConfig_ServiceThreadName = 55,
+
+	/// [global int32] Timer slack for non-urgent periodic processing, in
+	/// microseconds.  Things like the periodic connection check, keepalives
+	/// and stats are allowed to happen up to this much later than they
+	/// were scheduled.  Then timers for many connections can share a
+	/// wakeup of the service thread, instead of each waking it up at its
+	/// own exact time.  This saves CPU and power on servers with lots of
+	/// mostly idle connections.  Sending data, acks and retries are never
+	/// delayed.  Default is 10000 (10ms).
+	/// (See SteamNetworkingSocketsUDPStats::m_nWakeups)
+	k_ESteamNetworkingConfig_TimerSlack = 57,
+
+	/// [global int32] If nonzero, ISteamNetworkingSockets::SendMessages and
+	/// SendMessageToConnection don't take the global lock.  Messages are
+	/// put into a lock-free queue and the call returns immediately.  The
+	/// service thread picks them up on its next pass, and then they are
+	/// handled just as if they had been sent normally.  This value is the
+	/// max number of bytes that may be waiting in that queue, for all
+	/// connections.  If it is full, sending fails with
+	/// k_EResultLimitExceeded.
+	///
+	/// In this mode, the message number isn't known when the call returns,
+	/// so 0 is returned in its place.  If the service thread finds an error
+	/// when it picks up the message (such as a bad connection handle or a
+	/// full send buffer), the message is discarded, and the failure is
+	/// counted.  Use SteamNetworkingSockets_GetLockFreeSendStats to check
+	/// for this.  k_nSteamNetworkingSend_UseCurrentThread is ignored.
+	/// Any other API call on a connection first processes the queue, so
+	/// that e.g. a message sent just before CloseConnection with linger is
+	/// not lost.  Default is 0 (disabled).
+	k_ESteamNetworkingConfig_LockFreeSendQueueSize = 59,
+
+	/// [global int32] If nonzero, poll groups get a lock-free ring with this
+	/// many slots (rounded up to a power of two), and messages for
+	/// connections in the poll group are delivered into it.
+	/// ReceiveMessagesOnPollGroup then drains the ring without taking the
+	/// global lock, so polling doesn't compete with packet processing.  If
+	/// the ring is full, messages go into the ordinary queue, and the next
+	/// ReceiveMessagesOnPollGroup call takes the lock to get them.  Ordering
+	/// is preserved either way.  See SteamNetworkingSockets_GetPollGroupRecvRingStats
+	/// to tell if the ring is big enough.  Read when the poll group is created.
+	///
+	/// Messages in the ring are not in any connection's queue.  So
+	/// ReceiveMessagesOnConnection won't return them, they are not discarded
+	/// when the connection is closed, and SetConnectionUserData won't change
+	/// them.  Only one thread should call ReceiveMessagesOnPollGroup on a given
+	/// poll group at a time (if two do, one of them gets nothing).  It is
+	/// safe to destroy the poll group while another thread is receiving from
+	/// it; that call just returns what it already got.  Default is 0 (disabled).
+	k_ESteamNetworkingConfig_PollGroupRecvRingSize = 60,
+
+	/// [global int32] How much detail to keep in connection stats.  The
+	/// counters and histograms are always kept.  The samples used to compute
+	/// lifetime percentiles (ping, quality, speed) add several KB to each
+	/// connection, so they are only allocated when needed:
+	///
+	/// 0: When GetDetailedConnectionStatus is first called for the
+	///    connection.
+	/// 1: When the connection is created.
+	/// 2: Same as 1, and also keep a history of recently received
+	///    sequence numbers, for debugging packet accounting.
+	///
+	/// If the samples don't cover the whole connection, lifetime
+	/// percentiles (including the ones sent to the peer) are estimated
+	/// from the histograms instead.  These are coarser, but never missing.
+	/// With the default of 0, that is usually the case.  The detailed
+	/// connection status marks such percentiles as "estimated from
+	/// histogram", and the flag is sent to the peer along with them.  Set 1
+	/// to always get exact percentiles.  Read when the connection is
+	/// created.  Default is 0.
+	k_ESteamNetworkingConfig_LinkStatsDetail = 61,
+
 	/// [connection int32] Timeout value (in ms) to use when first connecting
 	k_ESteamNetworkingConfig_TimeoutInitial = 24,
 
@@ -1278,6 +1469,24 @@ enum ESteamNetworkingConfigValue
 	/// This value should not be read or written in any other context.
 	k_ESteamNetworkingConfig_LocalVirtualPort = 38,
 
+	/// [connection int32] Set this on a listen socket created with CreateListenSocketIP
+	/// to open that many sockets bound to the same address using SO_REUSEPORT.  The
+	/// kernel hashes the source address of incoming traffic to pick one of the sockets,
+	/// so each client sticks to one of them, and replies go out on the same one.
+	///
+	/// This only spreads the work done in the kernel: each socket gets its own receive
+	/// queue and buffer, so a burst on one doesn't drop packets for the others.  It
+	/// does NOT spread our own processing over more than one core.  All of the sockets
+	/// are serviced by the same service thread, and every packet is still processed
+	/// while holding the one global lock.
+	///
+	/// Any other process running as the same user can join the group by binding the
+	/// same port with SO_REUSEPORT, so only use this if you trust the box.  Default
+	/// is 1, max is 16.  Linux only, on other platforms a single socket is always used.
+	///
+	/// This value should not be read or written in any other context.
+	k_ESteamNetworkingConfig_IP_ListenSocketShards = 43,
+
 	//
 	// Callbacks
 	//
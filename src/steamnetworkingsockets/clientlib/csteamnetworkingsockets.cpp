@@ -41,6 +41,25 @@ DEFINE_GLOBAL_CONFIGVAL( float, FakePacketDup_Send, 0.0f, 0.0f, 100.0f );
 DEFINE_GLOBAL_CONFIGVAL( float, FakePacketDup_Recv, 0.0f, 0.0f, 100.0f );
 DEFINE_GLOBAL_CONFIGVAL( int32, FakePacketDup_TimeMax, 10, 0, 5000 );
 DEFINE_GLOBAL_CONFIGVAL( int32, EnumerateDevVars, 0, 0, 1 );
+DEFINE_GLOBAL_CONFIGVAL( int32, UDPSendBatchSize, 0, 0, 64 );
+DEFINE_GLOBAL_CONFIGVAL( int32, UDPSendGSO, 0, 0, 1 );
+DEFINE_GLOBAL_CONFIGVAL( int32, UDPRecvGRO, 0, 0, 1 );
+DEFINE_GLOBAL_CONFIGVAL( int32, UDPIOUring, 0, 0, 1 );
+DEFINE_GLOBAL_CONFIGVAL( int32, UDPRecvKernelTimestamps, 0, 0, 1 );
+DEFINE_GLOBAL_CONFIGVAL( int32, ServiceThreadSpinWindow, 0, 0, 1000 );
+DEFINE_GLOBAL_CONFIGVAL( int32, ServiceThreadBusyPoll, 0, 0, 1000000 );
+DEFINE_GLOBAL_CONFIGVAL( int32, UDPSocketBusyPoll, 0, 0, 1000 );
+DEFINE_GLOBAL_CONFIGVAL( std::string, XDP_Interface, "" );
+DEFINE_GLOBAL_CONFIGVAL( int32, XDP_Queue, 0, 0, 63 );
+DEFINE_GLOBAL_CONFIGVAL( int32, UDPRecvBufferMax, 0, 0, 0x10000000 );
+DEFINE_GLOBAL_CONFIGVAL( std::string, ServiceThreadAffinity, "" );
+DEFINE_GLOBAL_CONFIGVAL( int32, ServiceThreadSchedPolicy, 0, 0, 2 );
+DEFINE_GLOBAL_CONFIGVAL( int32, ServiceThreadSchedPriority, 0, 0, 99 );
+DEFINE_GLOBAL_CONFIGVAL( std::string, ServiceThreadName, "SteamNetworking" );
+DEFINE_GLOBAL_CONFIGVAL( int32, TimerSlack, 10000, 0, 1000000 );
+DEFINE_GLOBAL_CONFIGVAL( int32, LockFreeSendQueueSize, 0, 0, 0x10000000 );
+DEFINE_GLOBAL_CONFIGVAL( int32, PollGroupRecvRingSize, 0, 0, 0x100000 );
+DEFINE_GLOBAL_CONFIGVAL( int32, LinkStatsDetail, 0, 0, 2 );
 
 #ifdef STEAMNETWORKINGSOCKETS_ENABLE_STEAMNETWORKINGMESSAGES
 DEFINE_GLOBAL_CONFIGVAL( void*, Callback_MessagesSessionRequest, nullptr );
@@ -64,6 +83,7 @@ DEFINE_CONNECTON_DEFAULT_CONFIGVAL( int32, MTU_PacketSize, 1300, k_cbSteamNetwor
 DEFINE_CONNECTON_DEFAULT_CONFIGVAL( int32, Unencrypted, 0, 0, 3 );
 DEFINE_CONNECTON_DEFAULT_CONFIGVAL( int32, SymmetricConnect, 0, 0, 1 );
 DEFINE_CONNECTON_DEFAULT_CONFIGVAL( int32, LocalVirtualPort, -1, -1, 65535 );
+DEFINE_CONNECTON_DEFAULT_CONFIGVAL( int32, IP_ListenSocketShards, 1, 1, 16 );
 DEFINE_CONNECTON_DEFAULT_CONFIGVAL( int32, LogLevel_AckRTT, k_ESteamNetworkingSocketsDebugOutputType_Warning, k_ESteamNetworkingSocketsDebugOutputType_Error, k_ESteamNetworkingSocketsDebugOutputType_Everything );
 DEFINE_CONNECTON_DEFAULT_CONFIGVAL( int32, LogLevel_PacketDecode, k_ESteamNetworkingSocketsDebugOutputType_Warning, k_ESteamNetworkingSocketsDebugOutputType_Error, k_ESteamNetworkingSocketsDebugOutputType_Everything );
 DEFINE_CONNECTON_DEFAULT_CONFIGVAL( int32, LogLevel_Message, k_ESteamNetworkingSocketsDebugOutputType_Warning, k_ESteamNetworkingSocketsDebugOutputType_Error, k_ESteamNetworkingSocketsDebugOutputType_Everything );
@@ -200,7 +220,8 @@ void ConnectionConfig::Init( ConnectionConfig *pInherit )
 //
 /////////////////////////////////////////////////////////////////////////////
 
-CUtlHashMap<uint16, CSteamNetworkConnectionBase *, std::equal_to<uint16>, Identity<uint16> > g_mapConnections;
+CConnectionHandleTable g_tableConnections;
+CUtlHashMap<uint32, CSteamNetworkConnectionBase *, std::equal_to<uint32>, Identity<uint32> > g_mapConnectionsByLocalID;
 CUtlHashMap<int, CSteamNetworkListenSocketBase *, std::equal_to<int>, Identity<int> > g_mapListenSockets;
 CUtlHashMap<int, CSteamNetworkPollGroup *, std::equal_to<int>, Identity<int> > g_mapPollGroups;
 
@@ -227,25 +248,76 @@ static bool BConnectionStateExistsToAPI( ESteamNetworkingConnectionState eState
 
 }
 
+HSteamNetConnection CConnectionHandleTable::Add( CSteamNetworkConnectionBase *pConn )
+{
+	Assert( pConn );
+	int nSlot;
+	if ( m_nFree >= k_nMinFreeSlotsBeforeReuse || m_vecSlots.Count() >= k_nMaxSlots )
+	{
+		// Reuse the slot that has been free the longest
+		if ( m_nFreeHead < 0 )
+			return k_HSteamNetConnection_Invalid;
+		nSlot = m_nFreeHead;
+		m_nFreeHead = m_vecSlots[ nSlot ].m_nNextFree;
+		if ( m_nFreeHead < 0 )
+			m_nFreeTail = -1;
+		--m_nFree;
+	}
+	else
+	{
+		nSlot = m_vecSlots.AddToTail();
+		m_vecSlots[ nSlot ].m_nGeneration = 1;
+	}
+
+	Slot_t &slot = m_vecSlots[ nSlot ];
+	slot.m_pConn = pConn;
+	slot.m_hConn = HSteamNetConnection( ( slot.m_nGeneration << k_nSlotBits ) | uint32( nSlot ) );
+	slot.m_nNextFree = -1;
+	Assert( slot.m_hConn != k_HSteamNetConnection_Invalid );
+	++m_nCount;
+	return slot.m_hConn;
+}
+
+bool CConnectionHandleTable::Remove( HSteamNetConnection hConn, CSteamNetworkConnectionBase *pConn )
+{
+	if ( !pConn || Find( hConn ) != pConn )
+		return false;
+	int nSlot = int( hConn & k_nSlotMask );
+	Slot_t &slot = m_vecSlots[ nSlot ];
+	slot.m_pConn = nullptr;
+	slot.m_hConn = k_HSteamNetConnection_Invalid;
+
+	// Next occupant gets a new generation, so this handle goes stale
+	slot.m_nGeneration = ( slot.m_nGeneration + 1 ) & ( 0xffffffffu >> k_nSlotBits );
+	if ( slot.m_nGeneration == 0 )
+		slot.m_nGeneration = 1;
+
+	// Put at the back of the free list
+	slot.m_nNextFree = -1;
+	if ( m_nFreeTail >= 0 )
+		m_vecSlots[ m_nFreeTail ].m_nNextFree = nSlot;
+	else
+		m_nFreeHead = nSlot;
+	m_nFreeTail = nSlot;
+	++m_nFree;
+
+	Assert( m_nCount > 0 );
+	--m_nCount;
+	return true;
+}
+
 CSteamNetworkConnectionBase *GetConnectionByHandle( HSteamNetConnection sock )
 {
-	if ( sock == 0 )
-		return nullptr;
-	int idx = g_mapConnections.Find( uint16( sock ) );
-	if ( idx == g_mapConnections.InvalidIndex() )
-		return nullptr;
-	CSteamNetworkConnectionBase *pResult = g_mapConnections[ idx ];
-	if ( !pResult || uint16( pResult->m_hConnectionSelf ) != uint16( sock ) )
+	CSteamNetworkConnectionBase *pResult = g_tableConnections.Find( sock );
+	if ( pResult && pResult->m_hConnectionSelf != sock )
 	{
-		AssertMsg( false, "g_mapConnections corruption!" );
+		AssertMsg( false, "g_tableConnections corruption!" );
 		return nullptr;
 	}
-	if ( pResult->m_hConnectionSelf != sock )
-		return nullptr;
 	return pResult;
 }
 
-static CSteamNetworkConnectionBase *GetConnectionByHandleForAPI( HSteamNetConnection sock )
+static CSteamNetworkConnectionBase *FindConnectionForAPI( HSteamNetConnection sock )
 {
 	CSteamNetworkConnectionBase *pResult = GetConnectionByHandle( sock );
 	if ( !pResult )
@@ -255,6 +327,15 @@ static CSteamNetworkConnectionBase *GetConnectionByHandleForAPI( HSteamNetConnec
 	return pResult;
 }
 
+static CSteamNetworkConnectionBase *GetConnectionByHandleForAPI( HSteamNetConnection sock )
+{
+	// Make sure any messages they sent without the lock are
+	// processed before whatever they are about to do
+	ServiceLockFreeSendQueue();
+
+	return FindConnectionForAPI( sock );
+}
+
 static CSteamNetworkListenSocketBase *GetListenSocketByHandle( HSteamListenSocket sock )
 {
 	if ( sock == k_HSteamListenSocket_Invalid )
@@ -349,6 +430,10 @@ void CSteamNetworkingSockets::KillConnections()
 {
 	SteamDatagramTransportLock::AssertHeldByCurrentThread( "CSteamNetworkingSockets::KillConnections" );
 
+	// Pass on any messages sent without the lock, so they are
+	// handled (and freed) along with everything else
+	ServiceLockFreeSendQueue();
+
 	// First, nuke messages interface, if we had one.
 	#ifdef STEAMNETWORKINGSOCKETS_HAS_DEFAULT_P2P_SIGNALING
 		if ( m_pSteamNetworkingMessages )
@@ -364,13 +449,13 @@ void CSteamNetworkingSockets::KillConnections()
 	#endif
 
 	// Destroy all of my connections
-	FOR_EACH_HASHMAP( g_mapConnections, idx )
+	for ( int nSlot = 0 ; nSlot < g_tableConnections.NumSlots() ; ++nSlot )
 	{
-		CSteamNetworkConnectionBase *pConn = g_mapConnections[idx];
-		if ( pConn->m_pSteamNetworkingSocketsInterface == this )
+		CSteamNetworkConnectionBase *pConn = g_tableConnections.GetAtSlot( nSlot );
+		if ( pConn && pConn->m_pSteamNetworkingSocketsInterface == this )
 		{
 			pConn->ConnectionDestroySelfNow();
-			Assert( !g_mapConnections.IsValidIndex( idx ) );
+			Assert( g_tableConnections.GetAtSlot( nSlot ) == nullptr );
 		}
 	}
 
@@ -427,9 +512,10 @@ void CSteamNetworkingSockets::Destroy()
 
 bool CSteamNetworkingSockets::BHasAnyConnections() const
 {
-	for ( CSteamNetworkConnectionBase *pConn: g_mapConnections.IterValues() )
+	for ( int nSlot = 0 ; nSlot < g_tableConnections.NumSlots() ; ++nSlot )
 	{
-		if ( pConn->m_pSteamNetworkingSocketsInterface == this )
+		CSteamNetworkConnectionBase *pConn = g_tableConnections.GetAtSlot( nSlot );
+		if ( pConn && pConn->m_pSteamNetworkingSocketsInterface == this )
 			return true;
 	}
 	return false;
@@ -765,18 +851,81 @@ bool CSteamNetworkingSockets::GetConnectionName( HSteamNetConnection hPeer, char
 	return true;
 }
 
-EResult CSteamNetworkingSockets::SendMessageToConnection( HSteamNetConnection hConn, const void *pData, uint32 cbData, int nSendFlags, int64 *pOutMessageNumber )
+/////////////////////////////////////////////////////////////////////////////
+//
+// Lock-free send queue.  (See k_ESteamNetworkingConfig_LockFreeSendQueueSize)
+//
+/////////////////////////////////////////////////////////////////////////////
+
+/// Messages sent without taking the lock.  This is a simple lock-free stack,
+/// linked through m_links.m_pNext.  The service thread takes the whole thing
+/// at once, so there's no ABA problem, and reverses it to get the messages
+/// back in the order they were sent.
+static std::atomic<CSteamNetworkingMessage *> s_pLockFreeSendQueue( nullptr );
+
+/// Total size of the messages in s_pLockFreeSendQueue.  This is conservative,
+/// it is incremented before the message is queued, and decremented after it
+/// has been removed.
+static std::atomic<int64> s_cbLockFreeSendQueue( 0 );
+
+/// Results for all messages that have been taken from the queue.  Protected
+/// by the lock
+static SteamNetworkingLockFreeSendStats s_lockFreeSendStats = { 0, 0, 0, k_EResultOK };
+
+/// Results per connection, only for connections that have been sent messages
+/// this way.  These are kept here rather than in the connection, so that
+/// apps that don't use the lock-free queue don't pay for them.  Protected by
+/// the lock
+static CUtlHashMap<HSteamNetConnection, SteamNetworkingLockFreeSendStats, std::equal_to<HSteamNetConnection>, std::hash<HSteamNetConnection> > s_mapLockFreeSendStatsByConnection;
+
+/// Count the result of a message taken from the lock-free queue
+static void AddLockFreeSendResult( SteamNetworkingLockFreeSendStats &stats, int64 result, bool bReliable )
 {
-	SteamDatagramTransportLock scopeLock( "SendMessageToConnection" );
-	CSteamNetworkConnectionBase *pConn = GetConnectionByHandleForAPI( hConn );
-	if ( !pConn )
-		return k_EResultInvalidParam;
-	return pConn->APISendMessageToConnection( pData, cbData, nSendFlags, pOutMessageNumber );
+	++stats.m_nMessages;
+	if ( result < 0 )
+	{
+		++stats.m_nFailed;
+		if ( bReliable )
+			++stats.m_nFailedReliable;
+		stats.m_eLastFailure = EResult( -result );
+	}
 }
 
-void CSteamNetworkingSockets::SendMessages( int nMessages, SteamNetworkingMessage_t *const *pMessages, int64 *pOutMessageNumberOrResult )
+void ForgetLockFreeSendStats( HSteamNetConnection hConn )
+{
+	if ( s_mapLockFreeSendStatsByConnection.Count() > 0 )
+		s_mapLockFreeSendStatsByConnection.Remove( hConn );
+}
+
+/// Queue a message to be sent by the service thread.  Returns 0 or -EResult
+static int64 SendMessageLockFree( CSteamNetworkingMessage *pMsg, int cbMaxQueued )
+{
+	const int64 cbMsg = pMsg->m_cbSize;
+	if ( s_cbLockFreeSendQueue.fetch_add( cbMsg, std::memory_order_relaxed ) + cbMsg > cbMaxQueued )
+	{
+		s_cbLockFreeSendQueue.fetch_sub( cbMsg, std::memory_order_relaxed );
+		pMsg->Release();
+		return -k_EResultLimitExceeded;
+	}
+
+	CSteamNetworkingMessage *pHead = s_pLockFreeSendQueue.load( std::memory_order_relaxed );
+	do
+	{
+		pMsg->m_links.m_pNext = pHead;
+	} while ( !s_pLockFreeSendQueue.compare_exchange_weak( pHead, pMsg, std::memory_order_release, std::memory_order_relaxed ) );
+
+	// If the queue was empty, make sure the service thread knows there's work.
+	// Otherwise, whoever made it non-empty already did that.
+	if ( !pHead )
+		WakeSteamDatagramThread();
+	return 0;
+}
+
+/// Send messages to connections.  We must hold the lock.  If the messages
+/// came from the lock-free queue, we count the results, since there's nobody
+/// waiting for them.
+static void SendMessagesLocked( int nMessages, SteamNetworkingMessage_t *const *pMessages, int64 *pOutMessageNumberOrResult, bool bLockFree = false )
 {
-	SteamDatagramTransportLock scopeLock( "SendMessages" );
 	SteamNetworkingMicroseconds usecNow = SteamNetworkingSockets_GetLocalTimestamp();
 
 	vstd::small_vector<CSteamNetworkConnectionBase *,64 > vecConnectionsToCheck;
@@ -794,18 +943,34 @@ void CSteamNetworkingSockets::SendMessages( int nMessages, SteamNetworkingMessag
 		}
 
 		// Locate connection
-		CSteamNetworkConnectionBase *pConn = GetConnectionByHandleForAPI( pMsg->m_conn );
+		CSteamNetworkConnectionBase *pConn = FindConnectionForAPI( pMsg->m_conn );
 		if ( !pConn )
 		{
 			if ( pOutMessageNumberOrResult )
 				pOutMessageNumberOrResult[i] = -k_EResultInvalidParam;
+			if ( bLockFree )
+				AddLockFreeSendResult( s_lockFreeSendStats, -k_EResultInvalidParam, ( pMsg->m_nFlags & k_nSteamNetworkingSend_Reliable ) != 0 );
 			pMsg->Release();
 			continue;
 		}
 
-		// Attempt to send
+		// Attempt to send.  (Check flags first, the message might be gone after this)
+		const bool bReliable = ( pMsg->m_nFlags & k_nSteamNetworkingSend_Reliable ) != 0;
 		bool bThinkImmediately = false;
 		int64 result = pConn->APISendMessageToConnection( pMsg, usecNow, &bThinkImmediately );
+		if ( bLockFree )
+		{
+			AddLockFreeSendResult( s_lockFreeSendStats, result, bReliable );
+
+			const HSteamNetConnection hConn = pConn->m_hConnectionSelf;
+			int idx = s_mapLockFreeSendStatsByConnection.Find( hConn );
+			if ( idx == s_mapLockFreeSendStatsByConnection.InvalidIndex() )
+			{
+				idx = s_mapLockFreeSendStatsByConnection.Insert( hConn );
+				s_mapLockFreeSendStatsByConnection[ idx ] = SteamNetworkingLockFreeSendStats{ 0, 0, 0, k_EResultOK };
+			}
+			AddLockFreeSendResult( s_mapLockFreeSendStatsByConnection[ idx ], result, bReliable );
+		}
 
 		// Return result for this message if they asked for it
 		if ( pOutMessageNumberOrResult )
@@ -821,6 +986,97 @@ void CSteamNetworkingSockets::SendMessages( int nMessages, SteamNetworkingMessag
 		pConn->CheckConnectionStateAndSetNextThinkTime( usecNow );
 }
 
+void ServiceLockFreeSendQueue()
+{
+	SteamDatagramTransportLock::AssertHeldByCurrentThread();
+
+	// Quick check, since this is called a lot and will usually be empty
+	if ( !s_pLockFreeSendQueue.load( std::memory_order_relaxed ) )
+		return;
+	CSteamNetworkingMessage *pMsg = s_pLockFreeSendQueue.exchange( nullptr, std::memory_order_acquire );
+
+	vstd::small_vector<SteamNetworkingMessage_t *, 64> vecMessages;
+	int64 cbTotal = 0;
+	while ( pMsg )
+	{
+		CSteamNetworkingMessage *pNext = pMsg->m_links.m_pNext;
+		pMsg->m_links.m_pNext = nullptr;
+		cbTotal += pMsg->m_cbSize;
+		vecMessages.push_back( pMsg );
+		pMsg = pNext;
+	}
+	s_cbLockFreeSendQueue.fetch_sub( cbTotal, std::memory_order_relaxed );
+
+	std::reverse( vecMessages.begin(), vecMessages.end() );
+	const int nMessages = (int)vecMessages.size();
+	vstd::small_vector<int64, 64> vecResults;
+	vecResults.resize( nMessages );
+	SendMessagesLocked( nMessages, vecMessages.begin(), vecResults.begin(), true );
+
+	// Nobody to return the results to.  They've been counted, but also make
+	// some noise
+	int nFailed = 0;
+	int64 nFirstError = 0;
+	for ( int64 result: vecResults )
+	{
+		if ( result < 0 )
+		{
+			if ( nFailed++ == 0 )
+				nFirstError = -result;
+		}
+	}
+	if ( nFailed > 0 )
+		SpewWarningRateLimited( SteamNetworkingSockets_GetLocalTimestamp(), "%d of %d messages sent without the lock failed.  First error was %d\n", nFailed, nMessages, (int)nFirstError );
+}
+
+EResult CSteamNetworkingSockets::SendMessageToConnection( HSteamNetConnection hConn, const void *pData, uint32 cbData, int nSendFlags, int64 *pOutMessageNumber )
+{
+	const int cbMaxQueued = g_Config_LockFreeSendQueueSize.Get();
+	if ( cbMaxQueued > 0 )
+	{
+		if ( pOutMessageNumber )
+			*pOutMessageNumber = -1;
+		CSteamNetworkingMessage *pMsg = CSteamNetworkingMessage::New( cbData );
+		if ( !pMsg )
+			return k_EResultFail;
+		memcpy( pMsg->m_pData, pData, cbData );
+		pMsg->m_conn = hConn;
+		pMsg->m_nFlags = nSendFlags;
+		int64 result = SendMessageLockFree( pMsg, cbMaxQueued );
+		if ( result < 0 )
+			return EResult( -result );
+		if ( pOutMessageNumber )
+			*pOutMessageNumber = 0;
+		return k_EResultOK;
+	}
+
+	SteamDatagramTransportLock scopeLock( "SendMessageToConnection" );
+	CSteamNetworkConnectionBase *pConn = GetConnectionByHandleForAPI( hConn );
+	if ( !pConn )
+		return k_EResultInvalidParam;
+	return pConn->APISendMessageToConnection( pData, cbData, nSendFlags, pOutMessageNumber );
+}
+
+void CSteamNetworkingSockets::SendMessages( int nMessages, SteamNetworkingMessage_t *const *pMessages, int64 *pOutMessageNumberOrResult )
+{
+	const int cbMaxQueued = g_Config_LockFreeSendQueueSize.Get();
+	if ( cbMaxQueued > 0 )
+	{
+		for ( int i = 0 ; i < nMessages ; ++i )
+		{
+			CSteamNetworkingMessage *pMsg = static_cast<CSteamNetworkingMessage*>( pMessages[i] );
+			int64 result = pMsg ? SendMessageLockFree( pMsg, cbMaxQueued ) : -k_EResultInvalidParam;
+			if ( pOutMessageNumberOrResult )
+				pOutMessageNumberOrResult[i] = result;
+		}
+		return;
+	}
+
+	SteamDatagramTransportLock scopeLock( "SendMessages" );
+	ServiceLockFreeSendQueue();
+	SendMessagesLocked( nMessages, pMessages, pOutMessageNumberOrResult );
+}
+
 EResult CSteamNetworkingSockets::FlushMessagesOnConnection( HSteamNetConnection hConn )
 {
 	SteamDatagramTransportLock scopeLock( "FlushMessagesOnConnection" );
@@ -844,6 +1100,7 @@ HSteamNetPollGroup CSteamNetworkingSockets::CreatePollGroup()
 	SteamDatagramTransportLock scopeLock( "CreatePollGroup" );
 	CSteamNetworkPollGroup *pPollGroup = new CSteamNetworkPollGroup( this );
 	pPollGroup->AssignHandleAndAddToGlobalTable();
+	pPollGroup->InitRecvRing( g_Config_PollGroupRecvRingSize.Get() );
 	return pPollGroup->m_hPollGroupSelf;
 }
 
@@ -883,6 +1140,11 @@ bool CSteamNetworkingSockets::SetConnectionPollGroup( HSteamNetConnection hConn,
 
 int CSteamNetworkingSockets::ReceiveMessagesOnPollGroup( HSteamNetPollGroup hPollGroup, SteamNetworkingMessage_t **ppOutMessages, int nMaxMessages )
 {
+	// If the poll group has a delivery ring, we usually don't need the lock
+	int nRingMessages = CSteamNetworkPollGroup::ReceiveMessagesFromRecvRing( hPollGroup, ppOutMessages, nMaxMessages );
+	if ( nRingMessages >= 0 )
+		return nRingMessages;
+
 	SteamDatagramTransportLock scopeLock( "ReceiveMessagesOnPollGroup" );
 	CSteamNetworkPollGroup *pPollGroup = GetPollGroupByHandle( hPollGroup );
 	if ( !pPollGroup )
@@ -1676,6 +1938,26 @@ time_t CSteamNetworkingUtils::GetTimeSecure()
 } // namespace SteamNetworkingSocketsLib
 using namespace SteamNetworkingSocketsLib;
 
+STEAMNETWORKINGSOCKETS_INTERFACE bool SteamNetworkingSockets_GetLockFreeSendStats( HSteamNetConnection hConn, SteamNetworkingLockFreeSendStats *pStats )
+{
+	SteamDatagramTransportLock scopeLock( "SteamNetworkingSockets_GetLockFreeSendStats" );
+	if ( hConn == k_HSteamNetConnection_Invalid )
+	{
+		ServiceLockFreeSendQueue();
+		*pStats = s_lockFreeSendStats;
+		return true;
+	}
+	CSteamNetworkConnectionBase *pConn = GetConnectionByHandleForAPI( hConn );
+	if ( !pConn )
+		return false;
+	const SteamNetworkingLockFreeSendStats *pConnStats = s_mapLockFreeSendStatsByConnection.FindGetPtr( hConn );
+	if ( pConnStats )
+		*pStats = *pConnStats;
+	else
+		*pStats = SteamNetworkingLockFreeSendStats{ 0, 0, 0, k_EResultOK };
+	return true;
+}
+
 /////////////////////////////////////////////////////////////////////////////
 //
 // Global API interface
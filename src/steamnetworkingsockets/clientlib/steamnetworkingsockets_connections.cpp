@@ -1,8 +1,10 @@
 //====== Copyright Valve Corporation, All rights reserved. ====================
 
 #include <time.h>
+#include <thread>
 
 #include <steam/isteamnetworkingsockets.h>
+#include <steam/steamnetworkingsockets.h>
 #include "steamnetworkingsockets_connections.h"
 #include "steamnetworkingsockets_lowlevel.h"
 #include "../steamnetworkingsockets_certstore.h"
@@ -22,7 +24,7 @@
 namespace SteamNetworkingSocketsLib {
 
 const int k_nMaxRecentLocalConnectionIDs = 256;
-static CUtlVectorFixed<uint16,k_nMaxRecentLocalConnectionIDs> s_vecRecentLocalConnectionIDs;
+static CUtlVectorFixed<uint32,k_nMaxRecentLocalConnectionIDs> s_vecRecentLocalConnectionIDs;
 
 /// Check if we've sent a "spam reply", meaning a reply to an incoming
 /// message that could be random spoofed garbage.  Returns false if we've
@@ -311,9 +313,35 @@ int SteamNetworkingMessageQueue::RemoveMessages( SteamNetworkingMessage_t **ppOu
 //
 /////////////////////////////////////////////////////////////////////////////
 
+// Poll groups that have a delivery ring, so they can be looked up without the
+// lock.  Indexed by the low 16 bits of the handle (the same index as
+// g_mapPollGroups), so there is a slot for every possible handle.  Pages of
+// the table that are never used are never touched.
+//
+// A lock-free consumer holds a reference on the slot while it touches the
+// poll group, and the poll group waits for those references to go away
+// before it is destroyed.  Consumers never take the lock while holding a
+// reference, so the wait can't deadlock.
+struct PollGroupRecvRingSlot_t
+{
+	std::atomic<CSteamNetworkPollGroup *> m_pPollGroup;
+	std::atomic<int> m_nRefs;
+};
+static PollGroupRecvRingSlot_t s_arPollGroupsWithRecvRing[ 0x10000 ];
+
 CSteamNetworkPollGroup::CSteamNetworkPollGroup( CSteamNetworkingSockets *pInterface )
 : m_pSteamNetworkingSocketsInterface( pInterface )
 , m_hPollGroupSelf( k_HSteamListenSocket_Invalid )
+, m_pRecvRing( nullptr )
+, m_nRecvRingMask( 0 )
+, m_nRecvRingHead( 0 )
+, m_nRecvRingTail( 0 )
+, m_bRecvRingQueueNonEmpty( false )
+, m_bRecvRingConsumerBusy( false )
+, m_nRecvRingMessages( 0 )
+, m_nRecvRingMessagesQueued( 0 )
+, m_nRecvRingFull( 0 )
+, m_nRecvRingMaxDepth( 0 )
 {
 }
 
@@ -349,6 +377,25 @@ CSteamNetworkPollGroup::~CSteamNetworkPollGroup()
 		Assert( pMsg != m_queueRecvMessages.m_pFirst );
 	}
 
+	// Discard anything the app didn't pull out of the ring.  These
+	// are not in any other queue, so we own them.
+	if ( m_pRecvRing )
+	{
+		// Stop lock-free consumers from finding us, and wait for any that
+		// already did to finish with us
+		PollGroupRecvRingSlot_t &slot = s_arPollGroupsWithRecvRing[ m_hPollGroupSelf & 0xffff ];
+		if ( slot.m_pPollGroup.load( std::memory_order_relaxed ) == this )
+			slot.m_pPollGroup.store( nullptr );
+		while ( slot.m_nRefs.load() > 0 )
+			std::this_thread::yield();
+
+		const uint32 nHead = m_nRecvRingHead.load( std::memory_order_relaxed );
+		for ( uint32 nTail = m_nRecvRingTail.load( std::memory_order_acquire ) ; nTail != nHead ; ++nTail )
+			m_pRecvRing[ nTail & m_nRecvRingMask ]->Release();
+		delete[] m_pRecvRing;
+		m_pRecvRing = nullptr;
+	}
+
 	// Remove us from global table, if we're in it
 	if ( m_hPollGroupSelf != k_HSteamNetPollGroup_Invalid )
 	{
@@ -392,6 +439,142 @@ void CSteamNetworkPollGroup::AssignHandleAndAddToGlobalTable()
 	m_hPollGroupSelf = HSteamNetPollGroup( idx | s_nUpperBits | 0x80000000 );
 }
 
+void CSteamNetworkPollGroup::InitRecvRing( int nSlots )
+{
+	Assert( !m_pRecvRing );
+	Assert( m_hPollGroupSelf != k_HSteamNetPollGroup_Invalid );
+	if ( nSlots <= 0 )
+		return;
+
+	// Round up to a power of two, so we can just mask the indices
+	uint32 nSize = 1;
+	while ( nSize < (uint32)nSlots )
+		nSize <<= 1;
+	m_pRecvRing = new CSteamNetworkingMessage *[ nSize ];
+	m_nRecvRingMask = nSize-1;
+
+	// Now lock-free lookups can find us
+	s_arPollGroupsWithRecvRing[ m_hPollGroupSelf & 0xffff ].m_pPollGroup.store( this, std::memory_order_release );
+}
+
+bool CSteamNetworkPollGroup::BPushToRecvRing( CSteamNetworkingMessage *pMsg )
+{
+	if ( !m_pRecvRing )
+		return false;
+	SteamDatagramTransportLock::AssertHeldByCurrentThread();
+
+	// If anything has backed up into the ordinary queue, new messages
+	// have to go in behind it.
+	if ( !m_queueRecvMessages.empty() )
+	{
+		++m_nRecvRingMessagesQueued;
+		return false;
+	}
+
+	// Full?
+	const uint32 nHead = m_nRecvRingHead.load( std::memory_order_relaxed );
+	const uint32 nDepth = nHead - m_nRecvRingTail.load( std::memory_order_acquire );
+	if ( nDepth > m_nRecvRingMask )
+	{
+		++m_nRecvRingFull;
+		++m_nRecvRingMessagesQueued;
+		return false;
+	}
+
+	// Publish it
+	Assert( !pMsg->m_links.m_pQueue && !pMsg->m_linksSecondaryQueue.m_pQueue );
+	m_pRecvRing[ nHead & m_nRecvRingMask ] = pMsg;
+	m_nRecvRingHead.store( nHead+1, std::memory_order_release );
+
+	++m_nRecvRingMessages;
+	m_nRecvRingMaxDepth = std::max( m_nRecvRingMaxDepth, (int)nDepth+1 );
+	return true;
+}
+
+int CSteamNetworkPollGroup::ReceiveMessagesFromRecvRing( HSteamNetPollGroup hPollGroup, SteamNetworkingMessage_t **ppOutMessages, int nMaxMessages )
+{
+	if ( hPollGroup == k_HSteamNetPollGroup_Invalid )
+		return -1;
+
+	// Take a reference on the slot, so the poll group can't be destroyed
+	// while we're looking at it
+	PollGroupRecvRingSlot_t &slot = s_arPollGroupsWithRecvRing[ hPollGroup & 0xffff ];
+	slot.m_nRefs.fetch_add( 1 );
+	CSteamNetworkPollGroup *pPollGroup = slot.m_pPollGroup.load();
+	if ( !pPollGroup || pPollGroup->m_hPollGroupSelf != hPollGroup )
+	{
+		slot.m_nRefs.fetch_sub( 1, std::memory_order_release );
+		return -1;
+	}
+
+	// Only one thread can be draining the ring.  If somebody else
+	// already is, then they will get the messages.
+	if ( pPollGroup->m_bRecvRingConsumerBusy.exchange( true, std::memory_order_acquire ) )
+	{
+		slot.m_nRefs.fetch_sub( 1, std::memory_order_release );
+		return 0;
+	}
+
+	int nMessagesReturned = 0;
+	uint32 nTail = pPollGroup->m_nRecvRingTail.load( std::memory_order_relaxed );
+	const uint32 nHead = pPollGroup->m_nRecvRingHead.load( std::memory_order_acquire );
+	while ( nTail != nHead && nMessagesReturned < nMaxMessages )
+	{
+		ppOutMessages[ nMessagesReturned++ ] = pPollGroup->m_pRecvRing[ nTail & pPollGroup->m_nRecvRingMask ];
+		++nTail;
+	}
+	pPollGroup->m_nRecvRingTail.store( nTail, std::memory_order_release );
+
+	// Did anything back up into the ordinary queue?  Those messages are
+	// all newer than the ones in the ring, so we only get them once the
+	// ring is empty.
+	if ( nMessagesReturned >= nMaxMessages || !pPollGroup->m_bRecvRingQueueNonEmpty.load( std::memory_order_acquire ) )
+	{
+		pPollGroup->m_bRecvRingConsumerBusy.store( false, std::memory_order_release );
+		slot.m_nRefs.fetch_sub( 1, std::memory_order_release );
+		return nMessagesReturned;
+	}
+
+	// We need the lock for that.  Drop our reference first, since whoever
+	// holds the lock might be destroying the poll group and waiting on us.
+	// Once we have the lock, the handle tells us if it's still there.  Check
+	// the ring again, because the producer might have put more in it in the
+	// meantime.
+	slot.m_nRefs.fetch_sub( 1, std::memory_order_release );
+	SteamDatagramTransportLock scopeLock( "ReceiveMessagesOnPollGroup" );
+	pPollGroup = GetPollGroupByHandle( hPollGroup );
+	if ( pPollGroup )
+	{
+		if ( pPollGroup->m_nRecvRingHead.load( std::memory_order_relaxed ) == nTail )
+		{
+			nMessagesReturned += pPollGroup->m_queueRecvMessages.RemoveMessages( ppOutMessages + nMessagesReturned, nMaxMessages - nMessagesReturned );
+			if ( pPollGroup->m_queueRecvMessages.empty() )
+				pPollGroup->m_bRecvRingQueueNonEmpty.store( false, std::memory_order_relaxed );
+		}
+		pPollGroup->m_bRecvRingConsumerBusy.store( false, std::memory_order_release );
+	}
+	return nMessagesReturned;
+}
+
+void CSteamNetworkPollGroup::GetRecvRingStats( SteamNetworkingPollGroupRecvRingStats &stats ) const
+{
+	SteamDatagramTransportLock::AssertHeldByCurrentThread();
+	if ( m_pRecvRing )
+	{
+		stats.m_nRingSize = (int)m_nRecvRingMask + 1;
+		stats.m_nRingDepth = (int)( m_nRecvRingHead.load( std::memory_order_relaxed ) - m_nRecvRingTail.load( std::memory_order_acquire ) );
+	}
+	else
+	{
+		stats.m_nRingSize = 0;
+		stats.m_nRingDepth = 0;
+	}
+	stats.m_nRingMaxDepth = m_nRecvRingMaxDepth;
+	stats.m_nMessagesRing = m_nRecvRingMessages;
+	stats.m_nMessagesQueued = m_nRecvRingMessagesQueued;
+	stats.m_nRingFull = m_nRecvRingFull;
+}
+
 
 /////////////////////////////////////////////////////////////////////////////
 //
@@ -693,20 +876,24 @@ void CSteamNetworkConnectionBase::FreeResources()
 	// Remove from global connection list
 	if ( m_hConnectionSelf != k_HSteamNetConnection_Invalid )
 	{
-		int idx = g_mapConnections.Find( uint16( m_hConnectionSelf ) );
-		if ( idx == g_mapConnections.InvalidIndex() || g_mapConnections[ idx ] != this )
-		{
+		if ( !g_tableConnections.Remove( m_hConnectionSelf, this ) )
 			AssertMsg( false, "Connection list bookeeping corruption" );
-			FOR_EACH_HASHMAP( g_mapConnections, i )
+		ForgetLockFreeSendStats( m_hConnectionSelf );
+
+		int idx = g_mapConnectionsByLocalID.Find( m_unConnectionIDLocal );
+		if ( idx == g_mapConnectionsByLocalID.InvalidIndex() || g_mapConnectionsByLocalID[ idx ] != this )
+		{
+			AssertMsg( false, "Connection ID bookeeping corruption" );
+			FOR_EACH_HASHMAP( g_mapConnectionsByLocalID, i )
 			{
-				if ( g_mapConnections[i] == this )
-					g_mapConnections.RemoveAt( i );
+				if ( g_mapConnectionsByLocalID[i] == this )
+					g_mapConnectionsByLocalID.RemoveAt( i );
 			}
 		}
 		else
 		{
-			g_mapConnections[ idx ] = nullptr; // Just for grins
-			g_mapConnections.RemoveAt( idx );
+			g_mapConnectionsByLocalID[ idx ] = nullptr; // Just for grins
+			g_mapConnectionsByLocalID.RemoveAt( idx );
 		}
 
 		m_hConnectionSelf = k_HSteamNetConnection_Invalid;
@@ -720,11 +907,11 @@ void CSteamNetworkConnectionBase::FreeResources()
 	{
 		// Trim history to max.  If we're really cycling through connections fast, this
 		// history won't be very useful, but that should be an extremely rare edge case,
-		// and the worst thing that happens is that we have a higher chance of reusing
-		// a connection ID that shares the same bottom 16 bits.
+		// and the worst thing that happens is that we have a (tiny) chance of reusing
+		// a recent connection ID.
 		while ( s_vecRecentLocalConnectionIDs.Count() >= k_nMaxRecentLocalConnectionIDs )
 			s_vecRecentLocalConnectionIDs.Remove( 0 );
-		s_vecRecentLocalConnectionIDs.AddToTail( (uint16)m_unConnectionIDLocal );
+		s_vecRecentLocalConnectionIDs.AddToTail( m_unConnectionIDLocal );
 
 		// Clear it, since this function should be idempotent
 		m_unConnectionIDLocal = 0;
@@ -837,6 +1024,10 @@ void CSteamNetworkConnectionBase::SetPollGroup( CSteamNetworkPollGroup *pPollGro
 	m_pPollGroup = pPollGroup;
 	Assert( !m_pPollGroup->m_vecConnections.HasElement( this ) );
 	m_pPollGroup->m_vecConnections.AddToTail( this );
+
+	// Anything we brought with us is waiting in the ordinary queue
+	if ( !m_queueRecvMessages.empty() )
+		m_pPollGroup->NoteMessagesQueuedBehindRecvRing();
 }
 
 bool CSteamNetworkConnectionBase::BInitConnection( SteamNetworkingMicroseconds usecNow, int nOptions, const SteamNetworkingConfigValue_t *pOptions, SteamDatagramErrMsg &errMsg )
@@ -847,16 +1038,16 @@ bool CSteamNetworkConnectionBase::BInitConnection( SteamNetworkingMicroseconds u
 	// Make sure MTU values are initialized
 	UpdateMTUFromConfig();
 
-	// We make sure the lower 16 bits are unique.  Make sure we don't have too many connections.
-	// This definitely could be relaxed, but honestly we don't expect this library to be used in situations
-	// where you need that many connections.
-	if ( g_mapConnections.Count() >= 0x1fff )
+	// Make sure we don't have too many connections
+	if ( g_tableConnections.Count() >= CConnectionHandleTable::k_nMaxSlots )
 	{
 		V_strcpy_safe( errMsg, "Too many connections." );
 		return false;
 	}
 
-	// Select random connection ID, and make sure it passes certain sanity checks
+	// Select random connection ID, and make sure it passes certain sanity checks.
+	// It only has to be unique as a whole, not in any particular bits, so
+	// it's very rare to need more than one try, even with lots of connections.
 	Assert( m_unConnectionIDLocal == 0 );
 	int tries = 0;
 	for (;;) {
@@ -874,11 +1065,11 @@ bool CSteamNetworkConnectionBase::BInitConnection( SteamNetworkingMicroseconds u
 			continue;
 
 		// Check recent connections
-		if ( s_vecRecentLocalConnectionIDs.HasElement( (uint16)m_unConnectionIDLocal ) )
+		if ( s_vecRecentLocalConnectionIDs.HasElement( m_unConnectionIDLocal ) )
 			continue;
 
 		// Check active connections
-		if ( g_mapConnections.HasElement( (uint16)m_unConnectionIDLocal ) )
+		if ( g_mapConnectionsByLocalID.HasElement( m_unConnectionIDLocal ) )
 			continue;
 
 		// This one's good
@@ -903,16 +1094,17 @@ bool CSteamNetworkConnectionBase::BInitConnection( SteamNetworkingMicroseconds u
 	m_szEndDebug[0] = '\0';
 	m_statsEndToEnd.Init( usecNow, true ); // Until we go connected don't try to send acks, etc
 
-	// Let's use the the connection ID as the connection handle.  It's random, not reused
-	// within a short time interval, and we print it in our debugging in places, and you
-	// can see it on the wire for debugging.  In the past we has a "clever" method of
-	// assigning the handle that had some cute performance tricks for lookups and
-	// guaranteeing handles wouldn't be reused.  But making it be the same as the
-	// ConnectionID is probably just more useful and less confusing.
-	m_hConnectionSelf = m_unConnectionIDLocal;
-
-	// Add it to our table of active sockets.
-	g_mapConnections.Insert( int16( m_hConnectionSelf ), this );
+	// Add it to our table of active sockets, which assigns the handle.  The handle
+	// is not the same as the connection ID, so that lookups by handle can just
+	// index an array, and we are not limited in how many connections we can have
+	// by needing some bits of the connection ID to be unique.
+	m_hConnectionSelf = g_tableConnections.Add( this );
+	if ( m_hConnectionSelf == k_HSteamNetConnection_Invalid )
+	{
+		V_strcpy_safe( errMsg, "Too many connections." );
+		return false;
+	}
+	g_mapConnectionsByLocalID.Insert( m_unConnectionIDLocal, this );
 
 	// Set options, if any
 	if ( pOptions )
@@ -1764,6 +1956,9 @@ void CSteamNetworkConnectionBase::APIGetDetailedConnectionStatus( SteamNetworkin
 	stats.Clear();
 	ConnectionPopulateInfo( stats.m_info );
 
+	// Somebody is interested in the details, so start collecting percentiles
+	m_statsEndToEnd.EnsurePercentileSamples();
+
 	// Copy end-to-end stats
 	m_statsEndToEnd.GetLinkStats( stats.m_statsEndToEnd, usecNow );
 
@@ -2389,12 +2584,20 @@ void CSteamNetworkConnectionBase::ReceivedMessage( CSteamNetworkingMessage *pMsg
 		(long long)pMsg->m_nMessageNumber,
 		pMsg->m_cbSize );
 
+	// If our poll group has a delivery ring, and there's room, the
+	// app will pick it up from there without taking the lock
+	if ( m_pPollGroup && m_pPollGroup->BPushToRecvRing( pMsg ) )
+		return;
+
 	// Add to end of my queue.
 	pMsg->LinkToQueueTail( &CSteamNetworkingMessage::m_links, &m_queueRecvMessages );
 
 	// Add to the poll group, if we are in one
 	if ( m_pPollGroup )
+	{
 		pMsg->LinkToQueueTail( &CSteamNetworkingMessage::m_linksSecondaryQueue, &m_pPollGroup->m_queueRecvMessages );
+		m_pPollGroup->NoteMessagesQueuedBehindRecvRing();
+	}
 }
 
 void CSteamNetworkConnectionBase::PostConnectionStateChangedCallback( ESteamNetworkingConnectionState eOldAPIState, ESteamNetworkingConnectionState eNewAPIState )
@@ -2693,11 +2896,17 @@ void CSteamNetworkConnectionBase::Think( SteamNetworkingMicroseconds usecNow )
 
 void CSteamNetworkConnectionBase::CheckConnectionStateAndSetNextThinkTime( SteamNetworkingMicroseconds usecNow )
 {
+	// Non-urgent stuff (periodic checks, keepalives, stats) can happen a bit
+	// late, so that we can share a wakeup with other connections.  Keep track of
+	// the latest time we can think and still have everything done on time.
+	const SteamNetworkingMicroseconds usecSlack = g_Config_TimerSlack.Get();
+
 	// Assume a default think interval just to make sure we check in periodically
 	SteamNetworkingMicroseconds usecMinNextThinkTime = usecNow + k_nMillion;
+	SteamNetworkingMicroseconds usecLatestNextThinkTime = usecMinNextThinkTime + usecSlack;
 
 	// Use a macro so that if we assert, we'll get a real line number
-	#define UpdateMinThinkTime(x) \
+	#define UpdateMinThinkTimeWithSlack(x, slack) \
 	{ \
 		/* assign into temporary in case x is an expression with side effects */ \
 		SteamNetworkingMicroseconds usecNextThink = (x);  \
@@ -2709,7 +2918,10 @@ void CSteamNetworkConnectionBase::CheckConnectionStateAndSetNextThinkTime( Steam
 		} \
 		if ( usecNextThink < usecMinNextThinkTime ) \
 			usecMinNextThinkTime = usecNextThink; \
+		if ( usecNextThink < usecLatestNextThinkTime - (slack) ) \
+			usecLatestNextThinkTime = usecNextThink + (slack); \
 	}
+	#define UpdateMinThinkTime(x) UpdateMinThinkTimeWithSlack( x, 0 )
 
 	// Check our state
 	switch ( m_eConnectionState )
@@ -2915,7 +3127,7 @@ void CSteamNetworkConnectionBase::CheckConnectionStateAndSetNextThinkTime( Steam
 			}
 
 			// Make sure we are waking up regularly to check in while this is going on
-			UpdateMinThinkTime( usecNow + 50*1000 );
+			UpdateMinThinkTimeWithSlack( usecNow + 50*1000, usecSlack );
 		}
 
 		// Check for sending keepalives and stats
@@ -2945,7 +3157,7 @@ void CSteamNetworkConnectionBase::CheckConnectionStateAndSetNextThinkTime( Steam
 			}
 
 			// Make sure we are scheduled to wake up the next time we need to take action
-			UpdateMinThinkTime( usecStatsNextThinkTime );
+			UpdateMinThinkTimeWithSlack( usecStatsNextThinkTime, usecSlack );
 		}
 	}
 
@@ -2954,9 +3166,10 @@ void CSteamNetworkConnectionBase::CheckConnectionStateAndSetNextThinkTime( Steam
 
 	// Schedule next time to think, if derived class didn't request an earlier
 	// wakeup call.
-	EnsureMinThinkTime( usecMinNextThinkTime );
+	EnsureMinThinkTime( usecMinNextThinkTime, usecLatestNextThinkTime - usecMinNextThinkTime );
 
 	#undef UpdateMinThinkTime
+	#undef UpdateMinThinkTimeWithSlack
 }
 
 void CSteamNetworkConnectionBase::ThinkConnection( SteamNetworkingMicroseconds usecNow )
@@ -3471,3 +3684,15 @@ void CSteamNetworkConnectionPipe::DestroyTransport()
 }
 
 } // namespace SteamNetworkingSocketsLib
+
+using namespace SteamNetworkingSocketsLib;
+
+STEAMNETWORKINGSOCKETS_INTERFACE bool SteamNetworkingSockets_GetPollGroupRecvRingStats( HSteamNetPollGroup hPollGroup, SteamNetworkingPollGroupRecvRingStats *pStats )
+{
+	SteamDatagramTransportLock scopeLock( "SteamNetworkingSockets_GetPollGroupRecvRingStats" );
+	CSteamNetworkPollGroup *pPollGroup = GetPollGroupByHandle( hPollGroup );
+	if ( !pPollGroup )
+		return false;
+	pPollGroup->GetRecvRingStats( *pStats );
+	return true;
+}
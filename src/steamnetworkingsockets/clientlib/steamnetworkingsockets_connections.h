@@ -23,6 +23,7 @@
 #include "steamnetworkingsockets_snp.h"
 
 struct SteamNetConnectionStatusChangedCallback_t;
+struct SteamNetworkingPollGroupRecvRingStats;
 class ISteamNetworkingSocketsSerialized;
 
 namespace SteamNetworkingSocketsLib {
@@ -103,6 +104,11 @@ struct RecvPacketContext_t
 	/// Current time
 	SteamNetworkingMicroseconds m_usecNow;
 
+	/// When the packet arrived.  Used for ping and jitter measurement, so
+	/// that time we spent getting around to processing it doesn't count.
+	/// If the transport doesn't know any better, this is m_usecNow
+	SteamNetworkingMicroseconds m_usecRecvTime;
+
 	/// What transport is receiving this packet?
 	CConnectionTransport *m_pTransport;
 
@@ -208,6 +214,54 @@ public:
 	CUtlVector<CSteamNetworkConnectionBase *> m_vecConnections;
 
 	void AssignHandleAndAddToGlobalTable();
+
+	//
+	// Lock-free delivery ring.  (See k_ESteamNetworkingConfig_PollGroupRecvRingSize.)
+	// The producer is whoever is delivering a message, which always holds the
+	// lock.  The consumer is ReceiveMessagesOnPollGroup, which does not.
+	// Messages in the ring are not linked into any queue.  If the ring fills up,
+	// messages go into the ordinary queues, and keep going there until the app
+	// has drained them, so that the ordering is preserved.
+	//
+
+	/// Allocate the ring, and make it visible to lock-free lookups.  Called
+	/// once, after the handle is assigned.
+	void InitRecvRing( int nSlots );
+
+	/// Try to put the message in the ring.  Returns false if we don't have one,
+	/// or the message must go into the ordinary queues instead.  Lock must be held.
+	bool BPushToRecvRing( CSteamNetworkingMessage *pMsg );
+
+	/// Note that messages may have been linked into m_queueRecvMessages, and
+	/// the consumer needs to take the lock to get them.
+	inline void NoteMessagesQueuedBehindRecvRing()
+	{
+		if ( m_pRecvRing )
+			m_bRecvRingQueueNonEmpty.store( true, std::memory_order_release );
+	}
+
+	/// Pull messages out of the poll group's ring, and then out of the
+	/// ordinary queue if anything backed up there.  Does not need the lock,
+	/// and is safe against the poll group being destroyed at the same time.
+	/// Returns -1 if the handle is bad or the poll group doesn't have a
+	/// ring, and the caller should use the ordinary queue.
+	static int ReceiveMessagesFromRecvRing( HSteamNetPollGroup hPollGroup, SteamNetworkingMessage_t **ppOutMessages, int nMaxMessages );
+
+	/// Fill in stats.  Lock must be held
+	void GetRecvRingStats( SteamNetworkingPollGroupRecvRingStats &stats ) const;
+
+	CSteamNetworkingMessage **m_pRecvRing;
+	uint32 m_nRecvRingMask;
+	std::atomic<uint32> m_nRecvRingHead; // Next slot the producer will write
+	std::atomic<uint32> m_nRecvRingTail; // Next slot the consumer will read
+	std::atomic<bool> m_bRecvRingQueueNonEmpty;
+	std::atomic<bool> m_bRecvRingConsumerBusy;
+
+	// Stats.  Only touched with the lock held
+	int64 m_nRecvRingMessages;
+	int64 m_nRecvRingMessagesQueued;
+	int64 m_nRecvRingFull;
+	int m_nRecvRingMaxDepth;
 };
 
 /////////////////////////////////////////////////////////////////////////////
@@ -905,7 +959,70 @@ inline void SendPacketContext<TStatsMsg>::CalcMaxEncryptedPayloadSize( size_t cb
 //
 /////////////////////////////////////////////////////////////////////////////
 
-extern CUtlHashMap<uint16, CSteamNetworkConnectionBase *, std::equal_to<uint16>, Identity<uint16> > g_mapConnections;
+/// Table of all connections, indexed by API handle.  The bottom bits of a
+/// handle are the slot index, and the top bits are a generation number that
+/// changes each time the slot is reused.  So lookup is just an array index,
+/// and a handle to a connection that has been destroyed won't find whatever
+/// is in the slot now.  (The connection ID we put on the wire is a separate
+/// random number.  See FindConnectionByLocalID.)
+class CConnectionHandleTable
+{
+public:
+	static const int k_nSlotBits = 20;
+	static const uint32 k_nSlotMask = ( 1u << k_nSlotBits ) - 1;
+	static const int k_nMaxSlots = (int)k_nSlotMask + 1;
+
+	/// Freed slots are not reused until at least this many are free, so
+	/// that the same handle doesn't come back any time soon.
+	static const int k_nMinFreeSlotsBeforeReuse = 256;
+
+	/// Add a connection and return its handle.  Returns k_HSteamNetConnection_Invalid
+	/// if the table is full
+	HSteamNetConnection Add( CSteamNetworkConnectionBase *pConn );
+
+	/// Remove a connection.  Returns false if it isn't there under that handle
+	bool Remove( HSteamNetConnection hConn, CSteamNetworkConnectionBase *pConn );
+
+	/// Locate a connection by handle.  Returns nullptr if the handle is stale
+	/// or invalid
+	inline CSteamNetworkConnectionBase *Find( HSteamNetConnection hConn ) const
+	{
+		uint32 nSlot = hConn & k_nSlotMask;
+		if ( nSlot >= (uint32)m_vecSlots.Count() )
+			return nullptr;
+		const Slot_t &slot = m_vecSlots[ nSlot ];
+		if ( slot.m_hConn != hConn )
+			return nullptr;
+		return slot.m_pConn; // nullptr if the slot is free
+	}
+
+	inline int Count() const { return m_nCount; }
+
+	/// For iteration.  Free slots return nullptr.  It's OK to remove the
+	/// connection in the current slot while iterating.
+	inline int NumSlots() const { return m_vecSlots.Count(); }
+	inline CSteamNetworkConnectionBase *GetAtSlot( int nSlot ) const { return m_vecSlots[ nSlot ].m_pConn; }
+
+private:
+	struct Slot_t
+	{
+		CSteamNetworkConnectionBase *m_pConn;
+		HSteamNetConnection m_hConn; // Handle of the current occupant, or k_HSteamNetConnection_Invalid
+		uint32 m_nGeneration; // Generation of the next occupant.  Never 0, so handles are never 0
+		int m_nNextFree;
+	};
+	CUtlVector<Slot_t> m_vecSlots;
+
+	// Free slots, oldest first
+	int m_nFreeHead = -1;
+	int m_nFreeTail = -1;
+	int m_nFree = 0;
+
+	int m_nCount = 0;
+};
+
+extern CConnectionHandleTable g_tableConnections;
+extern CUtlHashMap<uint32, CSteamNetworkConnectionBase *, std::equal_to<uint32>, Identity<uint32> > g_mapConnectionsByLocalID;
 extern CUtlHashMap<int, CSteamNetworkListenSocketBase *, std::equal_to<int>, Identity<int> > g_mapListenSockets;
 extern CUtlHashMap<int, CSteamNetworkPollGroup *, std::equal_to<int>, Identity<int> > g_mapPollGroups;
 
@@ -913,11 +1030,18 @@ extern bool BCheckGlobalSpamReplyRateLimit( SteamNetworkingMicroseconds usecNow
 extern CSteamNetworkConnectionBase *GetConnectionByHandle( HSteamNetConnection sock );
 extern CSteamNetworkPollGroup *GetPollGroupByHandle( HSteamNetPollGroup hPollGroup );
 
+/// Discard results for messages sent to a connection without the lock, when
+/// the connection is destroyed.  (See SteamNetworkingSockets_GetLockFreeSendStats)
+extern void ForgetLockFreeSendStats( HSteamNetConnection hConn );
+
+/// Locate a connection by the connection ID that we put on the wire.  (This is
+/// not the same as the API handle.)
 inline CSteamNetworkConnectionBase *FindConnectionByLocalID( uint32 nLocalConnectionID )
 {
-	// We use the wire connection ID as the API handle, so these two operations
-	// are currently the same.
-	return GetConnectionByHandle( HSteamNetConnection( nLocalConnectionID ) );
+	int idx = g_mapConnectionsByLocalID.Find( nLocalConnectionID );
+	if ( idx == g_mapConnectionsByLocalID.InvalidIndex() )
+		return nullptr;
+	return g_mapConnectionsByLocalID[ idx ];
 }
 
 } // namespace SteamNetworkingSocketsLib
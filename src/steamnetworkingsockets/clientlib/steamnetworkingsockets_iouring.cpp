@@ -0,0 +1,271 @@
+//====== Copyright Valve Corporation, All rights reserved. ====================
+
+#include "steamnetworkingsockets_iouring.h"
+
+#ifdef STEAMNETWORKINGSOCKETS_IOURING
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+
+// memdbgon must be the last include file in a .cpp file!!!
+#include "tier0/memdbgon.h"
+
+namespace SteamNetworkingSocketsLib {
+
+static int sys_io_uring_setup( unsigned nEntries, io_uring_params *pParams )
+{
+	return (int)syscall( __NR_io_uring_setup, nEntries, pParams );
+}
+
+static int sys_io_uring_enter( int fd, unsigned nToSubmit, unsigned nMinComplete, unsigned nFlags, const void *pArg, size_t cbArg )
+{
+	return (int)syscall( __NR_io_uring_enter, fd, nToSubmit, nMinComplete, nFlags, pArg, cbArg );
+}
+
+static int sys_io_uring_register( int fd, unsigned nOpcode, const void *pArg, unsigned nArgs )
+{
+	return (int)syscall( __NR_io_uring_register, fd, nOpcode, pArg, nArgs );
+}
+
+bool CIOUring::BInit( unsigned nSQEntries, unsigned nCQEntries, SteamDatagramErrMsg &errMsg )
+{
+	Assert( m_fd < 0 );
+
+	io_uring_params params;
+	memset( &params, 0, sizeof(params) );
+	params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_SUBMIT_ALL;
+	params.cq_entries = nCQEntries;
+	m_fd = sys_io_uring_setup( nSQEntries, &params );
+	if ( m_fd < 0 )
+	{
+		V_sprintf_safe( errMsg, "io_uring_setup failed.  Error code %d.", errno );
+		return false;
+	}
+
+	// Make sure the kernel has the features we rely on.  We need to be able
+	// to wait with a timeout, and we assume the rings are mapped together.
+	const unsigned nRequiredFeatures = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG;
+	if ( ( params.features & nRequiredFeatures ) != nRequiredFeatures )
+	{
+		V_sprintf_safe( errMsg, "io_uring is missing required features.  (Features 0x%x.)", params.features );
+		Kill();
+		return false;
+	}
+
+	// Map the rings.  With IORING_FEAT_SINGLE_MMAP, one mapping covers both
+	m_cbSQRingMem = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	m_cbCQRingMem = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+	m_cbSQRingMem = std::max( m_cbSQRingMem, m_cbCQRingMem );
+	m_pSQRingMem = mmap( nullptr, m_cbSQRingMem, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQ_RING );
+	if ( m_pSQRingMem == MAP_FAILED )
+	{
+		m_pSQRingMem = nullptr;
+		V_sprintf_safe( errMsg, "mmap of io_uring rings failed.  Error code %d.", errno );
+		Kill();
+		return false;
+	}
+	m_pCQRingMem = m_pSQRingMem;
+	m_cbCQRingMem = 0; // Not mapped separately
+
+	m_cbSQEs = params.sq_entries * sizeof(io_uring_sqe);
+	void *pSQEs = mmap( nullptr, m_cbSQEs, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQES );
+	if ( pSQEs == MAP_FAILED )
+	{
+		V_sprintf_safe( errMsg, "mmap of io_uring SQEs failed.  Error code %d.", errno );
+		Kill();
+		return false;
+	}
+	m_pSQEs = (io_uring_sqe *)pSQEs;
+
+	char *pSQ = (char *)m_pSQRingMem;
+	m_pSQHead = (unsigned *)( pSQ + params.sq_off.head );
+	m_pSQTail = (unsigned *)( pSQ + params.sq_off.tail );
+	m_nSQMask = *(unsigned *)( pSQ + params.sq_off.ring_mask );
+	m_nSQEntries = params.sq_entries;
+	m_nSQTailLocal = m_nSQTailSubmitted = *m_pSQTail;
+
+	// We always fill in SQEs in order, so the index array is just the identity
+	unsigned *pSQArray = (unsigned *)( pSQ + params.sq_off.array );
+	for ( unsigned i = 0 ; i < params.sq_entries ; ++i )
+		pSQArray[i] = i;
+
+	char *pCQ = (char *)m_pCQRingMem;
+	m_pCQHead = (unsigned *)( pCQ + params.cq_off.head );
+	m_pCQTail = (unsigned *)( pCQ + params.cq_off.tail );
+	m_nCQMask = *(unsigned *)( pCQ + params.cq_off.ring_mask );
+	m_pCQEs = (io_uring_cqe *)( pCQ + params.cq_off.cqes );
+
+	return true;
+}
+
+bool CIOUring::BInitBufferRing( uint16 nBufferGroupID, int nEntries, int cbBuffer, SteamDatagramErrMsg &errMsg )
+{
+	Assert( IsValid() );
+	Assert( m_pBufRing == nullptr );
+	Assert( nEntries > 0 && ( nEntries & (nEntries-1) ) == 0 );
+
+	// The ring itself must be page aligned.  The buffers don't need to be,
+	// but we might as well get them the same way, so we don't commit memory
+	// we don't use.
+	m_cbBufRing = nEntries * sizeof(io_uring_buf);
+	void *pRing = mmap( nullptr, m_cbBufRing, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+	if ( pRing == MAP_FAILED )
+	{
+		V_sprintf_safe( errMsg, "mmap of buffer ring failed.  Error code %d.", errno );
+		return false;
+	}
+	m_pBufRing = (io_uring_buf_ring *)pRing;
+
+	size_t cbBuffers = (size_t)nEntries * cbBuffer;
+	void *pBuffers = mmap( nullptr, cbBuffers, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+	if ( pBuffers == MAP_FAILED )
+	{
+		V_sprintf_safe( errMsg, "mmap of receive buffers failed.  Error code %d.", errno );
+		munmap( m_pBufRing, m_cbBufRing );
+		m_pBufRing = nullptr;
+		return false;
+	}
+	m_pBuffers = (char *)pBuffers;
+	m_cbBuffer = cbBuffer;
+	m_nBufRingEntries = nEntries;
+
+	io_uring_buf_reg reg;
+	memset( &reg, 0, sizeof(reg) );
+	reg.ring_addr = (uint64)(uintptr_t)m_pBufRing;
+	reg.ring_entries = nEntries;
+	reg.bgid = nBufferGroupID;
+	if ( sys_io_uring_register( m_fd, IORING_REGISTER_PBUF_RING, &reg, 1 ) != 0 )
+	{
+		V_sprintf_safe( errMsg, "IORING_REGISTER_PBUF_RING failed.  Error code %d.", errno );
+		munmap( m_pBuffers, cbBuffers );
+		m_pBuffers = nullptr;
+		munmap( m_pBufRing, m_cbBufRing );
+		m_pBufRing = nullptr;
+		return false;
+	}
+
+	// Give all the buffers to the kernel
+	m_nBufRingTail = 0;
+	for ( int i = 0 ; i < nEntries ; ++i )
+		RecycleBuffer( i );
+
+	return true;
+}
+
+void CIOUring::RecycleBuffer( int nBufferID )
+{
+	Assert( m_pBufRing );
+	Assert( nBufferID >= 0 && nBufferID < m_nBufRingEntries );
+
+	// NOTE: Don't use m_pBufRing->bufs.  In C++, the flexible array macro
+	// in the kernel header puts it at the wrong offset.  The entries start
+	// at the beginning of the ring, overlapping the header.
+	io_uring_buf *pBufs = (io_uring_buf *)(void *)m_pBufRing;
+	io_uring_buf &buf = pBufs[ m_nBufRingTail & ( m_nBufRingEntries-1 ) ];
+	buf.addr = (uint64)(uintptr_t)GetBuffer( nBufferID );
+	buf.len = m_cbBuffer;
+	buf.bid = (uint16)nBufferID;
+	++m_nBufRingTail;
+
+	// Publish.  Note that the tail overlaps the first entry, so it must
+	// be written after the entry.
+	__atomic_store_n( &m_pBufRing->tail, m_nBufRingTail, __ATOMIC_RELEASE );
+}
+
+void CIOUring::Kill()
+{
+	// Closing the ring cancels anything outstanding
+	if ( m_fd >= 0 )
+	{
+		close( m_fd );
+		m_fd = -1;
+	}
+
+	if ( m_pSQEs )
+	{
+		munmap( m_pSQEs, m_cbSQEs );
+		m_pSQEs = nullptr;
+	}
+	if ( m_pSQRingMem )
+	{
+		munmap( m_pSQRingMem, m_cbSQRingMem );
+		m_pSQRingMem = nullptr;
+	}
+	m_pCQRingMem = nullptr;
+	m_pSQHead = m_pSQTail = m_pCQHead = m_pCQTail = nullptr;
+	m_pCQEs = nullptr;
+	m_nSQTailLocal = m_nSQTailSubmitted = 0;
+
+	if ( m_pBuffers )
+	{
+		munmap( m_pBuffers, (size_t)m_nBufRingEntries * m_cbBuffer );
+		m_pBuffers = nullptr;
+	}
+	if ( m_pBufRing )
+	{
+		munmap( m_pBufRing, m_cbBufRing );
+		m_pBufRing = nullptr;
+	}
+	m_nBufRingEntries = 0;
+}
+
+io_uring_sqe *CIOUring::GetSQE()
+{
+	Assert( IsValid() );
+	unsigned nHead = __atomic_load_n( m_pSQHead, __ATOMIC_ACQUIRE );
+	if ( m_nSQTailLocal - nHead >= m_nSQEntries )
+		return nullptr;
+	io_uring_sqe *sqe = &m_pSQEs[ m_nSQTailLocal & m_nSQMask ];
+	++m_nSQTailLocal;
+	memset( sqe, 0, sizeof(*sqe) );
+	return sqe;
+}
+
+int CIOUring::Submit()
+{
+	Assert( IsValid() );
+	unsigned nToSubmit = m_nSQTailLocal - m_nSQTailSubmitted;
+	if ( nToSubmit == 0 )
+		return 0;
+
+	__atomic_store_n( m_pSQTail, m_nSQTailLocal, __ATOMIC_RELEASE );
+	m_nSQTailSubmitted = m_nSQTailLocal;
+
+	int r;
+	do
+	{
+		r = sys_io_uring_enter( m_fd, nToSubmit, 0, 0, nullptr, 0 );
+	} while ( r < 0 && errno == EINTR );
+	return r < 0 ? -errno : r;
+}
+
+void CIOUring::WaitForCompletion( SteamNetworkingMicroseconds usecTimeout )
+{
+	Assert( IsValid() );
+
+	// Anything already waiting?  This is racy if another thread is reaping,
+	// but the worst that can happen is that we don't sleep.
+	if ( __atomic_load_n( m_pCQHead, __ATOMIC_RELAXED ) != __atomic_load_n( m_pCQTail, __ATOMIC_ACQUIRE ) )
+		return;
+
+	__kernel_timespec ts;
+	usecTimeout = std::max( usecTimeout, (SteamNetworkingMicroseconds)0 );
+	ts.tv_sec = usecTimeout / k_nMillion;
+	ts.tv_nsec = ( usecTimeout % k_nMillion ) * 1000;
+
+	io_uring_getevents_arg arg;
+	memset( &arg, 0, sizeof(arg) );
+	arg.sigmask_sz = _NSIG / 8;
+	arg.ts = (uint64)(uintptr_t)&ts;
+
+	// Returns -ETIME on timeout, or -EINTR.  Either way, the caller will
+	// just look at the completion queue.
+	sys_io_uring_enter( m_fd, 0, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg) );
+}
+
+} // namespace SteamNetworkingSocketsLib
+
+#endif // #ifdef STEAMNETWORKINGSOCKETS_IOURING
@@ -0,0 +1,126 @@
+//====== Copyright Valve Corporation, All rights reserved. ====================
+//
+// Minimal wrapper around a Linux io_uring instance, talking to the kernel
+// directly through the system calls.  (We don't depend on liburing.)  This
+// only does what the raw UDP socket layer needs: submission and completion
+// queues, waiting with a timeout, and a ring of provided receive buffers.
+//
+//=============================================================================
+
+#ifndef STEAMNETWORKINGSOCKETS_IOURING_H
+#define STEAMNETWORKINGSOCKETS_IOURING_H
+#ifdef _WIN32
+#pragma once
+#endif
+
+#include "../steamnetworkingsockets_internal.h"
+
+// Only available on Linux, and only if the kernel headers we are building
+// against are new enough to know about multishot recvmsg and buffer rings.
+// Whether the kernel we are actually running on supports it is checked at runtime.
+#if defined( LINUX ) && defined( __has_include )
+	#if __has_include( <linux/io_uring.h> )
+		#include <linux/io_uring.h>
+		#if defined( IORING_RECV_MULTISHOT ) && defined( IORING_ENTER_EXT_ARG ) && defined( IORING_POLL_ADD_MULTI )
+			#define STEAMNETWORKINGSOCKETS_IOURING
+		#endif
+	#endif
+#endif
+
+#ifdef STEAMNETWORKINGSOCKETS_IOURING
+
+namespace SteamNetworkingSocketsLib {
+
+class CIOUring
+{
+public:
+	CIOUring() {}
+	~CIOUring() { Kill(); }
+
+	/// Create the ring.  Returns false if the kernel doesn't support the
+	/// features we need, in which case the caller should fall back to
+	/// ordinary system calls.
+	bool BInit( unsigned nSQEntries, unsigned nCQEntries, SteamDatagramErrMsg &errMsg );
+
+	/// Register a ring of nEntries receive buffers, each cbBuffer bytes, in
+	/// the specified buffer group.  nEntries must be a power of two.
+	bool BInitBufferRing( uint16 nBufferGroupID, int nEntries, int cbBuffer, SteamDatagramErrMsg &errMsg );
+
+	/// Tear everything down.  Any requests still outstanding are cancelled.
+	void Kill();
+
+	inline bool IsValid() const { return m_fd >= 0; }
+
+	/// Get the next free submission queue entry, cleared.  Returns nullptr
+	/// if the submission queue is full.  (Call Submit and try again.)
+	io_uring_sqe *GetSQE();
+
+	/// Number of SQEs we have filled in, but not yet handed to the kernel.
+	inline int NumPendingSubmit() const { return (int)( m_nSQTailLocal - m_nSQTailSubmitted ); }
+
+	/// Hand any pending SQEs to the kernel.  Returns number submitted, or -errno
+	int Submit();
+
+	/// Block until at least one completion is available, or the timeout
+	/// expires.  This does not touch the queues, so it can be called
+	/// without holding the lock that protects them.
+	void WaitForCompletion( SteamNetworkingMicroseconds usecTimeout );
+
+	/// Peek at the next completion.  Returns nullptr if the queue is empty.
+	inline io_uring_cqe *PeekCQE()
+	{
+		unsigned nHead = *m_pCQHead;
+		if ( nHead == __atomic_load_n( m_pCQTail, __ATOMIC_ACQUIRE ) )
+			return nullptr;
+		return &m_pCQEs[ nHead & m_nCQMask ];
+	}
+
+	/// Mark the completion returned by PeekCQE as consumed
+	inline void AdvanceCQ()
+	{
+		__atomic_store_n( m_pCQHead, *m_pCQHead + 1, __ATOMIC_RELEASE );
+	}
+
+	/// Access a provided receive buffer by ID, and give it back to the kernel
+	/// once we are done with it.
+	inline char *GetBuffer( int nBufferID ) const { return m_pBuffers + (size_t)nBufferID * m_cbBuffer; }
+	void RecycleBuffer( int nBufferID );
+	inline int GetBufferSize() const { return m_cbBuffer; }
+
+private:
+	int m_fd = -1;
+
+	// Submission queue
+	void *m_pSQRingMem = nullptr;
+	size_t m_cbSQRingMem = 0;
+	unsigned *m_pSQTail = nullptr;
+	unsigned *m_pSQHead = nullptr;
+	unsigned m_nSQMask = 0;
+	unsigned m_nSQEntries = 0;
+	io_uring_sqe *m_pSQEs = nullptr;
+	size_t m_cbSQEs = 0;
+	unsigned m_nSQTailLocal = 0; // Filled in, but might not be published to the kernel
+	unsigned m_nSQTailSubmitted = 0;
+
+	// Completion queue.  Might share the mapping with the submission queue
+	void *m_pCQRingMem = nullptr;
+	size_t m_cbCQRingMem = 0;
+	unsigned *m_pCQHead = nullptr;
+	unsigned *m_pCQTail = nullptr;
+	unsigned m_nCQMask = 0;
+	io_uring_cqe *m_pCQEs = nullptr;
+
+	// Provided buffers
+	io_uring_buf_ring *m_pBufRing = nullptr;
+	size_t m_cbBufRing = 0;
+	char *m_pBuffers = nullptr;
+	int m_cbBuffer = 0;
+	int m_nBufRingEntries = 0;
+	uint16 m_nBufRingTail = 0;
+};
+
+} // namespace SteamNetworkingSocketsLib
+
+#endif // #ifdef STEAMNETWORKINGSOCKETS_IOURING
+
+#endif // STEAMNETWORKINGSOCKETS_IOURING_H
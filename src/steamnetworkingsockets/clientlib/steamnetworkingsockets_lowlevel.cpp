@@ -20,7 +20,10 @@
 #include <sched.h>
 #endif
 
+#include <steam/steamnetworkingsockets.h>
 #include "steamnetworkingsockets_lowlevel.h"
+#include "steamnetworkingsockets_iouring.h"
+#include "steamnetworkingsockets_xdp.h"
 #include "../steamnetworkingsockets_internal.h"
 #include "../steamnetworkingsockets_thinker.h"
 #include <vstdlib/random.h>
@@ -44,6 +47,83 @@
 // Time low level send/recv calls and packet processing
 //#define STEAMNETWORKINGSOCKETS_LOWLEVEL_TIME_SOCKET_CALLS
 
+// On Linux, use recvmmsg to pull multiple datagrams out of the
+// kernel with a single system call
+#ifdef LINUX
+	#define STEAMNETWORKINGSOCKETS_LOWLEVEL_RECVMMSG
+#endif
+
+// On Linux, we can queue up outbound packets and send them
+// with a single sendmmsg call.  (See k_ESteamNetworkingConfig_UDPSendBatchSize)
+#ifdef LINUX
+	#define STEAMNETWORKINGSOCKETS_LOWLEVEL_SENDMMSG
+#endif
+
+// On Linux, sockets are registered once with a persistent epoll instance,
+// rather than building a pollfd array every time the service thread sleeps.
+// Only the sockets that are ready are returned, and they are drained edge-triggered.
+#ifdef LINUX
+	#define STEAMNETWORKINGSOCKETS_LOWLEVEL_EPOLL
+#endif
+
+#ifdef LINUX
+	#include <netinet/udp.h>
+	#include <sys/epoll.h>
+	#include <sys/eventfd.h>
+	#include <sys/syscall.h>
+	#include <unistd.h>
+#endif
+
+// epoll_pwait2 takes a timeout with nanosecond precision, so we can sleep until
+// exactly when the next thinker is due.  We invoke the syscall directly so that we
+// don't depend on the glibc version, and fall back to epoll_wait if the kernel
+// doesn't have it.
+#if defined( STEAMNETWORKINGSOCKETS_LOWLEVEL_EPOLL ) && defined( __NR_epoll_pwait2 )
+	#define STEAMNETWORKINGSOCKETS_LOWLEVEL_EPOLL_PWAIT2
+#endif
+
+// On Linux, wake the service thread using an eventfd rather than a socketpair.
+// Multiple wake requests are coalesced into a single counter, which is
+// reset with one read.
+#ifdef LINUX
+	#define STEAMNETWORKINGSOCKETS_LOWLEVEL_EVENTFD
+#endif
+
+// UDP generic segmentation offload.  When sends are being queued, runs of
+// packets of the same size to the same destination can be handed to the
+// kernel as a single "super buffer".  (See k_ESteamNetworkingConfig_UDPSendGSO)
+#if defined( STEAMNETWORKINGSOCKETS_LOWLEVEL_SENDMMSG ) && defined( UDP_SEGMENT )
+	#define STEAMNETWORKINGSOCKETS_LOWLEVEL_UDP_GSO
+#endif
+
+// UDP generic receive offload.  The kernel can coalesce a run of datagrams from the
+// same sender into one big buffer, which we split back up.
+// (See k_ESteamNetworkingConfig_UDPRecvGRO)
+#if defined( STEAMNETWORKINGSOCKETS_LOWLEVEL_RECVMMSG ) && defined( UDP_GRO )
+	#define STEAMNETWORKINGSOCKETS_LOWLEVEL_UDP_GRO
+#endif
+
+// Kernel receive timestamps, so we know when a datagram actually arrived.
+// (See k_ESteamNetworkingConfig_UDPRecvKernelTimestamps)
+#if defined( STEAMNETWORKINGSOCKETS_LOWLEVEL_RECVMMSG ) && defined( SO_TIMESTAMPNS )
+	#define STEAMNETWORKINGSOCKETS_LOWLEVEL_RECV_TIMESTAMPS
+#endif
+
+// Kernel drop counters.  Once a socket has dropped datagrams because its receive
+// buffer was full, the kernel tells us the running total with each datagram.
+// (See SteamNetworkingSockets_GetUDPSocketStats)
+#if defined( STEAMNETWORKINGSOCKETS_LOWLEVEL_RECVMMSG ) && defined( SO_RXQ_OVFL )
+	#define STEAMNETWORKINGSOCKETS_LOWLEVEL_RXQ_OVFL
+#endif
+
+// AF_XDP.  IPv4 datagrams addressed to our ports can be pulled straight off of
+// one queue of a network interface, bypassing most of the kernel stack.  The
+// AF_XDP socket is waited on with the rest of our sockets in the epoll set.
+// (See k_ESteamNetworkingConfig_XDP_Interface)
+#if defined( STEAMNETWORKINGSOCKETS_XDP ) && defined( STEAMNETWORKINGSOCKETS_LOWLEVEL_EPOLL )
+	#define STEAMNETWORKINGSOCKETS_LOWLEVEL_XDP
+#endif
+
 // memdbgon must be the last include file in a .cpp file!!!
 #include "tier0/memdbgon.h"
 
@@ -72,6 +152,128 @@ static int s_nCurrentLockTagCounts[k_nMaxCurrentLockTags];
 static void (*s_fLockAcquiredCallback)( SteamNetworkingMicroseconds usecWaited );
 static SteamNetworkingMicroseconds s_usecLockWaitWarningThreshold = 2*1000;
 
+static void FlushAllQueuedRawUDPSends();
+
+/////////////////////////////////////////////////////////////////////////////
+//
+// Lock contention stats.  Always on.  Everything here is protected by the
+// lock itself.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+/// Accumulated wait or hold times
+struct LockTimeStats_t
+{
+	int64 m_nCount;
+	int64 m_usecTotal;
+	int64 m_usecMax;
+	int64 m_nHistogram[ k_nSteamNetworkingSocketsLockHistogramBuckets ];
+
+	inline void Record( SteamNetworkingMicroseconds usec )
+	{
+		if ( usec < 0 )
+			usec = 0;
+		++m_nCount;
+		m_usecTotal += usec;
+		m_usecMax = std::max( m_usecMax, usec );
+		int idx = FindMostSignificantBit64( (uint64)usec ) + 1; // 0 -> 0, 1 -> 1, 2..3 -> 2, etc
+		++m_nHistogram[ std::min( idx, k_nSteamNetworkingSocketsLockHistogramBuckets-1 ) ];
+	}
+};
+
+struct LockTagStats_t
+{
+	const char *m_pszTag;
+	LockTimeStats_t m_wait;
+	LockTimeStats_t m_hold;
+};
+
+/// Max number of distinct tag names we track.  If we run out, the rest are
+/// lumped together in the last entry
+constexpr int k_nMaxLockTagStats = 128;
+static LockTagStats_t s_lockTagStats[ k_nMaxLockTagStats ];
+static int s_nLockTagStats;
+
+/// Map tag string pointer -> index in s_lockTagStats.  Tags are almost always
+/// string literals, so this is nearly always a hit on the first probe.  The
+/// same name might appear at different addresses, so multiple keys can map
+/// to the same entry.
+constexpr int k_nLockTagStatsHashSize = 512;
+static const char *s_lockTagStatsKeys[ k_nLockTagStatsHashSize ];
+static uint8 s_lockTagStatsIndex[ k_nLockTagStatsHashSize ];
+static int s_nLockTagStatsKeys;
+COMPILE_TIME_ASSERT( k_nMaxLockTagStats <= 256 );
+
+/// Map tag name -> index+1 in s_lockTagStats (0 = empty slot).  Used when we
+/// see a pointer for the first time, and for pointers that didn't fit in the
+/// table above.  It holds at most k_nMaxLockTagStats names and is twice that
+/// size, so the probe sequence stays short.
+constexpr int k_nLockTagStatsNameHashSize = k_nMaxLockTagStats*2;
+static uint8 s_lockTagStatsNameIndex[ k_nLockTagStatsNameHashSize ];
+
+static int FindOrAddLockTagStatsByName( const char *pszTag )
+{
+	uint32 nHash = 2166136261u; // FNV-1a
+	for ( const char *p = pszTag ; *p ; ++p )
+		nHash = ( nHash ^ (uint8)*p ) * 16777619u;
+
+	int h = nHash & ( k_nLockTagStatsNameHashSize-1 );
+	for (;;)
+	{
+		int idx = s_lockTagStatsNameIndex[h] - 1;
+		if ( idx < 0 )
+			break;
+		if ( V_strcmp( s_lockTagStats[idx].m_pszTag, pszTag ) == 0 )
+			return idx;
+		h = ( h+1 ) & ( k_nLockTagStatsNameHashSize-1 );
+	}
+
+	// New name.  Once we run out, everything else is lumped into the
+	// last entry, and we don't add it to the map
+	if ( s_nLockTagStats >= k_nMaxLockTagStats )
+		return k_nMaxLockTagStats-1;
+	int idx = s_nLockTagStats++;
+	if ( s_nLockTagStats < k_nMaxLockTagStats )
+	{
+		s_lockTagStats[idx].m_pszTag = pszTag;
+		s_lockTagStatsNameIndex[h] = (uint8)( idx+1 );
+	}
+	else
+	{
+		s_lockTagStats[idx].m_pszTag = "(other)";
+	}
+	return idx;
+}
+
+static int FindOrAddLockTagStats( const char *pszTag )
+{
+	if ( !pszTag )
+		pszTag = "(untagged)";
+
+	int h = int( ( (uintptr_t)pszTag * 0x9E3779B97F4A7C15ull ) >> 55 ) & ( k_nLockTagStatsHashSize-1 );
+	for (;;)
+	{
+		if ( s_lockTagStatsKeys[h] == pszTag )
+			return s_lockTagStatsIndex[h];
+		if ( s_lockTagStatsKeys[h] == nullptr )
+			break;
+		h = ( h+1 ) & ( k_nLockTagStatsHashSize-1 );
+	}
+
+	// First time we've seen this pointer (or the pointer table is full).
+	// Look it up by name; the cost is bounded by the length of the name.
+	int idx = FindOrAddLockTagStatsByName( pszTag );
+
+	// Remember the pointer, unless the table is getting full.
+	if ( s_nLockTagStatsKeys < k_nLockTagStatsHashSize/2 )
+	{
+		++s_nLockTagStatsKeys;
+		s_lockTagStatsKeys[h] = pszTag;
+		s_lockTagStatsIndex[h] = (uint8)idx;
+	}
+	return idx;
+}
+
 void SteamDatagramTransportLock::AddTag( const char *pszTag )
 {
 	if ( !pszTag || s_nCurrentLockTags >= k_nMaxCurrentLockTags )
@@ -103,6 +305,9 @@ void SteamDatagramTransportLock::OnLocked( const char *pszTag, SteamNetworkingMi
 		s_usecLongLockWarningThreshold = k_usecDefaultLongLockHeldWarningThreshold;
 		s_nCurrentLockTags = 0;
 
+		// Wait time is charged to whoever was trying to get the lock
+		s_lockTagStats[ FindOrAddLockTagStats( pszTag ) ].m_wait.Record( usecTimeSpentWaitingOnLock );
+
 		if ( usecTimeSpentWaitingOnLock > s_usecLockWaitWarningThreshold && usecNow > s_usecIgnoreLongLockWaitTimeUntil )
 		{
 			if ( pszTag )
@@ -167,9 +372,18 @@ void SteamDatagramTransportLock::Unlock()
 	if ( s_nLocked == 1 )
 	{
 
+		// Send any packets that were queued while we held the lock
+		FlushAllQueuedRawUDPSends();
+
 		// We're about to do the final release.  How long did we hold the lock?
 		usecElapsedTooLong = SteamNetworkingSockets_GetLocalTimestamp() - s_usecWhenLocked;
 
+		// Charge hold time to every tag that was attached while we held it
+		if ( s_nCurrentLockTags == 0 )
+			s_lockTagStats[ FindOrAddLockTagStats( nullptr ) ].m_hold.Record( usecElapsedTooLong );
+		for ( int i = 0 ; i < s_nCurrentLockTags ; ++i )
+			s_lockTagStats[ FindOrAddLockTagStats( s_pszCurrentLockTags[i] ) ].m_hold.Record( usecElapsedTooLong );
+
 		// If that duration is acceptable, then clear it.  We need to check the
 		// threshold here because the threshold could change by another thread
 		// immediately after we release the lock.  Also, if we're debugging, all bets are
@@ -371,6 +585,216 @@ void ISteamNetworkingSocketsRunWithLock::ServiceQueue()
 inline IRawUDPSocket::IRawUDPSocket() {}
 inline IRawUDPSocket::~IRawUDPSocket() {}
 
+/// Optional features that were enabled on a raw socket
+enum ERawUDPSocketFlags
+{
+	k_nRawUDPSocketFlag_GRO = 1<<0, // UDP_GRO.  We might receive coalesced datagrams
+	k_nRawUDPSocketFlag_RecvTimestamp = 1<<1, // SO_TIMESTAMPNS.  Datagrams come with the time they arrived
+	k_nRawUDPSocketFlag_RxqOvfl = 1<<2, // SO_RXQ_OVFL.  Datagrams come with the number dropped so far
+};
+
+/// Totals for all raw sockets.  Only accessed while holding the lock.
+static SteamNetworkingSocketsUDPStats s_udpStats;
+
+#ifdef STEAMNETWORKINGSOCKETS_IOURING
+
+/// io_uring used for all raw sockets, if it was requested and the kernel
+/// supports it.  (See k_ESteamNetworkingConfig_UDPIOUring.)  Only accessed
+/// while holding the lock, except for waiting on completions.
+static CIOUring s_ioUring;
+
+/// What sort of request a completion is for.  Stored in the low bits of the user data
+enum EIOUringOp
+{
+	k_EIOUringOp_Recv = 0, // Multishot recvmsg.  Upper bits are the socket pointer
+	k_EIOUringOp_Send = 1, // sendmsg.  Upper bits are the send slot index
+	k_EIOUringOp_Wake = 2, // Multishot poll on the wake socket
+	k_EIOUringOp_Cancel = 3, // Cancellation of a multishot recvmsg
+};
+constexpr uint64 k_nIOUringOpMask = 3;
+
+#endif
+
+#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_XDP
+
+/// AF_XDP socket, if one was requested and we were able to set it up.
+/// (See k_ESteamNetworkingConfig_XDP_Interface.)  Only accessed while holding the lock.
+static CXDPSocket s_xdp;
+
+/// How to reach a remote host directly on the wire.  We learn this from the
+/// frames we receive from them, but only once the packet has been authenticated
+/// by whoever it was dispatched to.  Anybody can put any source address on a
+/// frame, so trusting every frame would let a spoofed one redirect our replies
+/// to a peer.  (If the host isn't on the local network, the "remote" MAC is the
+/// router's.)  Until we know a route, we just send through the ordinary socket.
+struct XDPRoute_t
+{
+	uint8 m_macRemote[6];
+	uint8 m_macLocal[6];
+	uint32 m_nLocalIP;
+	SteamNetworkingMicroseconds m_usecLastConfirmed;
+};
+
+/// Routes, by remote IPv4 address (host byte order)
+static CUtlHashMap<uint32, XDPRoute_t, std::equal_to<uint32>, std::hash<uint32> > s_mapXDPRoutes;
+
+/// Max number of routes we will remember.  If we are full, new hosts are sent
+/// to through the ordinary socket.
+constexpr int k_nMaxXDPRoutes = 16384;
+
+/// Forget a route if no authenticated packet has arrived over it for this long.
+/// Connected peers send us something at least every few seconds.
+constexpr SteamNetworkingMicroseconds k_usecXDPRouteTimeout = 30*k_nMillion;
+
+/// The frame we are currently dispatching, and when we received it.  (See
+/// RawUDPPacketAuthenticated.)  nullptr if we aren't dispatching one.
+static const XDPUDPFrame_t *s_pXDPDispatchFrame = nullptr;
+static SteamNetworkingMicroseconds s_usecXDPDispatchFrame = 0;
+
+/// Remove routes that have not been confirmed recently
+static void XDPExpireRoutes( SteamNetworkingMicroseconds usecNow )
+{
+	FOR_EACH_HASHMAP( s_mapXDPRoutes, idx )
+	{
+		if ( s_mapXDPRoutes[ idx ].m_usecLastConfirmed + k_usecXDPRouteTimeout < usecNow )
+			s_mapXDPRoutes.RemoveAt( idx );
+	}
+}
+
+/// Learn (or refresh) the route to the sender of a frame that was
+/// just authenticated.
+static void XDPConfirmRoute( const XDPUDPFrame_t &frame, SteamNetworkingMicroseconds usecNow )
+{
+	XDPRoute_t *pRoute = s_mapXDPRoutes.FindGetPtr( frame.m_nSrcIP );
+	if ( !pRoute )
+	{
+		if ( s_mapXDPRoutes.Count() >= k_nMaxXDPRoutes )
+		{
+			XDPExpireRoutes( usecNow );
+			if ( s_mapXDPRoutes.Count() >= k_nMaxXDPRoutes )
+				return;
+		}
+		pRoute = &s_mapXDPRoutes[ s_mapXDPRoutes.Insert( frame.m_nSrcIP ) ];
+	}
+	memcpy( pRoute->m_macRemote, frame.m_macSrc, 6 );
+	memcpy( pRoute->m_macLocal, frame.m_macDst, 6 );
+	pRoute->m_nLocalIP = frame.m_nDstIP;
+	pRoute->m_usecLastConfirmed = usecNow;
+}
+
+/// Raw sockets receiving through the AF_XDP socket, by local port
+class CRawUDPSocketImpl;
+static CUtlHashMap<uint16, CRawUDPSocketImpl *, std::equal_to<uint16>, Identity<uint16> > s_mapXDPPorts;
+
+/// Max number of frames we will pull off of the receive ring at once
+constexpr int k_nMaxXDPRecvBatch = 64;
+
+/// Build a frame and queue it on the AF_XDP socket.  Returns false if
+/// we can't (not IPv4, we don't know the route, or we're out of frames),
+/// and the caller should just send it through the ordinary socket.
+static bool BXDPQueueSend( uint16 nLocalPort, int nChunks, const iovec *pChunks, const netadr_t &adrTo )
+{
+	uint32 nRemoteIP;
+	if ( adrTo.GetType() == k_EIPTypeV4 )
+		nRemoteIP = adrTo.GetIPv4();
+	else if ( adrTo.IsMappedIPv4() )
+		nRemoteIP = BigDWord( *(const uint32 *)( adrTo.GetIPV6Bytes() + 12 ) );
+	else
+		return false;
+	const int idxRoute = s_mapXDPRoutes.Find( nRemoteIP );
+	if ( idxRoute == s_mapXDPRoutes.InvalidIndex() )
+		return false;
+	const XDPRoute_t *pRoute = &s_mapXDPRoutes[ idxRoute ];
+
+	// Haven't heard from them in a while?  The route might have changed
+	if ( pRoute->m_usecLastConfirmed + k_usecXDPRouteTimeout < SteamNetworkingSockets_GetLocalTimestamp() )
+	{
+		s_mapXDPRoutes.RemoveAt( idxRoute );
+		return false;
+	}
+
+	int cbPayload = 0;
+	for ( int i = 0 ; i < nChunks ; ++i )
+		cbPayload += (int)pChunks[i].iov_len;
+	if ( k_cbXDPUDPHeaders + cbPayload > CXDPSocket::k_cbFrame )
+		return false;
+
+	uint64 nAddr;
+	uint8 *pFrame = s_xdp.AllocTxFrame( nAddr );
+	if ( !pFrame )
+		return false;
+
+	XDPUDPFrame_t hdr;
+	memcpy( hdr.m_macSrc, pRoute->m_macLocal, 6 );
+	memcpy( hdr.m_macDst, pRoute->m_macRemote, 6 );
+	hdr.m_nSrcIP = pRoute->m_nLocalIP;
+	hdr.m_nDstIP = nRemoteIP;
+	hdr.m_nSrcPort = nLocalPort;
+	hdr.m_nDstPort = adrTo.GetPort();
+	hdr.m_pPayload = nullptr;
+	hdr.m_cbPayload = cbPayload;
+	XDPWriteUDPHeaders( pFrame, hdr );
+
+	uint8 *d = pFrame + k_cbXDPUDPHeaders;
+	for ( int i = 0 ; i < nChunks ; ++i )
+	{
+		memcpy( d, pChunks[i].iov_base, pChunks[i].iov_len );
+		d += pChunks[i].iov_len;
+	}
+
+	// It will actually go out when we flush, before we release the lock
+	s_xdp.QueueTxFrame( nAddr, k_cbXDPUDPHeaders + cbPayload );
+	++s_udpStats.m_nSendPackets;
+	return true;
+}
+
+#endif
+
+#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_SENDMMSG
+
+/// Max number of packets we will queue on a socket to be sent with a single sendmmsg call
+constexpr int k_nMaxSendBatch = 64;
+
+#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_UDP_GSO
+
+/// Max number of segments the kernel will accept in one GSO send.  (UDP_MAX_SEGMENTS)
+constexpr int k_nMaxGSOSegments = 64;
+
+/// Max total size of a GSO super buffer.  It must fit in a single IP datagram.
+constexpr int k_cbMaxGSOSend = 65000;
+
+/// Control message buffer used to pass the segment size
+union GSOControlMsg_t
+{
+	char m_buf[ CMSG_SPACE( sizeof(uint16_t) ) ];
+	cmsghdr m_align;
+};
+
+#endif
+
+/// Outbound packets queued on a socket, waiting to be sent in a batch.
+///
+/// The data must be gathered into our own buffers, since the chunks we
+/// are given usually live on the caller's stack, and we will not actually
+/// send until after the caller returns.
+struct RawUDPSendBatch_t
+{
+	int m_nPackets = 0;
+	mmsghdr m_msgs[ k_nMaxSendBatch ];
+	iovec m_iov[ k_nMaxSendBatch ];
+	sockaddr_storage m_addr[ k_nMaxSendBatch ];
+	char m_pkt[ k_nMaxSendBatch ][ k_cbSteamNetworkingSocketsMaxUDPMsgLen ];
+
+	#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_UDP_GSO
+		// Messages we actually send when coalescing runs of packets
+		mmsghdr m_gsoMsgs[ k_nMaxSendBatch ];
+		int m_gsoSegments[ k_nMaxSendBatch ];
+		GSOControlMsg_t m_gsoControl[ k_nMaxSendBatch ];
+	#endif
+};
+
+#endif
+
 class CRawUDPSocketImpl : public IRawUDPSocket
 {
 public:
@@ -380,6 +804,10 @@ public:
 		#ifdef WIN32
 			WSACloseEvent( m_event );
 		#endif
+		#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_SENDMMSG
+			Assert( !m_pSendBatch || m_pSendBatch->m_nPackets == 0 );
+			delete m_pSendBatch;
+		#endif
 	}
 
 	/// Descriptor from the OS
@@ -388,6 +816,27 @@ public:
 	/// What address families are supported by this socket?
 	int m_nAddressFamilies;
 
+	/// Optional features enabled on this socket.  (ERawUDPSocketFlags)
+	int m_nSocketFlags = 0;
+
+	/// Receive buffer size we asked for.  (It might grow, see
+	/// k_ESteamNetworkingConfig_UDPRecvBufferMax)
+	int m_cbRecvBuffer = 0;
+
+	/// Number of datagrams received on this socket
+	int64 m_nRecvPackets = 0;
+
+	#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_RXQ_OVFL
+
+		/// Running total of drops last reported by the kernel, and the
+		/// number we have counted.  (They only differ by wraparound.)
+		uint32 m_nKernelDropsReported = 0;
+		int64 m_nKernelDrops = 0;
+
+		/// When we last grew the receive buffer
+		SteamNetworkingMicroseconds m_usecRecvBufferGrown = 0;
+	#endif
+
 	/// Who to notify when we receive a packet on this socket.
 	/// This is set to null when we are asked to close the socket.
 	CRecvPacketCallback m_callback;
@@ -408,16 +857,7 @@ public:
 
 		// Convert address to BSD interface
 		struct sockaddr_storage destAddress;
-		socklen_t addrSize;
-		if ( m_nAddressFamilies & k_nAddressFamily_IPv6 )
-		{
-			addrSize = sizeof(sockaddr_in6);
-			adrTo.ToSockadrIPV6( &destAddress );
-		}
-		else
-		{
-			addrSize = (socklen_t)adrTo.ToSockadr( &destAddress );
-		}
+		socklen_t addrSize = ConvertToSockAddr( adrTo, destAddress );
 
 		#ifdef STEAMNETWORKINGSOCKETS_ENABLE_ETW
 		{
@@ -432,6 +872,23 @@ public:
 		//Log_Detailed( LOG_STEAMDATAGRAM_CLIENT, "%4db -> %s %02x %02x %02x %02x %02x ...\n",
 		//	cbPkt, CUtlNetAdrRender( adrTo ).String(), pbPkt[0], pbPkt[1], pbPkt[2], pbPkt[3], pbPkt[4] );
 
+		// Receiving through AF_XDP, and we know how to reach this host?
+		// Then send that way, too.
+		#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_XDP
+			if ( m_bXDP && BXDPQueueSend( m_boundAddr.m_port, nChunks, pChunks, adrTo ) )
+				return true;
+		#endif
+
+		// Using io_uring?  Then just queue a request.  It will be
+		// submitted along with any others when we release the lock.
+		#ifdef STEAMNETWORKINGSOCKETS_IOURING
+			if ( s_ioUring.IsValid() && BIOUringQueueSend( nChunks, pChunks, destAddress, addrSize ) )
+			{
+				++s_udpStats.m_nSendPackets;
+				return true;
+			}
+		#endif
+
 		#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_TIME_SOCKET_CALLS
 			SteamNetworkingMicroseconds usecSendStart = SteamNetworkingSockets_GetLocalTimestamp();
 		#endif
@@ -482,8 +939,75 @@ public:
 			}
 		#endif
 
+		++s_udpStats.m_nSendCalls;
+		++s_udpStats.m_nSendPackets;
+
 		return bResult;
 	}
+
+	/// Convert address to BSD interface, appropriate for the address
+	/// families supported by this socket.  Returns the size of the address
+	inline socklen_t ConvertToSockAddr( const netadr_t &adrTo, sockaddr_storage &destAddress ) const
+	{
+		if ( m_nAddressFamilies & k_nAddressFamily_IPv6 )
+		{
+			adrTo.ToSockadrIPV6( &destAddress );
+			return sizeof(sockaddr_in6);
+		}
+		return (socklen_t)adrTo.ToSockadr( &destAddress );
+	}
+
+	#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_SENDMMSG
+
+		/// Packets waiting to be sent.  Allocated the first time we queue
+		/// a packet on this socket.
+		mutable RawUDPSendBatch_t *m_pSendBatch = nullptr;
+
+		/// Queue a packet to be sent later, in a batch.  (No checking for fake loss or lag.)
+		bool BQueueSendRawPacket( int nChunks, const iovec *pChunks, const netadr_t &adrTo, int nMaxBatch ) const;
+
+		/// Send any queued packets right now.
+		void FlushQueuedSends() const;
+
+		inline bool BHasQueuedSends() const { return m_pSendBatch && m_pSendBatch->m_nPackets > 0; }
+	#endif
+
+	#ifdef STEAMNETWORKINGSOCKETS_IOURING
+
+		/// True if we have a multishot recvmsg outstanding.  While this is set,
+		/// we cannot be destroyed, because the kernel might still post a
+		/// completion that points to us.
+		bool m_bIOUringRecvArmed = false;
+
+		/// Describes what we want from the multishot recvmsg.  (Just the
+		/// sender address.  The payload goes into a provided buffer.)
+		msghdr m_ioUringRecvMsg;
+
+		/// Copy a packet into a send slot and queue a sendmsg request.  Returns
+		/// false if we couldn't, and the caller should just send it directly.
+		bool BIOUringQueueSend( int nChunks, const iovec *pChunks, const sockaddr_storage &destAddress, socklen_t addrSize ) const;
+	#endif
+
+	#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_XDP
+
+		/// True if IPv4 datagrams addressed to our port are redirected to
+		/// the AF_XDP socket.  (See s_mapXDPPorts)
+		bool m_bXDP = false;
+	#endif
+
+	#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_UDP_GSO
+
+		/// True if the kernel supports UDP_SEGMENT on this socket, and we
+		/// haven't had a failure trying to use it.
+		mutable bool m_bUDPGSO = false;
+
+		/// Send queued packets, starting at the specified index, coalescing runs of
+		/// same-size packets to the same destination.  Returns the number of queued
+		/// packets consumed, or 0 if the caller should try again.  (Because we
+		/// were interrupted, or because GSO failed and the caller should fall
+		/// back to ordinary sends.)
+		int SendQueuedWithGSO( int idxFirst, int nPackets ) const;
+	#endif
 };
 
 /// We don't expect to have enough sockets, and open and close them frequently
@@ -493,41 +1017,683 @@ static CUtlVector<CRawUDPSocketImpl *> s_vecRawSockets;
 /// List of raw sockets pending actual destruction.
 static CUtlVector<CRawUDPSocketImpl *> s_vecRawSocketsPendingDeletion;
 
-/// Track packets that have fake lag applied and are pending to be sent/received
-class CPacketLagger : private IThinker
-{
-public:
-	~CPacketLagger() { Clear(); }
+/// True while we are dispatching packets received by the service thread.
+/// A socket closed by a callback must not be destroyed until we are done,
+/// since we might still be holding a pointer to it.
+static bool s_bDispatchingRawUDPPackets = false;
 
-	void LagPacket( bool bSend, const CRawUDPSocketImpl *pSock, const netadr_t &adr, int msDelay, int nChunks, const iovec *pChunks )
+#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_XDP
+
+/// Start receiving IPv4 datagrams for this socket through the AF_XDP socket,
+/// if we can.  Only sockets bound to the "any" address are eligible, and only
+/// one socket per port.  (The rest of a group of sockets sharing a port will
+/// just receive whatever the kernel gives them, which is usually nothing.)
+static void XDPAddSocket( CRawUDPSocketImpl *pSock )
+{
+	Assert( s_xdp.IsValid() );
+	if ( !( pSock->m_nAddressFamilies & k_nAddressFamily_IPv4 ) )
+		return;
+	if ( !pSock->m_boundAddr.IsIPv6AllZeros() && !( pSock->m_boundAddr.IsIPv4() && pSock->m_boundAddr.GetIPv4() == 0 ) )
+		return;
+	const uint16 nPort = pSock->m_boundAddr.m_port;
+	if ( s_mapXDPPorts.HasElement( nPort ) )
+		return;
+	if ( !s_xdp.BAddPort( nPort ) )
 	{
-		SteamDatagramTransportLock::AssertHeldByCurrentThread( "LagPacket" );
+		SpewWarning( "Failed to redirect port %d to AF_XDP socket.  Error code %d.\n", nPort, errno );
+		return;
+	}
+	s_mapXDPPorts.Insert( nPort, pSock );
+	pSock->m_bXDP = true;
+}
 
-		int cbPkt = 0;
-		for ( int i = 0 ; i < nChunks ; ++i )
-			cbPkt += pChunks[i].iov_len;
-		if ( cbPkt > k_cbSteamNetworkingSocketsMaxUDPMsgLen )
+static void XDPRemoveSocket( CRawUDPSocketImpl *pSock )
+{
+	Assert( pSock->m_bXDP );
+	pSock->m_bXDP = false;
+	s_mapXDPPorts.Remove( pSock->m_boundAddr.m_port );
+	if ( s_xdp.IsValid() )
+		s_xdp.RemovePort( pSock->m_boundAddr.m_port );
+}
+
+#endif
+
+#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_EPOLL
+	/// epoll instance with all of our raw sockets, plus the wake socket, registered.
+	static int s_epollFD = -1;
+
+	/// Max number of ready sockets we will process per wakeup.  If more than this
+	/// are ready, the rest will be returned by the next call.
+	constexpr int k_nMaxEpollEvents = 256;
+#endif
+
+/////////////////////////////////////////////////////////////////////////////
+//
+// Thread placement
+//
+/////////////////////////////////////////////////////////////////////////////
+
+/// How to set up one of our threads.  Filled in from the config while
+/// holding the lock, and then applied by the thread itself.
+struct ThreadSettings_t
+{
+	std::string m_sName;
+	std::vector<int> m_vecCPUs; // Empty to leave affinity alone
+	int m_nSchedPolicy = 0; // See k_ESteamNetworkingConfig_ServiceThreadSchedPolicy
+	int m_nSchedPriority = 0;
+};
+
+/// Parse a list of CPUs, like "2" or "0,4-7".  Returns false if it's malformed
+static bool BParseCPUList( const char *psz, std::vector<int> &vecCPUs )
+{
+	vecCPUs.clear();
+	while ( *psz )
+	{
+		char *pEnd;
+		long nFirst = strtol( psz, &pEnd, 10 );
+		if ( pEnd == psz || nFirst < 0 )
+			return false;
+		long nLast = nFirst;
+		psz = pEnd;
+		if ( *psz == '-' )
 		{
-			AssertMsg( false, "Tried to lag a packet that w as too big!" );
-			return;
+			++psz;
+			nLast = strtol( psz, &pEnd, 10 );
+			if ( pEnd == psz || nLast < nFirst )
+				return false;
+			psz = pEnd;
 		}
+		#ifdef LINUX
+			if ( nLast >= CPU_SETSIZE )
+				return false;
+		#endif
+		for ( long i = nFirst ; i <= nLast ; ++i )
+			vecCPUs.push_back( (int)i );
+		if ( *psz == ',' )
+			++psz;
+		else if ( *psz )
+			return false;
+	}
+	return !vecCPUs.empty();
+}
 
-		// Make sure we never queue a packet that is queued for destruction!
-		if ( pSock->m_socket == INVALID_SOCKET || !pSock->m_callback.m_fnCallback )
+/// Fill in settings from the config.  Must hold the lock.
+static void GetThreadSettings( ThreadSettings_t &settings, const std::string &sCPUs )
+{
+	SteamDatagramTransportLock::AssertHeldByCurrentThread();
+
+	settings.m_sName = g_Config_ServiceThreadName.Get();
+
+	settings.m_vecCPUs.clear();
+	if ( !sCPUs.empty() && !BParseCPUList( sCPUs.c_str(), settings.m_vecCPUs ) )
+	{
+		SpewWarning( "Ignoring invalid CPU list '%s'.\n", sCPUs.c_str() );
+		settings.m_vecCPUs.clear();
+	}
+
+	settings.m_nSchedPolicy = g_Config_ServiceThreadSchedPolicy.Get();
+	settings.m_nSchedPriority = g_Config_ServiceThreadSchedPriority.Get();
+}
+
+/// Apply settings to the current thread.  Failures are not fatal.
+static void ApplyThreadSettings( const ThreadSettings_t &settings )
+{
+	#ifdef LINUX
+		if ( !settings.m_sName.empty() )
+			pthread_setname_np( pthread_self(), settings.m_sName.substr( 0, 15 ).c_str() );
+
+		if ( !settings.m_vecCPUs.empty() )
 		{
-			AssertMsg( false, "Tried to lag a packet on a socket that has already been closed and is pending destruction!" );
-			return;
+			cpu_set_t cpus;
+			CPU_ZERO( &cpus );
+			for ( int nCPU: settings.m_vecCPUs )
+				CPU_SET( nCPU, &cpus );
+			int r = pthread_setaffinity_np( pthread_self(), sizeof(cpus), &cpus );
+			if ( r != 0 )
+				SpewWarning( "Failed to set CPU affinity for thread %s.  Error code %d.\n", settings.m_sName.c_str(), r );
 		}
+	#endif
 
-		if ( msDelay < 1 )
+	#if defined(POSIX)
+		pthread_t thread = pthread_self();
+
+		// Real-time policy requested?
+		if ( settings.m_nSchedPolicy != 0 )
 		{
-			AssertMsg( false, "Packet lag time must be positive!" );
-			msDelay = 1;
+			const int policy = ( settings.m_nSchedPolicy == 2 ) ? SCHED_RR : SCHED_FIFO;
+			const int min_priority = sched_get_priority_min(policy);
+			const int max_priority = sched_get_priority_max(policy);
+			struct sched_param sched;
+			memset( &sched, 0, sizeof(sched) );
+			if ( settings.m_nSchedPriority > 0 )
+				sched.sched_priority = std::max( min_priority, std::min( max_priority, settings.m_nSchedPriority ) );
+			else
+				sched.sched_priority = (min_priority + max_priority*3) / 4;
+			int r = pthread_setschedparam( thread, policy, &sched );
+			if ( r == 0 )
+				return;
+			SpewWarning( "Failed to set %s priority %d for thread %s.  Error code %d.  (Requires CAP_SYS_NICE.)\n",
+				policy == SCHED_RR ? "SCHED_RR" : "SCHED_FIFO", sched.sched_priority, settings.m_sName.c_str(), r );
 		}
 
-		// Limit to something sane
-		msDelay = std::min( msDelay, 5000 );
-		const SteamNetworkingMicroseconds usecTime = SteamNetworkingSockets_GetLocalTimestamp() + msDelay * 1000;
+		// This probably won't work on Linux, because you cannot raise thread priority
+		// without being root.  But on some systems it works.  So we try, and if it
+		// works, great.
+		struct sched_param sched;
+		int policy;
+		if ( pthread_getschedparam(thread, &policy, &sched) == 0 )
+		{
+			// Make sure we're not already at max.  No matter what, we don't
+			// want to lower our priority!  On linux, it appears that what happens
+			// is that the current and max priority values here are 0.
+			int max_priority = sched_get_priority_max(policy);
+			//printf( "pthread_getschedparam worked, policy=%d, pri=%d, max_pri=%d\n", policy, sched.sched_priority, max_priority );
+			if ( max_priority > sched.sched_priority )
+			{
+
+				// Determine new priority.
+				int min_priority = sched_get_priority_min(policy);
+				sched.sched_priority = std::max( sched.sched_priority+1, (min_priority + max_priority*3) / 4 );
+
+				// Try to set it
+				pthread_setschedparam( thread, policy, &sched );
+			}
+		}
+	#else
+		(void)settings;
+	#endif
+}
+
+#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_SENDMMSG
+
+/// List of raw sockets that have packets queued to be sent
+static CUtlVector<const CRawUDPSocketImpl *> s_vecRawSocketsWithQueuedSends;
+
+bool CRawUDPSocketImpl::BQueueSendRawPacket( int nChunks, const iovec *pChunks, const netadr_t &adrTo, int nMaxBatch ) const
+{
+	Assert( m_socket != INVALID_SOCKET );
+
+	if ( !m_pSendBatch )
+		m_pSendBatch = new RawUDPSendBatch_t;
+	RawUDPSendBatch_t &batch = *m_pSendBatch;
+	Assert( batch.m_nPackets < k_nMaxSendBatch );
+	const int idx = batch.m_nPackets;
+
+	// Gather the chunks into the slot
+	char *d = batch.m_pkt[ idx ];
+	int cbPkt = 0;
+	for ( int i = 0 ; i < nChunks ; ++i )
+	{
+		int cbChunk = (int)pChunks[i].iov_len;
+		if ( cbPkt + cbChunk > (int)sizeof( batch.m_pkt[ idx ] ) )
+		{
+			AssertMsg( false, "Tried to queue a packet that was too big!" );
+			return false;
+		}
+		memcpy( d + cbPkt, pChunks[i].iov_base, cbChunk );
+		cbPkt += cbChunk;
+	}
+
+	iovec &iov = batch.m_iov[ idx ];
+	iov.iov_base = d;
+	iov.iov_len = cbPkt;
+
+	msghdr &hdr = batch.m_msgs[ idx ].msg_hdr;
+	hdr.msg_name = &batch.m_addr[ idx ];
+	hdr.msg_namelen = ConvertToSockAddr( adrTo, batch.m_addr[ idx ] );
+	hdr.msg_iov = &iov;
+	hdr.msg_iovlen = 1;
+	hdr.msg_control = nullptr;
+	hdr.msg_controllen = 0;
+	hdr.msg_flags = 0;
+
+	ETW_UDPSendPacket( adrTo, cbPkt );
+
+	// First packet in the queue?  Then make sure it gets flushed
+	if ( idx == 0 )
+		s_vecRawSocketsWithQueuedSends.AddToTail( this );
+	++batch.m_nPackets;
+
+	// Batch full?
+	if ( batch.m_nPackets >= nMaxBatch )
+	{
+		FlushQueuedSends();
+		s_vecRawSocketsWithQueuedSends.FindAndFastRemove( this );
+	}
+
+	return true;
+}
+
+void CRawUDPSocketImpl::FlushQueuedSends() const
+{
+	if ( !m_pSendBatch )
+		return;
+	RawUDPSendBatch_t &batch = *m_pSendBatch;
+	const int nPackets = batch.m_nPackets;
+	batch.m_nPackets = 0;
+	if ( nPackets <= 0 )
+		return;
+
+	Assert( m_socket != INVALID_SOCKET );
+
+	// Add a tag.  If we end up holding the lock for a long time, this tag
+	// will tell us how many batches were sent
+	SteamDatagramTransportLock::AddTag( "SendUDPBatch" );
+
+	#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_TIME_SOCKET_CALLS
+		SteamNetworkingMicroseconds usecSendStart = SteamNetworkingSockets_GetLocalTimestamp();
+	#endif
+
+	int nSent = 0;
+	while ( nSent < nPackets )
+	{
+		int r;
+		#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_UDP_GSO
+			if ( m_bUDPGSO && g_Config_UDPSendGSO.Get() )
+			{
+				r = SendQueuedWithGSO( nSent, nPackets );
+				if ( r == 0 )
+				{
+					// Interrupted, or GSO just got disabled.  Try again
+					++s_udpStats.m_nSendRetries;
+					continue;
+				}
+				++s_udpStats.m_nSendCalls;
+			}
+			else
+		#endif
+		{
+			r = ::sendmmsg( m_socket, &batch.m_msgs[ nSent ], nPackets - nSent, 0 );
+
+			// Interrupted before anything was sent?  Just try again
+			if ( r < 0 && errno == EINTR )
+			{
+				++s_udpStats.m_nSendRetries;
+				continue;
+			}
+			++s_udpStats.m_nSendCalls;
+		}
+
+		// Error on the first packet remaining in the batch?  Treat it the same way
+		// we treat a failure to send a single packet: it's just dropped.
+		if ( r <= 0 )
+			r = 1;
+		nSent += r;
+	}
+	s_udpStats.m_nSendPackets += nPackets;
+
+	#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_TIME_SOCKET_CALLS
+		SteamNetworkingMicroseconds usecSendEnd = SteamNetworkingSockets_GetLocalTimestamp();
+		if ( usecSendEnd > s_usecIgnoreLongLockWaitTimeUntil )
+		{
+			SteamNetworkingMicroseconds usecSendElapsed = usecSendEnd - usecSendStart;
+			if ( usecSendElapsed > 1000 )
+			{
+				SpewWarning( "UDP batch send of %d packets took %.1fms\n", nPackets, usecSendElapsed*1e-3 );
+				ETW_LongOp( "UDP batch send", usecSendElapsed );
+			}
+		}
+	#endif
+}
+
+#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_UDP_GSO
+int CRawUDPSocketImpl::SendQueuedWithGSO( int idxFirst, int nPackets ) const
+{
+	RawUDPSendBatch_t &batch = *m_pSendBatch;
+
+	// Scan the queue and group packets into runs
+	int nMsgs = 0;
+	int idx = idxFirst;
+	while ( idx < nPackets )
+	{
+		const msghdr &first = batch.m_msgs[ idx ].msg_hdr;
+		const size_t cbSegment = batch.m_iov[ idx ].iov_len;
+		size_t cbTotal = cbSegment;
+		int nSegments = 1;
+
+		// Keep adding packets as long as they go to the same place
+		// and are the same size.  The last one in the run is allowed to
+		// be smaller.
+		while ( idx + nSegments < nPackets && nSegments < k_nMaxGSOSegments && cbSegment > 0 )
+		{
+			const int idxNext = idx + nSegments;
+			const size_t cbNext = batch.m_iov[ idxNext ].iov_len;
+			if ( cbNext > cbSegment || cbNext == 0 || cbTotal + cbNext > k_cbMaxGSOSend )
+				break;
+			const msghdr &next = batch.m_msgs[ idxNext ].msg_hdr;
+			if ( next.msg_namelen != first.msg_namelen || memcmp( next.msg_name, first.msg_name, first.msg_namelen ) != 0 )
+				break;
+			cbTotal += cbNext;
+			++nSegments;
+			if ( cbNext < cbSegment )
+				break;
+		}
+
+		msghdr &hdr = batch.m_gsoMsgs[ nMsgs ].msg_hdr;
+		hdr = first;
+		hdr.msg_iov = &batch.m_iov[ idx ];
+		hdr.msg_iovlen = nSegments;
+		if ( nSegments > 1 )
+		{
+			GSOControlMsg_t &ctrl = batch.m_gsoControl[ nMsgs ];
+			hdr.msg_control = ctrl.m_buf;
+			hdr.msg_controllen = sizeof( ctrl.m_buf );
+			cmsghdr *cm = CMSG_FIRSTHDR( &hdr );
+			cm->cmsg_level = IPPROTO_UDP;
+			cm->cmsg_type = UDP_SEGMENT;
+			cm->cmsg_len = CMSG_LEN( sizeof(uint16_t) );
+			uint16_t nSegmentSize = (uint16_t)cbSegment;
+			memcpy( CMSG_DATA( cm ), &nSegmentSize, sizeof(nSegmentSize) );
+		}
+		batch.m_gsoSegments[ nMsgs ] = nSegments;
+		++nMsgs;
+		idx += nSegments;
+	}
+
+	int r = ::sendmmsg( m_socket, batch.m_gsoMsgs, nMsgs, 0 );
+	if ( r <= 0 )
+	{
+		const int nErr = errno;
+
+		// Interrupted?  Let the caller try again
+		if ( r < 0 && nErr == EINTR )
+			return 0;
+
+		// If the first message was actually coalesced, and the error means
+		// the kernel or device can't do it (e.g. the route goes out an
+		// interface that can't do checksum offload), then turn GSO off and
+		// let the caller resend the packets the ordinary way.  Anything
+		// else (e.g. the socket buffer is full) is transient.
+		if ( batch.m_gsoSegments[0] > 1 && ( nErr == EIO || nErr == EINVAL || nErr == EOPNOTSUPP ) )
+		{
+			SpewWarning( "UDP GSO send failed on socket bound to %s, errno %d.  Disabling GSO for this socket.\n", SteamNetworkingIPAddrRender( m_boundAddr ).c_str(), nErr );
+			m_bUDPGSO = false;
+			return 0;
+		}
+
+		// Just drop the message, same as an ordinary send failure
+		return batch.m_gsoSegments[0];
+	}
+
+	// Return number of queued packets consumed by the messages that were sent
+	int nConsumed = 0;
+	for ( int i = 0 ; i < r ; ++i )
+	{
+		nConsumed += batch.m_gsoSegments[ i ];
+		if ( batch.m_gsoSegments[ i ] > 1 )
+			s_udpStats.m_nSendGSOSegments += batch.m_gsoSegments[ i ];
+	}
+	return nConsumed;
+}
+#endif
+
+#endif
+
+#ifdef STEAMNETWORKINGSOCKETS_IOURING
+
+/// Max number of sends that can be in flight
+constexpr int k_nIOUringSendSlots = 256;
+
+/// A packet that we have asked the kernel to send, and the data it needs.
+/// This must stay put until the request completes.
+struct IOUringSendSlot_t
+{
+	msghdr m_msg;
+	iovec m_iov;
+	sockaddr_storage m_addr;
+	char m_pkt[ k_cbSteamNetworkingSocketsMaxUDPMsgLen ];
+};
+static IOUringSendSlot_t *s_pIOUringSendSlots;
+static CUtlVector<int> s_vecIOUringFreeSendSlots;
+
+/// Number of sends queued since we last submitted
+static int s_nIOUringSendsPendingSubmit;
+
+/// Provided receive buffers.  Each buffer holds the recvmsg header,
+/// the sender address, and the payload.
+constexpr uint16 k_nIOUringBufferGroup = 0;
+constexpr int k_nIOUringRecvBuffers = 512;
+constexpr int k_cbIOUringRecvBuffer = 2560;
+
+/// Multishot requests deliver completions through the thread that submitted them,
+/// so we always arm them from the thread that polls.  These track what needs arming.
+static CUtlVector<CRawUDPSocketImpl *> s_vecIOUringSocketsToArm;
+static bool s_bIOUringWakeArmed;
+
+/// Get an SQE, submitting what we have if the queue is full
+static io_uring_sqe *IOUringGetSQE()
+{
+	io_uring_sqe *sqe = s_ioUring.GetSQE();
+	if ( !sqe )
+	{
+		s_ioUring.Submit();
+		sqe = s_ioUring.GetSQE();
+	}
+	return sqe;
+}
+
+static void IOUringSubmit()
+{
+	if ( s_ioUring.NumPendingSubmit() <= 0 )
+		return;
+	int r = s_ioUring.Submit();
+	if ( r < 0 )
+		SpewWarning( "io_uring submit failed.  Error code %d.\n", -r );
+	if ( s_nIOUringSendsPendingSubmit > 0 )
+	{
+		++s_udpStats.m_nSendCalls;
+		s_nIOUringSendsPendingSubmit = 0;
+	}
+}
+
+bool CRawUDPSocketImpl::BIOUringQueueSend( int nChunks, const iovec *pChunks, const sockaddr_storage &destAddress, socklen_t addrSize ) const
+{
+	int cbPkt = 0;
+	for ( int i = 0 ; i < nChunks ; ++i )
+		cbPkt += (int)pChunks[i].iov_len;
+	if ( cbPkt > k_cbSteamNetworkingSocketsMaxUDPMsgLen )
+	{
+		AssertMsg1( false, "Tried to send a packet that was too big (%d)", cbPkt );
+		return false;
+	}
+
+	// Out of slots?  All of them are waiting for the service thread to reap
+	// the completions.  Make sure the kernel has everything so it can finish,
+	// and just send this one the old fashioned way.
+	if ( s_vecIOUringFreeSendSlots.IsEmpty() )
+	{
+		IOUringSubmit();
+		return false;
+	}
+
+	io_uring_sqe *sqe = IOUringGetSQE();
+	if ( !sqe )
+		return false;
+
+	int idxSlot = s_vecIOUringFreeSendSlots.Tail();
+	s_vecIOUringFreeSendSlots.RemoveMultipleFromTail( 1 );
+	IOUringSendSlot_t &slot = s_pIOUringSendSlots[ idxSlot ];
+
+	char *d = slot.m_pkt;
+	for ( int i = 0 ; i < nChunks ; ++i )
+	{
+		memcpy( d, pChunks[i].iov_base, pChunks[i].iov_len );
+		d += pChunks[i].iov_len;
+	}
+	slot.m_iov.iov_base = slot.m_pkt;
+	slot.m_iov.iov_len = cbPkt;
+	memcpy( &slot.m_addr, &destAddress, addrSize );
+
+	memset( &slot.m_msg, 0, sizeof(slot.m_msg) );
+	slot.m_msg.msg_name = &slot.m_addr;
+	slot.m_msg.msg_namelen = addrSize;
+	slot.m_msg.msg_iov = &slot.m_iov;
+	slot.m_msg.msg_iovlen = 1;
+
+	sqe->opcode = IORING_OP_SENDMSG;
+	sqe->fd = m_socket;
+	sqe->addr = (uint64)(uintptr_t)&slot.m_msg;
+	sqe->len = 1;
+	sqe->user_data = ( (uint64)idxSlot << 2 ) | k_EIOUringOp_Send;
+	++s_nIOUringSendsPendingSubmit;
+	return true;
+}
+
+static void IOUringArmRecv( CRawUDPSocketImpl *pSock )
+{
+	Assert( !pSock->m_bIOUringRecvArmed );
+	io_uring_sqe *sqe = IOUringGetSQE();
+	if ( !sqe )
+	{
+		// Try again next time
+		s_vecIOUringSocketsToArm.AddToTail( pSock );
+		return;
+	}
+
+	msghdr &msg = pSock->m_ioUringRecvMsg;
+	memset( &msg, 0, sizeof(msg) );
+	msg.msg_namelen = sizeof(sockaddr_storage);
+	#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_RECV_TIMESTAMPS
+		if ( pSock->m_nSocketFlags & k_nRawUDPSocketFlag_RecvTimestamp )
+			msg.msg_controllen += CMSG_SPACE( sizeof(timespec) );
+	#endif
+	#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_RXQ_OVFL
+		if ( pSock->m_nSocketFlags & k_nRawUDPSocketFlag_RxqOvfl )
+			msg.msg_controllen += CMSG_SPACE( sizeof(uint32) );
+	#endif
+
+	sqe->opcode = IORING_OP_RECVMSG;
+	sqe->fd = pSock->m_socket;
+	sqe->addr = (uint64)(uintptr_t)&msg;
+	sqe->len = 1;
+	sqe->ioprio = IORING_RECV_MULTISHOT;
+	sqe->flags = IOSQE_BUFFER_SELECT;
+	sqe->buf_group = k_nIOUringBufferGroup;
+	sqe->user_data = (uint64)(uintptr_t)pSock | k_EIOUringOp_Recv;
+	pSock->m_bIOUringRecvArmed = true;
+}
+
+static void IOUringArmWake( int fdWake )
+{
+	Assert( !s_bIOUringWakeArmed );
+	io_uring_sqe *sqe = IOUringGetSQE();
+	if ( !sqe )
+		return;
+
+	sqe->opcode = IORING_OP_POLL_ADD;
+	sqe->fd = fdWake;
+	sqe->poll32_events = POLLIN;
+	sqe->len = IORING_POLL_ADD_MULTI;
+	sqe->user_data = k_EIOUringOp_Wake;
+	s_bIOUringWakeArmed = true;
+}
+
+static void IOUringCancelRecv( CRawUDPSocketImpl *pSock )
+{
+	io_uring_sqe *sqe = IOUringGetSQE();
+	if ( !sqe )
+	{
+		AssertMsg( false, "Can't get io_uring SQE to cancel recv!" );
+		return;
+	}
+
+	sqe->opcode = IORING_OP_ASYNC_CANCEL;
+	sqe->addr = (uint64)(uintptr_t)pSock | k_EIOUringOp_Recv;
+	sqe->user_data = k_EIOUringOp_Cancel;
+}
+
+/// Try to start using io_uring.  On failure, we just use ordinary system calls
+static bool BIOUringInit( SteamDatagramErrMsg &errMsg )
+{
+	if ( !s_ioUring.BInit( 256, 4096, errMsg ) )
+		return false;
+	if ( !s_ioUring.BInitBufferRing( k_nIOUringBufferGroup, k_nIOUringRecvBuffers, k_cbIOUringRecvBuffer, errMsg ) )
+	{
+		s_ioUring.Kill();
+		return false;
+	}
+
+	s_pIOUringSendSlots = new IOUringSendSlot_t[ k_nIOUringSendSlots ];
+	s_vecIOUringFreeSendSlots.EnsureCapacity( k_nIOUringSendSlots );
+	for ( int i = k_nIOUringSendSlots-1 ; i >= 0 ; --i )
+		s_vecIOUringFreeSendSlots.AddToTail( i );
+	s_nIOUringSendsPendingSubmit = 0;
+	s_bIOUringWakeArmed = false;
+	return true;
+}
+
+static void IOUringKill()
+{
+	// Closing the ring cancels everything outstanding.  Nothing
+	// the kernel knows about points at our sockets anymore.
+	s_ioUring.Kill();
+	for ( CRawUDPSocketImpl *pSock: s_vecRawSockets )
+		pSock->m_bIOUringRecvArmed = false;
+	for ( CRawUDPSocketImpl *pSock: s_vecRawSocketsPendingDeletion )
+		pSock->m_bIOUringRecvArmed = false;
+	s_vecIOUringSocketsToArm.Purge();
+	s_vecIOUringFreeSendSlots.Purge();
+	delete[] s_pIOUringSendSlots;
+	s_pIOUringSendSlots = nullptr;
+	s_bIOUringWakeArmed = false;
+}
+
+#endif
+
+static void FlushAllQueuedRawUDPSends()
+{
+	#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_SENDMMSG
+		for ( const CRawUDPSocketImpl *pSock: s_vecRawSocketsWithQueuedSends )
+			pSock->FlushQueuedSends();
+		s_vecRawSocketsWithQueuedSends.RemoveAll();
+	#endif
+
+	#ifdef STEAMNETWORKINGSOCKETS_IOURING
+		if ( s_ioUring.IsValid() )
+			IOUringSubmit();
+	#endif
+
+	#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_XDP
+		if ( s_xdp.IsValid() )
+			s_xdp.FlushTx();
+	#endif
+}
+
+/// Track packets that have fake lag applied and are pending to be sent/received
+class CPacketLagger : private IThinker
+{
+public:
+	~CPacketLagger() { Clear(); }
+
+	void LagPacket( bool bSend, const CRawUDPSocketImpl *pSock, const netadr_t &adr, int msDelay, int nChunks, const iovec *pChunks )
+	{
+		SteamDatagramTransportLock::AssertHeldByCurrentThread( "LagPacket" );
+
+		int cbPkt = 0;
+		for ( int i = 0 ; i < nChunks ; ++i )
+			cbPkt += pChunks[i].iov_len;
+		if ( cbPkt > k_cbSteamNetworkingSocketsMaxUDPMsgLen )
+		{
+			AssertMsg( false, "Tried to lag a packet that w as too big!" );
+			return;
+		}
+
+		// Make sure we never queue a packet that is queued for destruction!
+		if ( pSock->m_socket == INVALID_SOCKET || !pSock->m_callback.m_fnCallback )
+		{
+			AssertMsg( false, "Tried to lag a packet on a socket that has already been closed and is pending destruction!" );
+			return;
+		}
+
+		if ( msDelay < 1 )
+		{
+			AssertMsg( false, "Packet lag time must be positive!" );
+			msDelay = 1;
+		}
+
+		// Limit to something sane
+		msDelay = std::min( msDelay, 5000 );
+		const SteamNetworkingMicroseconds usecTime = SteamNetworkingSockets_GetLocalTimestamp() + msDelay * 1000;
 
 		// Find the right place to insert the packet.
 		LaggedPacket *pkt = nullptr;
@@ -665,6 +1831,8 @@ static CPacketLagger s_packetLagQueue;
 	static HANDLE s_hEventWakeThread = INVALID_HANDLE_VALUE;
 #elif defined( NN_NINTENDO_SDK )
 	static int s_hEventWakeThread = INVALID_SOCKET;
+#elif defined( STEAMNETWORKINGSOCKETS_LOWLEVEL_EVENTFD )
+	static int s_eventFDWakeThread = -1;
 #else
 	static SOCKET s_hSockWakeThreadRead = INVALID_SOCKET;
 	static SOCKET s_hSockWakeThreadWrite = INVALID_SOCKET;
@@ -672,6 +1840,13 @@ static CPacketLagger s_packetLagQueue;
 
 static std::thread *s_pThreadSteamDatagram = nullptr;
 
+/// True while whoever is polling (the service thread, or the app in manual
+/// poll mode) has released the lock to go to sleep.  Set just before releasing
+/// the lock, and cleared right after re-acquiring it.  So if you hold the lock
+/// and this is false, the poller will look at the thinker queue (and anything
+/// else that is protected by the lock) before it sleeps again.
+static std::atomic<bool> s_bPollerSleeping( false );
+
 void WakeSteamDatagramThread()
 {
 	#if defined( _WIN32 )
@@ -680,6 +1855,9 @@ void WakeSteamDatagramThread()
 	#elif defined( NN_NINTENDO_SDK )
 		// Sorry, but this code is covered under NDA with Nintendo, and
 		// we don't have permission to distribute it.
+	#elif defined( STEAMNETWORKINGSOCKETS_LOWLEVEL_EVENTFD )
+		if ( s_eventFDWakeThread >= 0 )
+			eventfd_write( s_eventFDWakeThread, 1 );
 	#else
 		if ( s_hSockWakeThreadWrite != INVALID_SOCKET )
 		{
@@ -689,6 +1867,25 @@ void WakeSteamDatagramThread()
 	#endif
 }
 
+void WakeSteamDatagramThreadIfSleeping()
+{
+	SteamDatagramTransportLock::AssertHeldByCurrentThread();
+	if ( s_bPollerSleeping.load( std::memory_order_acquire ) )
+		WakeSteamDatagramThread();
+}
+
+#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_EVENTFD
+/// Clear all pending wake requests with a single read.  This is safe because
+/// we only do it after re-acquiring the lock, before we look at anything that
+/// the waker might have wanted us to look at.  A request made after this
+/// will cause the next wait to return immediately.
+static void ClearWakeSteamDatagramThread()
+{
+	eventfd_t val;
+	eventfd_read( s_eventFDWakeThread, &val );
+}
+#endif
+
 bool IRawUDPSocket::BSendRawPacket( const void *pPkt, int cbPkt, const netadr_t &adrTo ) const
 {
 	iovec temp;
@@ -735,6 +1932,37 @@ bool IRawUDPSocket::BSendRawPacketGather( int nChunks, const iovec *pChunks, con
 		return true;
 	}
 
+	// Going out through AF_XDP?  Frames are already batched until we flush
+	#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_XDP
+		if ( self->m_bXDP && BXDPQueueSend( self->m_boundAddr.m_port, nChunks, pChunks, adrTo ) )
+			return true;
+	#endif
+
+	#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_SENDMMSG
+
+		// Batching sends?  When GSO is enabled, always queue as many as we can,
+		// so that we can find runs of packets to coalesce.
+		int nMaxBatch = std::min( g_Config_UDPSendBatchSize.Get(), k_nMaxSendBatch );
+		#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_UDP_GSO
+			if ( self->m_bUDPGSO && g_Config_UDPSendGSO.Get() )
+				nMaxBatch = k_nMaxSendBatch;
+		#endif
+		#ifdef STEAMNETWORKINGSOCKETS_IOURING
+			if ( s_ioUring.IsValid() )
+				nMaxBatch = 1; // Requests are already batched
+		#endif
+		if ( nMaxBatch > 1 )
+			return self->BQueueSendRawPacket( nChunks, pChunks, adrTo, nMaxBatch );
+
+		// Batching was just turned off?  Make sure we don't reorder
+		// packets that are still queued
+		if ( unlikely( self->BHasQueuedSends() ) )
+		{
+			self->FlushQueuedSends();
+			s_vecRawSocketsWithQueuedSends.FindAndFastRemove( self );
+		}
+	#endif
+
 	// Now really send it
 	return self->BReallySendRawPacket( nChunks, pChunks, adrTo );
 }
@@ -750,15 +1978,53 @@ void IRawUDPSocket::Close()
 	self->m_callback.m_fnCallback = nullptr;
 	Assert( self->m_socket != INVALID_SOCKET );
 
+	// Send anything still queued.  The caller expects that
+	// packets sent before closing will actually go out.
+	#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_SENDMMSG
+		if ( self->BHasQueuedSends() )
+		{
+			self->FlushQueuedSends();
+			s_vecRawSocketsWithQueuedSends.FindAndFastRemove( self );
+		}
+	#endif
+
+	#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_XDP
+		if ( self->m_bXDP )
+			XDPRemoveSocket( self );
+	#endif
+
 	DbgVerify( s_vecRawSockets.FindAndFastRemove( self ) );
 	DbgVerify( !s_vecRawSocketsPendingDeletion.FindAndFastRemove( self ) );
 	s_vecRawSocketsPendingDeletion.AddToTail( self );
 
+	// Stop receiving notifications for this socket
+	#ifdef STEAMNETWORKINGSOCKETS_IOURING
+		if ( s_ioUring.IsValid() )
+		{
+			// We won't be destroyed until the kernel confirms the recv is done
+			s_vecIOUringSocketsToArm.FindAndFastRemove( self );
+			if ( self->m_bIOUringRecvArmed )
+				IOUringCancelRecv( self );
+		}
+		else
+	#endif
+	{
+		#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_EPOLL
+			if ( epoll_ctl( s_epollFD, EPOLL_CTL_DEL, self->m_socket, nullptr ) != 0 )
+				AssertMsg1( false, "epoll_ctl(EPOLL_CTL_DEL) failed.  Error code 0x%08x.", GetLastSocketError() );
+		#endif
+	}
+
 	// Clean up lagged packets, if any
 	s_packetLagQueue.AboutToDestroySocket( self );
 
 	// Make sure we don't delay doing this too long
-	if ( s_bManualPollMode || ( s_pThreadSteamDatagram && s_pThreadSteamDatagram->get_id() != std::this_thread::get_id() ) )
+	if ( s_bDispatchingRawUDPPackets )
+	{
+		// We're being called from a callback while the service thread is
+		// dispatching packets.  It will clean up when it's done.
+	}
+	else if ( s_bManualPollMode || ( s_pThreadSteamDatagram && s_pThreadSteamDatagram->get_id() != std::this_thread::get_id() ) )
 	{
 		// Another thread might be polling right now
 		WakeSteamDatagramThread();
@@ -770,7 +2036,7 @@ void IRawUDPSocket::Close()
 	}
 }
 
-static SOCKET OpenUDPSocketBoundToSockAddr( const void *sockaddr, size_t len, SteamDatagramErrMsg &errMsg, int *pnIPv6AddressFamilies )
+static SOCKET OpenUDPSocketBoundToSockAddr( const void *sockaddr, size_t len, SteamDatagramErrMsg &errMsg, int *pnIPv6AddressFamilies, int nOpenFlags, int *pnSocketFlags )
 {
 	unsigned int opt;
 
@@ -821,7 +2087,58 @@ static SOCKET OpenUDPSocketBoundToSockAddr( const void *sockaddr, size_t len, St
 		return INVALID_SOCKET;
 	}
 
-	// Handle IP v6 dual stack?
+	// Optional features
+	*pnSocketFlags = 0;
+
+	// Ask the kernel to coalesce received datagrams?
+	#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_UDP_GRO
+		bool bGRO = g_Config_UDPRecvGRO.Get() != 0;
+		#ifdef STEAMNETWORKINGSOCKETS_IOURING
+			if ( s_ioUring.IsValid() )
+				bGRO = false; // Provided buffers are sized for a single datagram
+		#endif
+		if ( bGRO )
+		{
+			opt = 1;
+			if ( setsockopt( sock, IPPROTO_UDP, UDP_GRO, (char *)&opt, sizeof(opt) ) == 0 )
+				*pnSocketFlags |= k_nRawUDPSocketFlag_GRO;
+			else
+				SpewVerbose( "Failed to enable UDP_GRO.  Error code 0x%08x.  Continuing without it.\n", GetLastSocketError() );
+		}
+	#endif
+
+	// Ask the kernel to busy poll the device when we try to receive?
+	#if defined( LINUX ) && defined( SO_BUSY_POLL )
+		if ( g_Config_UDPSocketBusyPoll.Get() > 0 )
+		{
+			opt = g_Config_UDPSocketBusyPoll.Get();
+			if ( setsockopt( sock, SOL_SOCKET, SO_BUSY_POLL, (char *)&opt, sizeof(opt) ) != 0 )
+				SpewVerbose( "Failed to set SO_BUSY_POLL.  Error code 0x%08x.  Continuing without it.\n", GetLastSocketError() );
+		}
+	#endif
+
+	// Ask the kernel to tell us when it drops datagrams because we are falling behind
+	#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_RXQ_OVFL
+		opt = 1;
+		if ( setsockopt( sock, SOL_SOCKET, SO_RXQ_OVFL, (char *)&opt, sizeof(opt) ) == 0 )
+			*pnSocketFlags |= k_nRawUDPSocketFlag_RxqOvfl;
+		else
+			SpewVerbose( "Failed to enable SO_RXQ_OVFL.  Error code 0x%08x.  Continuing without it.\n", GetLastSocketError() );
+	#endif
+
+	// Ask the kernel to tell us when each datagram arrived?
+	#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_RECV_TIMESTAMPS
+		if ( g_Config_UDPRecvKernelTimestamps.Get() )
+		{
+			opt = 1;
+			if ( setsockopt( sock, SOL_SOCKET, SO_TIMESTAMPNS, (char *)&opt, sizeof(opt) ) == 0 )
+				*pnSocketFlags |= k_nRawUDPSocketFlag_RecvTimestamp;
+			else
+				SpewVerbose( "Failed to enable SO_TIMESTAMPNS.  Error code 0x%08x.  Continuing without it.\n", GetLastSocketError() );
+		}
+	#endif
+
+	// Handle IP v6 dual stack?
 	if ( pnIPv6AddressFamilies )
 	{
 
@@ -856,6 +2173,23 @@ static SOCKET OpenUDPSocketBoundToSockAddr( const void *sockaddr, size_t len, St
 		}
 	}
 
+	// Share the port with other sockets?  This must be set on all of the
+	// sockets in the group, before they are bound.
+	if ( nOpenFlags & k_nRawUDPSocketOpen_ReusePort )
+	{
+		#ifdef LINUX
+			opt = 1;
+			if ( setsockopt( sock, SOL_SOCKET, SO_REUSEPORT, (char *)&opt, sizeof(opt) ) != 0 )
+			{
+				V_sprintf_safe( errMsg, "Failed to set SO_REUSEPORT.  Error code 0x%08x.", GetLastSocketError() );
+				closesocket( sock );
+				return INVALID_SOCKET;
+			}
+		#else
+			AssertMsg( false, "SO_REUSEPORT sharding not supported on this platform" );
+		#endif
+	}
+
 	// Bind it to specific desired port and/or interfaces
 	if ( bind( sock, (struct sockaddr *)sockaddr, (socklen_t)len ) == -1 )
 	{
@@ -868,7 +2202,7 @@ static SOCKET OpenUDPSocketBoundToSockAddr( const void *sockaddr, size_t len, St
 	return sock;
 }
 
-static CRawUDPSocketImpl *OpenRawUDPSocketInternal( CRecvPacketCallback callback, SteamDatagramErrMsg &errMsg, const SteamNetworkingIPAddr *pAddrLocal, int *pnAddressFamilies )
+static CRawUDPSocketImpl *OpenRawUDPSocketInternal( CRecvPacketCallback callback, SteamDatagramErrMsg &errMsg, const SteamNetworkingIPAddr *pAddrLocal, int *pnAddressFamilies, int nOpenFlags )
 {
 	// Creating a socket *should* be fast, but sometimes the OS might need to do some work.
 	// We shouldn't do this too often, give it a little extra time.
@@ -930,6 +2264,7 @@ static CRawUDPSocketImpl *OpenRawUDPSocketInternal( CRecvPacketCallback callback
 
 	// Try IPv6?
 	SOCKET sock = INVALID_SOCKET;
+	int nSocketFlags = 0;
 	if ( nAddressFamilies & k_nAddressFamily_IPv6 )
 	{
 		sockaddr_in6 address6;
@@ -940,7 +2275,7 @@ static CRawUDPSocketImpl *OpenRawUDPSocketInternal( CRecvPacketCallback callback
 
 		// Try to get socket
 		int nIPv6AddressFamilies = nAddressFamilies;
-		sock = OpenUDPSocketBoundToSockAddr( &address6, sizeof(address6), errMsg, &nIPv6AddressFamilies );
+		sock = OpenUDPSocketBoundToSockAddr( &address6, sizeof(address6), errMsg, &nIPv6AddressFamilies, nOpenFlags, &nSocketFlags );
 
 		if ( sock == INVALID_SOCKET )
 		{
@@ -968,7 +2303,7 @@ static CRawUDPSocketImpl *OpenRawUDPSocketInternal( CRecvPacketCallback callback
 		address4.sin_port = BigWord( addrLocal.m_port );
 
 		// Try to get socket
-		sock = OpenUDPSocketBoundToSockAddr( &address4, sizeof(address4), errMsg, nullptr );
+		sock = OpenUDPSocketBoundToSockAddr( &address4, sizeof(address4), errMsg, nullptr, nOpenFlags, &nSocketFlags );
 
 		// If we failed, well, we have no other options left to try.
 		if ( sock == INVALID_SOCKET )
@@ -1011,6 +2346,17 @@ static CRawUDPSocketImpl *OpenRawUDPSocketInternal( CRecvPacketCallback callback
 	pSock->m_boundAddr = addrLocal;
 	pSock->m_callback = callback;
 	pSock->m_nAddressFamilies = nAddressFamilies;
+	pSock->m_nSocketFlags = nSocketFlags;
+	pSock->m_cbRecvBuffer = g_nSteamDatagramSocketBufferSize;
+
+	// Check if the kernel supports UDP generic segmentation offload on this socket
+	#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_UDP_GSO
+	{
+		int nSegmentSize = 0;
+		socklen_t cbOpt = sizeof(nSegmentSize);
+		pSock->m_bUDPGSO = ( getsockopt( sock, IPPROTO_UDP, UDP_SEGMENT, (char *)&nSegmentSize, &cbOpt ) == 0 );
+	}
+	#endif
 
 	// On windows, create an event used to poll efficiently
 	#ifdef _WIN32
@@ -1023,11 +2369,41 @@ static CRawUDPSocketImpl *OpenRawUDPSocketInternal( CRecvPacketCallback callback
 		}
 	#endif
 
-	// Add to master list.  (Hopefully we usually won't have that many.)
+	// Using io_uring?  Then the polling thread will start a recv request
+	#ifdef STEAMNETWORKINGSOCKETS_IOURING
+		if ( s_ioUring.IsValid() )
+			s_vecIOUringSocketsToArm.AddToTail( pSock );
+		else
+	#endif
+
+	// Register with epoll.  Edge triggered, since we always drain
+	// the socket when we are notified.
+	#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_EPOLL
+	{
+		epoll_event ev;
+		memset( &ev, 0, sizeof(ev) );
+		ev.events = EPOLLIN | EPOLLET;
+		ev.data.ptr = pSock;
+		if ( epoll_ctl( s_epollFD, EPOLL_CTL_ADD, pSock->m_socket, &ev ) != 0 )
+		{
+			V_sprintf_safe( errMsg, "epoll_ctl(EPOLL_CTL_ADD) failed.  Error code 0x%08X.", GetLastSocketError() );
+			delete pSock;
+			return nullptr;
+		}
+	}
+	#endif
+
+	// Pull IPv4 datagrams for this socket off of the wire ourselves?
+	#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_XDP
+		if ( s_xdp.IsValid() )
+			XDPAddSocket( pSock );
+	#endif
+
+	// Add to master list
 	s_vecRawSockets.AddToTail( pSock );
 
 	// Wake up background thread so we can start receiving packets on this socket immediately
-	WakeSteamDatagramThread();
+	WakeSteamDatagramThreadIfSleeping();
 
 	// Give back info on address families
 	if ( pnAddressFamilies )
@@ -1037,21 +2413,832 @@ static CRawUDPSocketImpl *OpenRawUDPSocketInternal( CRecvPacketCallback callback
 	return pSock;
 }
 
-IRawUDPSocket *OpenRawUDPSocket( CRecvPacketCallback callback, SteamDatagramErrMsg &errMsg, SteamNetworkingIPAddr *pAddrLocal, int *pnAddressFamilies )
+IRawUDPSocket *OpenRawUDPSocket( CRecvPacketCallback callback, SteamDatagramErrMsg &errMsg, SteamNetworkingIPAddr *pAddrLocal, int *pnAddressFamilies, int nOpenFlags )
+{
+	return OpenRawUDPSocketInternal( callback, errMsg, pAddrLocal, pnAddressFamilies, nOpenFlags );
+}
+
+#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_RECVMMSG
+
+/// Max number of datagrams we will pull out of the kernel with a single recvmmsg call
+constexpr int k_nMaxRecvBatch = 32;
+
+#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_UDP_GRO
+
+/// When GRO is enabled, each datagram we receive might actually be a run of
+/// datagrams coalesced by the kernel, up to 64KB.  We use fewer, larger buffers
+constexpr int k_nMaxRecvBatchGRO = 8;
+constexpr int k_cbMaxGROPacket = 65536;
+
+#endif
+
+/// Buffer for control messages (ancillary data) received with a datagram.
+/// Big enough for the GRO segment size, a receive timestamp, and the drop counter
+union RecvControlMsg_t
+{
+	char m_buf[ CMSG_SPACE( sizeof(int) ) + CMSG_SPACE( sizeof(timespec) ) + CMSG_SPACE( sizeof(uint32) ) ];
+	cmsghdr m_align;
+};
+
+#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_RECV_TIMESTAMPS
+
+/// The kernel stamps datagrams using the realtime clock.  To convert to our
+/// clock, we need to read both clocks.  All the datagrams in a batch arrived
+/// before we started processing it, so we just read them once per batch.
+struct KernelRecvClock_t
+{
+	SteamNetworkingMicroseconds m_usecNow = 0; // 0 if we haven't read them yet
+	int64 m_usecRealtimeNow;
+};
+
+#endif
+
+/// Buffers used to receive a batch of datagrams.  These are only ever touched by
+/// whoever is polling the sockets, while holding the lock, so one static set is
+/// all we need.
+static struct RecvBatch_t
+{
+	mmsghdr m_msgs[ k_nMaxRecvBatch ];
+	iovec m_iov[ k_nMaxRecvBatch ];
+	sockaddr_storage m_from[ k_nMaxRecvBatch ];
+	RecvControlMsg_t m_control[ k_nMaxRecvBatch ];
+	#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_RECV_TIMESTAMPS
+		KernelRecvClock_t m_recvClock;
+	#endif
+	char m_pkt[ k_nMaxRecvBatch ][ k_cbSteamNetworkingSocketsMaxUDPMsgLen + 1024 ];
+
+	// Big buffers for sockets with GRO enabled.  Pages are only
+	// touched if GRO is actually used.
+	#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_UDP_GRO
+		char m_groPkt[ k_nMaxRecvBatchGRO ][ k_cbMaxGROPacket ];
+	#endif
+} s_recvBatch;
+
+/// Setup the batch buffers to receive on the specified socket.
+/// Returns the number of datagrams to request
+static int PrepareRecvBatch( const CRawUDPSocketImpl *pSock )
+{
+	int nBatch = k_nMaxRecvBatch;
+	bool bWantControl = false;
+	#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_UDP_GRO
+		const bool bGRO = ( pSock->m_nSocketFlags & k_nRawUDPSocketFlag_GRO ) != 0;
+		if ( bGRO )
+		{
+			nBatch = k_nMaxRecvBatchGRO;
+			bWantControl = true;
+		}
+	#endif
+	#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_RECV_TIMESTAMPS
+		if ( pSock->m_nSocketFlags & k_nRawUDPSocketFlag_RecvTimestamp )
+			bWantControl = true;
+		s_recvBatch.m_recvClock.m_usecNow = 0;
+	#endif
+	#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_RXQ_OVFL
+		if ( pSock->m_nSocketFlags & k_nRawUDPSocketFlag_RxqOvfl )
+			bWantControl = true;
+	#endif
+
+	for ( int i = 0 ; i < nBatch ; ++i )
+	{
+		iovec &iov = s_recvBatch.m_iov[i];
+		#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_UDP_GRO
+			if ( bGRO )
+			{
+				iov.iov_base = s_recvBatch.m_groPkt[i];
+				iov.iov_len = sizeof( s_recvBatch.m_groPkt[i] );
+			}
+			else
+		#endif
+		{
+			iov.iov_base = s_recvBatch.m_pkt[i];
+			iov.iov_len = sizeof( s_recvBatch.m_pkt[i] );
+		}
+
+		msghdr &hdr = s_recvBatch.m_msgs[i].msg_hdr;
+		hdr.msg_name = &s_recvBatch.m_from[i];
+		hdr.msg_namelen = sizeof( s_recvBatch.m_from[i] );
+		hdr.msg_iov = &iov;
+		hdr.msg_iovlen = 1;
+		if ( bWantControl )
+		{
+			hdr.msg_control = s_recvBatch.m_control[i].m_buf;
+			hdr.msg_controllen = sizeof( s_recvBatch.m_control[i].m_buf );
+		}
+		else
+		{
+			hdr.msg_control = nullptr;
+			hdr.msg_controllen = 0;
+		}
+		hdr.msg_flags = 0;
+	}
+
+	return nBatch;
+}
+
+#endif
+
+#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_RECV_TIMESTAMPS
+
+/// Receive timestamps older than this are assumed to be the result of the
+/// realtime clock being stepped, and are ignored
+constexpr SteamNetworkingMicroseconds k_usecMaxKernelRecvTimestampAge = k_nMillion;
+
+/// Locate the SO_TIMESTAMPNS receive timestamp in the control messages
+/// for a datagram, and convert it to our timebase.  Returns 0 if there
+/// isn't one, or it doesn't look right
+static SteamNetworkingMicroseconds GetKernelRecvTimestamp( const msghdr &msg, KernelRecvClock_t &clock )
+{
+	for ( cmsghdr *cm = CMSG_FIRSTHDR( &msg ) ; cm ; cm = CMSG_NXTHDR( const_cast<msghdr *>( &msg ), cm ) )
+	{
+		if ( cm->cmsg_level != SOL_SOCKET || cm->cmsg_type != SCM_TIMESTAMPNS )
+			continue;
+		timespec tsRecv;
+		memcpy( &tsRecv, CMSG_DATA( cm ), sizeof(tsRecv) );
+
+		// The kernel uses the realtime clock.  Measure how long ago that
+		// was, and then subtract that from our clock
+		if ( clock.m_usecNow == 0 )
+		{
+			timespec tsNow;
+			clock_gettime( CLOCK_REALTIME, &tsNow );
+			clock.m_usecNow = SteamNetworkingSockets_GetLocalTimestamp();
+			clock.m_usecRealtimeNow = int64( tsNow.tv_sec ) * k_nMillion + tsNow.tv_nsec / 1000;
+		}
+		int64 usecAge = clock.m_usecRealtimeNow - ( int64( tsRecv.tv_sec ) * k_nMillion + tsRecv.tv_nsec / 1000 );
+		if ( usecAge < 0 || usecAge > k_usecMaxKernelRecvTimestampAge )
+			return 0;
+		return clock.m_usecNow - usecAge;
+	}
+	return 0;
+}
+
+#endif
+
+#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_RXQ_OVFL
+
+/// Don't grow a socket's receive buffer more often than this.  Once a socket
+/// starts dropping, every datagram reports the total, and we want to give
+/// the bigger buffer a chance to help before growing it again.
+constexpr SteamNetworkingMicroseconds k_usecRecvBufferGrowInterval = 100*1000;
+
+/// Double the receive buffer of a socket that is dropping datagrams,
+/// up to k_ESteamNetworkingConfig_UDPRecvBufferMax
+static void GrowRecvBuffer( CRawUDPSocketImpl *pSock )
+{
+	const int cbMax = g_Config_UDPRecvBufferMax.Get();
+	if ( pSock->m_cbRecvBuffer >= cbMax )
+		return;
+	SteamNetworkingMicroseconds usecNow = SteamNetworkingSockets_GetLocalTimestamp();
+	if ( usecNow < pSock->m_usecRecvBufferGrown + k_usecRecvBufferGrowInterval )
+		return;
+	pSock->m_usecRecvBufferGrown = usecNow;
+
+	// SO_RCVBUF is silently capped at net.core.rmem_max.  SO_RCVBUFFORCE
+	// isn't, but requires CAP_NET_ADMIN.
+	int cbNew = (int)std::min( (int64)pSock->m_cbRecvBuffer * 2, (int64)cbMax );
+	if (
+		setsockopt( pSock->m_socket, SOL_SOCKET, SO_RCVBUFFORCE, (char *)&cbNew, sizeof(cbNew) ) != 0
+		&& setsockopt( pSock->m_socket, SOL_SOCKET, SO_RCVBUF, (char *)&cbNew, sizeof(cbNew) ) != 0
+	) {
+		SpewWarning( "Failed to grow socket recv buffer to %d.  Error code 0x%08x.\n", cbNew, GetLastSocketError() );
+		pSock->m_cbRecvBuffer = cbMax; // Don't keep trying
+		return;
+	}
+	SpewMsg( "Raw UDP socket %s has dropped %lld datagrams.  Grew recv buffer to %d.\n",
+		SteamNetworkingIPAddrRender( pSock->m_boundAddr ).c_str(), (long long)pSock->m_nKernelDrops, cbNew );
+	pSock->m_cbRecvBuffer = cbNew;
+}
+
+/// Locate the SO_RXQ_OVFL drop counter in the control messages for a
+/// datagram, and count any new drops.  (The kernel doesn't include it
+/// until the socket has dropped something.)
+static void CheckKernelDrops( CRawUDPSocketImpl *pSock, const msghdr &msg )
+{
+	for ( cmsghdr *cm = CMSG_FIRSTHDR( &msg ) ; cm ; cm = CMSG_NXTHDR( const_cast<msghdr *>( &msg ), cm ) )
+	{
+		if ( cm->cmsg_level != SOL_SOCKET || cm->cmsg_type != SO_RXQ_OVFL )
+			continue;
+		uint32 nReported;
+		memcpy( &nReported, CMSG_DATA( cm ), sizeof(nReported) );
+		int32 nNewDrops = int32( nReported - pSock->m_nKernelDropsReported );
+		if ( nNewDrops <= 0 )
+			return;
+		pSock->m_nKernelDropsReported = nReported;
+		pSock->m_nKernelDrops += nNewDrops;
+		s_udpStats.m_nKernelDrops += nNewDrops;
+		GrowRecvBuffer( pSock );
+		return;
+	}
+}
+
+#endif
+
+/// Time when the packet we are currently dispatching arrived, according
+/// to the kernel.  0 if we aren't dispatching one, or we don't know.
+static SteamNetworkingMicroseconds s_usecDispatchPacketRecvTime = 0;
+
+SteamNetworkingMicroseconds GetRawUDPPacketRecvTime( SteamNetworkingMicroseconds usecNow )
+{
+	SteamDatagramTransportLock::AssertHeldByCurrentThread();
+	if ( s_usecDispatchPacketRecvTime > 0 && s_usecDispatchPacketRecvTime <= usecNow )
+		return s_usecDispatchPacketRecvTime;
+	return usecNow;
+}
+
+void RawUDPPacketAuthenticated()
+{
+	SteamDatagramTransportLock::AssertHeldByCurrentThread();
+	#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_XDP
+		if ( s_pXDPDispatchFrame )
+			XDPConfirmRoute( *s_pXDPDispatchFrame, s_usecXDPDispatchFrame );
+	#endif
+}
+
+/// Process a single datagram that we pulled off of a socket.  Apply fake loss,
+/// lag, etc, and dispatch it to the socket's callback.  usecRecvTime is when the
+/// kernel says it arrived, or 0 if we don't know
+static void ProcessRawUDPPacket( CRawUDPSocketImpl *pSock, char *pPkt, int cbPkt, const sockaddr_storage &from, SteamNetworkingMicroseconds usecRecvTime )
+{
+	#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_TIME_SOCKET_CALLS
+		SteamNetworkingMicroseconds usecProcessPacketStart = SteamNetworkingSockets_GetLocalTimestamp();
+	#endif
+
+	// Add a tag.  If we end up holding the lock for a long time, this tag
+	// will tell us how many packets were processed
+	SteamDatagramTransportLock::AddTag( "RecvUDPPacket" );
+	++pSock->m_nRecvPackets;
+
+	// Check for simulating random packet loss
+	if ( RandomBoolWithOdds( g_Config_FakePacketLoss_Recv.Get() ) )
+		return;
+
+	netadr_t adr;
+	adr.SetFromSockadr( &from );
+
+	// If we're dual stack, convert mapped IPv4 back to ordinary IPv4
+	if ( pSock->m_nAddressFamilies == k_nAddressFamily_DualStack )
+		adr.BConvertMappedToIPv4();
+
+	int32 nPacketFakeLagTotal = g_Config_FakePacketLag_Recv.Get();
+
+	// Check for simulating random packet reordering
+	if ( RandomBoolWithOdds( g_Config_FakePacketReorder_Recv.Get() ) )
+	{
+		nPacketFakeLagTotal += g_Config_FakePacketReorder_Time.Get();
+	}
+
+	// Check for simulating random packet duplication
+	if ( RandomBoolWithOdds( g_Config_FakePacketDup_Recv.Get() ) )
+	{
+		int32 nDupLag = nPacketFakeLagTotal + WeakRandomInt( 0, g_Config_FakePacketDup_TimeMax.Get() );
+		nDupLag = std::max( 1, nDupLag );
+		iovec temp;
+		temp.iov_len = cbPkt;
+		temp.iov_base = pPkt;
+		s_packetLagQueue.LagPacket( false, pSock, adr, nDupLag, 1, &temp );
+	}
+
+	// Check for simulating lag
+	if ( nPacketFakeLagTotal > 0 )
+	{
+		iovec temp;
+		temp.iov_len = cbPkt;
+		temp.iov_base = pPkt;
+		s_packetLagQueue.LagPacket( false, pSock, adr, nPacketFakeLagTotal, 1, &temp );
+	}
+	else
+	{
+		ETW_UDPRecvPacket( adr, cbPkt );
+
+		//const uint8 *pbPkt = (const uint8 *)pPkt;
+		//Log_Detailed( LOG_STEAMDATAGRAM_CLIENT, "%s -> %4db %02x %02x %02x %02x %02x ...\n",
+		//	CUtlNetAdrRender( adr ).String(), cbPkt, pbPkt[0], pbPkt[1], pbPkt[2], pbPkt[3], pbPkt[4] );
+
+		const SteamNetworkingMicroseconds usecPrevRecvTime = s_usecDispatchPacketRecvTime;
+		s_usecDispatchPacketRecvTime = usecRecvTime;
+		pSock->m_callback( pPkt, cbPkt, adr );
+		s_usecDispatchPacketRecvTime = usecPrevRecvTime;
+	}
+
+	#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_TIME_SOCKET_CALLS
+		SteamNetworkingMicroseconds usecProcessPacketEnd = SteamNetworkingSockets_GetLocalTimestamp();
+		if ( usecProcessPacketEnd > s_usecIgnoreLongLockWaitTimeUntil )
+		{
+			SteamNetworkingMicroseconds usecProcessPacketElapsed = usecProcessPacketEnd - usecProcessPacketStart;
+			if ( usecProcessPacketElapsed > 1000 )
+			{
+				SpewWarning( "process packet took %.1fms\n", usecProcessPacketElapsed*1e-3 );
+				ETW_LongOp( "process packet", usecProcessPacketElapsed );
+			}
+		}
+	#endif
+}
+
+#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_XDP
+
+/// Dispatch everything on the AF_XDP receive ring.  The payload is passed
+/// to the callback right where the NIC (or the kernel, in copy mode) put it.
+/// Returns false if we noticed a shutdown request.
+static bool XDPProcessRecv()
+{
+	CXDPSocket::RecvFrame_t frames[ k_nMaxXDPRecvBatch ];
+	for (;;)
+	{
+		const int nFrames = s_xdp.ReceiveFrames( frames, k_nMaxXDPRecvBatch );
+		if ( nFrames <= 0 )
+			return true;
+		++s_udpStats.m_nRecvCalls;
+		s_usecXDPDispatchFrame = SteamNetworkingSockets_GetLocalTimestamp();
+
+		for ( int i = 0 ; i < nFrames ; ++i )
+		{
+			XDPUDPFrame_t frame;
+			if ( !XDPParseUDPFrame( frames[i].m_pData, frames[i].m_cbData, frame ) )
+				continue;
+
+			// Socket might have been closed after the frame was redirected
+			CRawUDPSocketImpl **ppSock = s_mapXDPPorts.FindGetPtr( frame.m_nDstPort );
+			if ( !ppSock || !(*ppSock)->m_callback.m_fnCallback )
+				continue;
+
+			sockaddr_storage from;
+			memset( &from, 0, sizeof(sockaddr_in) );
+			sockaddr_in *from4 = (sockaddr_in *)&from;
+			from4->sin_family = AF_INET;
+			from4->sin_addr.s_addr = BigDWord( frame.m_nSrcIP );
+			from4->sin_port = BigWord( frame.m_nSrcPort );
+
+			// If the packet is authenticated, we'll remember how to send back to them
+			++s_udpStats.m_nRecvPackets;
+			s_pXDPDispatchFrame = &frame;
+			ProcessRawUDPPacket( *ppSock, (char *)frame.m_pPayload, frame.m_cbPayload, from, 0 );
+			s_pXDPDispatchFrame = nullptr;
+		}
+
+		if ( s_nLowLevelSupportRefCount.load(std::memory_order_acquire) <= 0 || !s_xdp.IsValid() )
+			return false;
+		s_xdp.RecycleRecvFrames( frames, nFrames );
+	}
+}
+
+#endif
+
+#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_RECVMMSG
+
+/// Process one message that was received into the batch buffers.  If the
+/// kernel coalesced several datagrams, split them back up.
+static void ProcessRecvBatchMsg( CRawUDPSocketImpl *pSock, int idx )
+{
+	const mmsghdr &msg = s_recvBatch.m_msgs[ idx ];
+	char *pPkt = (char *)s_recvBatch.m_iov[ idx ].iov_base;
+	int cbRemaining = (int)msg.msg_len;
+	int cbSegment = cbRemaining;
+
+	#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_UDP_GRO
+		if ( pSock->m_nSocketFlags & k_nRawUDPSocketFlag_GRO )
+		{
+			for ( cmsghdr *cm = CMSG_FIRSTHDR( &msg.msg_hdr ) ; cm ; cm = CMSG_NXTHDR( const_cast<msghdr *>( &msg.msg_hdr ), cm ) )
+			{
+				if ( cm->cmsg_level == IPPROTO_UDP && cm->cmsg_type == UDP_GRO )
+				{
+					int nSegmentSize;
+					memcpy( &nSegmentSize, CMSG_DATA( cm ), sizeof(nSegmentSize) );
+					if ( nSegmentSize > 0 )
+						cbSegment = nSegmentSize;
+				}
+			}
+		}
+	#endif
+
+	// When did it arrive?  All segments share the same timestamp
+	SteamNetworkingMicroseconds usecRecvTime = 0;
+	#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_RECV_TIMESTAMPS
+		if ( pSock->m_nSocketFlags & k_nRawUDPSocketFlag_RecvTimestamp )
+			usecRecvTime = GetKernelRecvTimestamp( msg.msg_hdr, s_recvBatch.m_recvClock );
+	#endif
+
+	#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_RXQ_OVFL
+		if ( pSock->m_nSocketFlags & k_nRawUDPSocketFlag_RxqOvfl )
+			CheckKernelDrops( pSock, msg.msg_hdr );
+	#endif
+
+	// Dispatch each segment.  (Usually there is just one.)  Note that
+	// a zero byte datagram is dispatched, just like any other bogus packet
+	do
+	{
+		int cbPkt = std::min( cbSegment, cbRemaining );
+		++s_udpStats.m_nRecvPackets;
+		ProcessRawUDPPacket( pSock, pPkt, cbPkt, s_recvBatch.m_from[ idx ], usecRecvTime );
+		pPkt += cbPkt;
+		cbRemaining -= cbPkt;
+	} while ( cbRemaining > 0 && pSock->m_callback.m_fnCallback );
+}
+
+#endif
+
+/// Re-acquire the lock after the service thread wakes up.  Returns false
+/// if we detected a shutdown request, in which case we don't hold the lock.
+static bool BRelockAfterPoll( bool bManualPoll )
+{
+	SteamNetworkingMicroseconds usecStartedLocking = SteamNetworkingSockets_GetLocalTimestamp();
+	for (;;)
+	{
+
+		// Shutdown request?  We've potentially been waiting a long time.
+		// Don't attempt to grab the lock again if we know we want to shutdown,
+		// that is just a waste of time.
+		if ( s_nLowLevelSupportRefCount.load(std::memory_order_acquire) <= 0 || s_bManualPollMode != bManualPoll )
+			return false;
+
+		// Try to acquire the lock.  But don't wait forever, in case the other thread has the lock
+		// and then makes a shutdown request while we're waiting on the lock here.
+		if ( SteamDatagramTransportLock::TryLock( "ServiceThread", 250 ) )
+		{
+			s_bPollerSleeping.store( false, std::memory_order_relaxed );
+			break;
+		}
+
+		// The only time this really should happen is a relatively rare race condition
+		// where the main thread is trying to shut us down.  (Or while debugging.)
+		// However, note that try_lock_for is permitted to "fail" spuriously, returning
+		// false even if no other thread holds the lock.  (For performance reasons.)
+		// So we check how long we have actually been waiting.
+		SteamNetworkingMicroseconds usecElapsed = SteamNetworkingSockets_GetLocalTimestamp() - usecStartedLocking;
+		AssertMsg1( usecElapsed < 50*1000 || s_nLowLevelSupportRefCount.load(std::memory_order_acquire) <= 0 || s_bManualPollMode != bManualPoll || Plat_IsInDebugSession(), "SDR service thread gave up on lock after waiting %dms.  This directly adds to delay of processing of network packets!", int( usecElapsed/1000 ) );
+	}
+	return true;
+}
+
+/// Drain a socket that was reported as readable, and dispatch the packets received.
+/// Returns false if we detected a shutdown request.
+static bool DrainRawUDPSocket( CRawUDPSocketImpl *pSock )
+{
+	// Drain the socket.  But if the callback gets cleared, that
+	// indicates that the socket is pending destruction and is
+	// logically closed to the calling code.
+	while ( pSock->m_callback.m_fnCallback )
+	{
+		if ( s_nLowLevelSupportRefCount.load(std::memory_order_acquire) <= 0 )
+			return false;
+
+		#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_TIME_SOCKET_CALLS
+			SteamNetworkingMicroseconds usecRecvFromStart = SteamNetworkingSockets_GetLocalTimestamp();
+		#endif
+
+		#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_RECVMMSG
+			const int nBatch = PrepareRecvBatch( pSock );
+			int ret = ::recvmmsg( pSock->m_socket, s_recvBatch.m_msgs, nBatch, 0, nullptr );
+		#else
+			char buf[ k_cbSteamNetworkingSocketsMaxUDPMsgLen + 1024 ];
+			sockaddr_storage from;
+			socklen_t fromlen = sizeof(from);
+			int ret = ::recvfrom( pSock->m_socket, buf, sizeof( buf ), 0, (sockaddr *)&from, &fromlen );
+		#endif
+
+		#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_TIME_SOCKET_CALLS
+			SteamNetworkingMicroseconds usecRecvFromEnd = SteamNetworkingSockets_GetLocalTimestamp();
+			if ( usecRecvFromEnd > s_usecIgnoreLongLockWaitTimeUntil )
+			{
+				SteamNetworkingMicroseconds usecRecvFromElapsed = usecRecvFromEnd - usecRecvFromStart;
+				if ( usecRecvFromElapsed > 1000 )
+				{
+					SpewWarning( "recvfrom took %.1fms\n", usecRecvFromElapsed*1e-3 );
+					ETW_LongOp( "UDP recvfrom", usecRecvFromElapsed );
+				}
+			}
+		#endif
+
+		// Negative value means nothing more to read.
+		//
+		// NOTE 1: We're not checking the cause of failure.  Usually it would be "EWOULDBLOCK",
+		// meaning no more data.  However if there was some socket error (i.e. somebody did something
+		// to reset the network stack, etc) we could make the code more robust by detecting this.
+		// It would require us plumbing through this failure somehow, and all we have here is a callback
+		// for processing packets.  Probably not worth the effort to handle this relatively common case.
+		// It will just appear to the app that the cord is cut on this socket.
+		//
+		// NOTE 2: 0 byte datagram is possible, and in this case recvfrom will return 0.
+		// (But all of our protocols enforce a minimum packet size, so if we get a zero byte packet,
+		// it's a bogus.  We could drop it here but let's send it through the normal mechanism to
+		// be handled/reported in the same way as any other bogus packet.)
+		if ( ret < 0 )
+			break;
+
+		++s_udpStats.m_nRecvCalls;
+
+		#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_RECVMMSG
+
+			// recvmmsg returns the number of messages received
+			for ( int i = 0 ; i < ret ; ++i )
+			{
+				// Socket closed by the callback for a previous packet in this batch?
+				// Or shutdown requested?  Then discard the rest.
+				if ( !pSock->m_callback.m_fnCallback )
+					break;
+				if ( s_nLowLevelSupportRefCount.load(std::memory_order_acquire) <= 0 )
+					return false;
+
+				ProcessRecvBatchMsg( pSock, i );
+			}
+
+			// If we didn't fill the batch, then the queue was empty when we
+			// made the call.  Don't waste a system call just to find out
+			// that there is nothing more.  If anything else arrived in the
+			// meantime, the next poll will return immediately.  (This is true
+			// even with edge-triggered epoll.  Each arrival is a new edge.)
+			if ( ret < nBatch )
+				break;
+		#else
+			++s_udpStats.m_nRecvPackets;
+			ProcessRawUDPPacket( pSock, buf, ret, from, 0 );
+		#endif
+	}
+
+	return true;
+}
+
+#ifdef STEAMNETWORKINGSOCKETS_IOURING
+
+#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_RECV_TIMESTAMPS
+/// Clocks for converting receive timestamps, read once per pass over the completion queue
+static KernelRecvClock_t s_ioUringRecvClock;
+#endif
+
+/// Process a packet received into a provided buffer by a multishot recvmsg
+static void IOUringProcessRecvBuffer( CRawUDPSocketImpl *pSock, char *pBuf, int cbBuf )
+{
+	// The buffer contains a header, then space for the address and control
+	// data we asked for, and then the payload
+	const msghdr &msg = pSock->m_ioUringRecvMsg;
+	const int cbHeaders = int( sizeof(io_uring_recvmsg_out) + msg.msg_namelen + msg.msg_controllen );
+	if ( cbBuf < cbHeaders )
+	{
+		AssertMsg2( false, "io_uring recvmsg returned %d bytes, expected at least %d", cbBuf, cbHeaders );
+		return;
+	}
+	io_uring_recvmsg_out out;
+	memcpy( &out, pBuf, sizeof(out) );
+
+	sockaddr_storage from;
+	memset( &from, 0, sizeof(from) );
+	memcpy( &from, pBuf + sizeof(io_uring_recvmsg_out), std::min( (size_t)out.namelen, sizeof(from) ) );
+
+	// If the datagram didn't fit, it was truncated.  Just like recvfrom,
+	// we'll let the upper layers reject it.
+	int cbPkt = std::min( (int)out.payloadlen, cbBuf - cbHeaders );
+
+	// Receive timestamp and drop counter are in the control data, right after the address
+	SteamNetworkingMicroseconds usecRecvTime = 0;
+	#if defined( STEAMNETWORKINGSOCKETS_LOWLEVEL_RECV_TIMESTAMPS ) || defined( STEAMNETWORKINGSOCKETS_LOWLEVEL_RXQ_OVFL )
+		if ( msg.msg_controllen > 0 )
+		{
+			msghdr msgControl;
+			memset( &msgControl, 0, sizeof(msgControl) );
+			msgControl.msg_control = pBuf + sizeof(io_uring_recvmsg_out) + msg.msg_namelen;
+			msgControl.msg_controllen = std::min( (size_t)out.controllen, (size_t)msg.msg_controllen );
+			#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_RECV_TIMESTAMPS
+				if ( pSock->m_nSocketFlags & k_nRawUDPSocketFlag_RecvTimestamp )
+					usecRecvTime = GetKernelRecvTimestamp( msgControl, s_ioUringRecvClock );
+			#endif
+			#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_RXQ_OVFL
+				if ( pSock->m_nSocketFlags & k_nRawUDPSocketFlag_RxqOvfl )
+					CheckKernelDrops( pSock, msgControl );
+			#endif
+		}
+	#endif
+
+	++s_udpStats.m_nRecvPackets;
+	ProcessRawUDPPacket( pSock, pBuf + cbHeaders, cbPkt, from, usecRecvTime );
+}
+
+/// Reap the completion queue.  Returns false if we detected a shutdown request.
+static bool IOUringProcessCompletions()
+{
+	bool bReceivedAny = false;
+	bool bResult = true;
+	#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_RECV_TIMESTAMPS
+		s_ioUringRecvClock.m_usecNow = 0;
+	#endif
+	while ( io_uring_cqe *cqe = s_ioUring.PeekCQE() )
+	{
+		// Copy out what we need and release the entry.  Processing a packet
+		// might queue up more requests
+		const uint64 nUserData = cqe->user_data;
+		const int nResult = cqe->res;
+		const unsigned nFlags = cqe->flags;
+		s_ioUring.AdvanceCQ();
+
+		switch ( nUserData & k_nIOUringOpMask )
+		{
+			case k_EIOUringOp_Recv:
+			{
+				CRawUDPSocketImpl *pSock = (CRawUDPSocketImpl *)(uintptr_t)( nUserData & ~k_nIOUringOpMask );
+				if ( nFlags & IORING_CQE_F_BUFFER )
+				{
+					int nBufferID = nFlags >> IORING_CQE_BUFFER_SHIFT;
+
+					// Ignore packets for sockets that have been closed, and
+					// anything after we've been asked to shutdown
+					if ( bResult && s_nLowLevelSupportRefCount.load(std::memory_order_acquire) <= 0 )
+						bResult = false;
+					if ( nResult > 0 && bResult && pSock->m_callback.m_fnCallback )
+					{
+						bReceivedAny = true;
+						IOUringProcessRecvBuffer( pSock, s_ioUring.GetBuffer( nBufferID ), nResult );
+					}
+					s_ioUring.RecycleBuffer( nBufferID );
+				}
+
+				// Request terminated?  This happens if we ran out of buffers,
+				// or the request was cancelled.  If the socket is still open,
+				// start another one
+				if ( !( nFlags & IORING_CQE_F_MORE ) )
+				{
+					Assert( pSock->m_bIOUringRecvArmed );
+					pSock->m_bIOUringRecvArmed = false;
+					if ( pSock->m_callback.m_fnCallback )
+					{
+						if ( nResult < 0 && nResult != -ENOBUFS && nResult != -ECANCELED )
+							SpewWarning( "io_uring recvmsg failed.  Error code %d.  Restarting.\n", -nResult );
+						s_vecIOUringSocketsToArm.AddToTail( pSock );
+					}
+				}
+			} break;
+
+			case k_EIOUringOp_Send:
+			{
+				int idxSlot = int( nUserData >> 2 );
+				Assert( idxSlot >= 0 && idxSlot < k_nIOUringSendSlots );
+				s_vecIOUringFreeSendSlots.AddToTail( idxSlot );
+			} break;
+
+			case k_EIOUringOp_Wake:
+			{
+				// Clear all wake requests.  Unlike poll(), we might
+				// not be notified again for requests already queued,
+				// and we're going to service everything anyway
+				ClearWakeSteamDatagramThread();
+				if ( !( nFlags & IORING_CQE_F_MORE ) )
+					s_bIOUringWakeArmed = false;
+			} break;
+
+			case k_EIOUringOp_Cancel:
+				break;
+		}
+	}
+
+	if ( bReceivedAny )
+		++s_udpStats.m_nRecvCalls;
+	return bResult;
+}
+
+/// Wait on the io_uring completion queue, instead of polling our
+/// sockets, and process whatever completed.  Same return value
+/// as PollRawUDPSockets.
+static bool PollRawUDPSocketsIOUring( SteamNetworkingMicroseconds usecMaxTimeout, bool bManualPoll )
+{
+	// Start requests that need starting.  We have to do this from the
+	// polling thread, since that's the thread that will receive the completions
+	if ( !s_bIOUringWakeArmed )
+		IOUringArmWake( s_eventFDWakeThread );
+	if ( s_vecIOUringSocketsToArm.Count() > 0 )
+	{
+		CUtlVector<CRawUDPSocketImpl *> vecToArm;
+		vecToArm.Swap( s_vecIOUringSocketsToArm );
+		for ( CRawUDPSocketImpl *pSock: vecToArm )
+		{
+			if ( pSock->m_callback.m_fnCallback && !pSock->m_bIOUringRecvArmed )
+				IOUringArmRecv( pSock );
+		}
+	}
+
+	// Release lock while we're asleep.  This submits everything we queued
+	s_bPollerSleeping.store( true, std::memory_order_release );
+	SteamDatagramTransportLock::Unlock();
+
+	// Shutdown request?
+	if ( s_nLowLevelSupportRefCount.load(std::memory_order_acquire) <= 0 || s_bManualPollMode != bManualPoll )
+		return false; // ABORT THREAD
+
+	// Wait for something to complete.  (Or to be asked to wake up.)
+	s_ioUring.WaitForCompletion( usecMaxTimeout );
+
+	if ( !BRelockAfterPoll( bManualPoll ) )
+		return false;
+
+	// Process completions.  A callback might close a socket that we are
+	// about to process, so destruction must be deferred until we are done.
+	s_bDispatchingRawUDPPackets = true;
+	IOUringProcessCompletions();
+	s_bDispatchingRawUDPPackets = false;
+
+	// We retained the lock
+	return true;
+}
+
+#endif
+
+/// Convert a timeout to milliseconds, for wait functions that don't have
+/// anything better.  We assume the scheduler only has 1ms precision, so we
+/// round to the nearest ms, so that we don't always wake up exactly 1ms
+/// early, go to sleep and wait for 1ms.  But a nonzero timeout is at least 1ms.
+static int TimeoutUsecToMS( SteamNetworkingMicroseconds usecTimeout )
+{
+	if ( usecTimeout <= 0 )
+		return 0;
+	return std::max( 1, int( ( usecTimeout + 500 ) / 1000 ) );
+}
+
+#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_EPOLL
+
+/// Wait on our epoll set, with microsecond precision if the kernel supports it
+static int EpollWaitUsec( epoll_event *pEvents, int nMaxEvents, SteamNetworkingMicroseconds usecTimeout )
 {
-	return OpenRawUDPSocketInternal( callback, errMsg, pAddrLocal, pnAddressFamilies );
+	#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_EPOLL_PWAIT2
+		static std::atomic<bool> s_bEpollPWait2Supported( true );
+		if ( s_bEpollPWait2Supported.load( std::memory_order_relaxed ) )
+		{
+			timespec ts;
+			usecTimeout = std::max( usecTimeout, (SteamNetworkingMicroseconds)0 );
+			ts.tv_sec = usecTimeout / k_nMillion;
+			ts.tv_nsec = ( usecTimeout % k_nMillion ) * 1000;
+			int r = (int)syscall( __NR_epoll_pwait2, s_epollFD, pEvents, nMaxEvents, &ts, nullptr, 0 );
+			if ( r >= 0 || errno != ENOSYS )
+				return r;
+			SpewVerbose( "epoll_pwait2 not supported.  Service thread will sleep with millisecond precision.\n" );
+			s_bEpollPWait2Supported = false;
+		}
+	#endif
+	return epoll_wait( s_epollFD, pEvents, nMaxEvents, TimeoutUsecToMS( usecTimeout ) );
+}
+
+/// Drain the sockets that epoll says are ready, and execute the callbacks.
+/// (If the wait failed, e.g. EINTR, then nEvents is negative.)  Returns
+/// false if we detected a shutdown request.  We still own the lock either way.
+static bool DispatchEpollEvents( const epoll_event *pEvents, int nEvents )
+{
+	// Note that a callback might close a socket that we are about to drain, so
+	// destruction must be deferred until we are done.
+	bool bResult = true;
+	s_bDispatchingRawUDPPackets = true;
+	for ( int idx = 0 ; idx < nEvents ; ++idx )
+	{
+		CRawUDPSocketImpl *pSock = (CRawUDPSocketImpl *)pEvents[ idx ].data.ptr;
+		if ( !pSock )
+		{
+			// It's a wake request.  Clear all of them at once
+			ClearWakeSteamDatagramThread();
+			continue;
+		}
+		#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_XDP
+			if ( pEvents[ idx ].data.ptr == &s_xdp )
+			{
+				if ( !XDPProcessRecv() )
+				{
+					bResult = false;
+					break;
+				}
+				continue;
+			}
+		#endif
+
+		// Closed by a callback while we were processing an earlier socket?
+		if ( !pSock->m_callback.m_fnCallback )
+			continue;
+
+		if ( !DrainRawUDPSocket( pSock ) )
+		{
+			bResult = false;
+			break;
+		}
+	}
+	s_bDispatchingRawUDPPackets = false;
+	return bResult;
 }
 
+#endif
+
 /// Poll all of our sockets, and dispatch the packets received.
 /// This will return true if we own the lock, or false if we detected
 /// a shutdown request and bailed without re-squiring the lock.
-static bool PollRawUDPSockets( int nMaxTimeoutMS, bool bManualPoll )
+static bool PollRawUDPSockets( SteamNetworkingMicroseconds usecMaxTimeout, bool bManualPoll )
 {
 	// This should only ever be called from our one thread proc,
 	// and we assume that it will have locked the lock exactly once.
 	SteamDatagramTransportLock::AssertHeldByCurrentThread();
 	Assert( SteamDatagramTransportLock::s_nLocked == 1 );
 
+	#ifdef STEAMNETWORKINGSOCKETS_IOURING
+		if ( s_ioUring.IsValid() )
+			return PollRawUDPSocketsIOUring( usecMaxTimeout, bManualPoll );
+	#endif
+
+	// With epoll, our sockets are already registered, so there's nothing to setup
+	#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_EPOLL
+		Assert( s_epollFD >= 0 );
+		epoll_event epollEvents[ k_nMaxEpollEvents ];
+	#else
+
 	const int nSocketsToPoll = s_vecRawSockets.Count();
 
 	#ifdef _WIN32
@@ -1101,7 +3288,10 @@ static bool PollRawUDPSockets( int nMaxTimeoutMS, bool bManualPoll )
 		p->revents = 0;
 	#endif
 
+	#endif // #ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_EPOLL
+
 	// Release lock while we're asleep
+	s_bPollerSleeping.store( true, std::memory_order_release );
 	SteamDatagramTransportLock::Unlock();
 
 	// Shutdown request?
@@ -1110,38 +3300,27 @@ static bool PollRawUDPSockets( int nMaxTimeoutMS, bool bManualPoll )
 
 	// Wait for data on one of the sockets, or for us to be asked to wake up
 	#if defined( WIN32 )
-		DWORD nWaitResult = WaitForMultipleObjects( nEvents, pEvents, FALSE, nMaxTimeoutMS );
+		DWORD nWaitResult = WaitForMultipleObjects( nEvents, pEvents, FALSE, TimeoutUsecToMS( usecMaxTimeout ) );
+	#elif defined( STEAMNETWORKINGSOCKETS_LOWLEVEL_EPOLL )
+		int nEpollEvents = EpollWaitUsec( epollEvents, k_nMaxEpollEvents, usecMaxTimeout );
 	#else
-		poll( pPollFDs, nPollFDs, nMaxTimeoutMS );
+		poll( pPollFDs, nPollFDs, TimeoutUsecToMS( usecMaxTimeout ) );
 	#endif
 
-	SteamNetworkingMicroseconds usecStartedLocking = SteamNetworkingSockets_GetLocalTimestamp();
-	for (;;)
-	{
-
-		// Shutdown request?  We've potentially been waiting a long time.
-		// Don't attempt to grab the lock again if we know we want to shutdown,
-		// that is just a waste of time.
-		if ( s_nLowLevelSupportRefCount.load(std::memory_order_acquire) <= 0 || s_bManualPollMode != bManualPoll )
-			return false;
-
-		// Try to acquire the lock.  But don't wait forever, in case the other thread has the lock
-		// and then makes a shutdown request while we're waiting on the lock here.
-		if ( SteamDatagramTransportLock::TryLock( "ServiceThread", 250 ) )
-			break;
+	if ( !BRelockAfterPoll( bManualPoll ) )
+		return false;
 
-		// The only time this really should happen is a relatively rare race condition
-		// where the main thread is trying to shut us down.  (Or while debugging.)
-		// However, note that try_lock_for is permitted to "fail" spuriously, returning
-		// false even if no other thread holds the lock.  (For performance reasons.)
-		// So we check how long we have actually been waiting.
-		SteamNetworkingMicroseconds usecElapsed = SteamNetworkingSockets_GetLocalTimestamp() - usecStartedLocking;
-		AssertMsg1( usecElapsed < 50*1000 || s_nLowLevelSupportRefCount.load(std::memory_order_acquire) <= 0 || s_bManualPollMode != bManualPoll || Plat_IsInDebugSession(), "SDR service thread gave up on lock after waiting %dms.  This directly adds to delay of processing of network packets!", int( usecElapsed/1000 ) );
-	}
+	// With epoll, we only get the sockets that are actually ready
+	#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_EPOLL
+		DispatchEpollEvents( epollEvents, nEpollEvents );
+		return true; // We retained the lock
+	#else
 
 	// Recv socket data from any sockets that might have data, and execute the callbacks.
-	char buf[ k_cbSteamNetworkingSocketsMaxUDPMsgLen + 1024 ];
-#ifdef _WIN32
+	// Note that a callback might close a socket that we are about to drain, so
+	// destruction must be deferred until we are done.
+	s_bDispatchingRawUDPPackets = true;
+#if defined( _WIN32 )
 	// Note that we assume we aren't polling a ton of sockets here.  We do at least skip ahead
 	// to the first socket with data, based on the return value of WaitForMultipleObjects.  But
 	// then we will check all sockets later in the array.
@@ -1171,148 +3350,51 @@ static bool PollRawUDPSockets( int nMaxTimeoutMS, bool bManualPoll )
 			// It's a wake request.  Pull a single packet out of the queue.
 			// We want one wake request to always result in exactly one wake up.
 			// Wake request are relatively rare, and we don't want to skip any
-			// or combine them.  That would result in complicated race conditions
-			// where we stay asleep a lot longer than we should.
-			#ifdef NN_NINTENDO_SDK
-				// Sorry, but this code is covered under NDA with Nintendo, and
-				// we don't have permission to distribute it.
-			#else
-				Assert( pPollFDs[idx].fd == s_hSockWakeThreadRead );
-				::recv( s_hSockWakeThreadRead, buf, sizeof(buf), 0 );
-			#endif
-			continue;
-		}
-		CRawUDPSocketImpl *pSock = pSocketsToPoll[ idx ];
-#endif
-
-		// Drain the socket.  But if the callback gets cleared, that
-		// indicates that the socket is pending destruction and is
-		// logically closed to the calling code.
-		while ( pSock->m_callback.m_fnCallback )
-		{
-			if ( s_nLowLevelSupportRefCount.load(std::memory_order_acquire) <= 0 )
-				return true; // current thread owns the lock
-
-			#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_TIME_SOCKET_CALLS
-				SteamNetworkingMicroseconds usecRecvFromStart = SteamNetworkingSockets_GetLocalTimestamp();
-			#endif
-
-			sockaddr_storage from;
-			socklen_t fromlen = sizeof(from);
-			int ret = ::recvfrom( pSock->m_socket, buf, sizeof( buf ), 0, (sockaddr *)&from, &fromlen );
-
-			#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_TIME_SOCKET_CALLS
-				SteamNetworkingMicroseconds usecRecvFromEnd = SteamNetworkingSockets_GetLocalTimestamp();
-				if ( usecRecvFromEnd > s_usecIgnoreLongLockWaitTimeUntil )
-				{
-					SteamNetworkingMicroseconds usecRecvFromElapsed = usecRecvFromEnd - usecRecvFromStart;
-					if ( usecRecvFromElapsed > 1000 )
-					{
-						SpewWarning( "recvfrom took %.1fms\n", usecRecvFromElapsed*1e-3 );
-						ETW_LongOp( "UDP recvfrom", usecRecvFromElapsed );
-					}
-				}
-			#endif
-
-			// Negative value means nothing more to read.
-			//
-			// NOTE 1: We're not checking the cause of failure.  Usually it would be "EWOULDBLOCK",
-			// meaning no more data.  However if there was some socket error (i.e. somebody did something
-			// to reset the network stack, etc) we could make the code more robust by detecting this.
-			// It would require us plumbing through this failure somehow, and all we have here is a callback
-			// for processing packets.  Probably not worth the effort to handle this relatively common case.
-			// It will just appear to the app that the cord is cut on this socket.
-			//
-			// NOTE 2: 0 byte datagram is possible, and in this case recvfrom will return 0.
-			// (But all of our protocols enforce a minimum packet size, so if we get a zero byte packet,
-			// it's a bogus.  We could drop it here but let's send it through the normal mechanism to
-			// be handled/reported in the same way as any other bogus packet.)
-			if ( ret < 0 )
-				break;
-
-			// Add a tag.  If we end up holding the lock for a long time, this tag
-			// will tell us how many packets were processed
-			SteamDatagramTransportLock::AddTag( "RecvUDPPacket" );
-
-			// Check for simulating random packet loss
-			if ( RandomBoolWithOdds( g_Config_FakePacketLoss_Recv.Get() ) )
-				continue;
-
-			netadr_t adr;
-			adr.SetFromSockadr( &from );
-
-			// If we're dual stack, convert mapped IPv4 back to ordinary IPv4
-			if ( pSock->m_nAddressFamilies == k_nAddressFamily_DualStack )
-				adr.BConvertMappedToIPv4();
-
-			int32 nPacketFakeLagTotal = g_Config_FakePacketLag_Recv.Get();
-
-			// Check for simulating random packet reordering
-			if ( RandomBoolWithOdds( g_Config_FakePacketReorder_Recv.Get() ) )
-			{
-				nPacketFakeLagTotal += g_Config_FakePacketReorder_Time.Get();
-			}
-
-			// Check for simulating random packet duplication
-			if ( RandomBoolWithOdds( g_Config_FakePacketDup_Recv.Get() ) )
-			{
-				int32 nDupLag = nPacketFakeLagTotal + WeakRandomInt( 0, g_Config_FakePacketDup_TimeMax.Get() );
-				nDupLag = std::max( 1, nDupLag );
-				iovec temp;
-				temp.iov_len = ret;
-				temp.iov_base = buf;
-				s_packetLagQueue.LagPacket( false, pSock, adr, nDupLag, 1, &temp );
-			}
-
-			// Check for simulating lag
-			if ( nPacketFakeLagTotal > 0 )
-			{
-				iovec temp;
-				temp.iov_len = ret;
-				temp.iov_base = buf;
-				s_packetLagQueue.LagPacket( false, pSock, adr, nPacketFakeLagTotal, 1, &temp );
-			}
-			else
-			{
-				ETW_UDPRecvPacket( adr, ret );
-
-				//const uint8 *pbPkt = (const uint8 *)buf;
-				//Log_Detailed( LOG_STEAMDATAGRAM_CLIENT, "%s -> %4db %02x %02x %02x %02x %02x ...\n",
-				//	CUtlNetAdrRender( adr ).String(), ret, pbPkt[0], pbPkt[1], pbPkt[2], pbPkt[3], pbPkt[4] );
-
-				pSock->m_callback( buf, ret, adr );
-			}
-
-			#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_TIME_SOCKET_CALLS
-				SteamNetworkingMicroseconds usecProcessPacketEnd = SteamNetworkingSockets_GetLocalTimestamp();
-				if ( usecProcessPacketEnd > s_usecIgnoreLongLockWaitTimeUntil )
-				{
-					SteamNetworkingMicroseconds usecProcessPacketElapsed = usecProcessPacketEnd - usecRecvFromEnd;
-					if ( usecProcessPacketElapsed > 1000 )
-					{
-						SpewWarning( "process packet took %.1fms\n", usecProcessPacketElapsed*1e-3 );
-						ETW_LongOp( "process packet", usecProcessPacketElapsed );
-					}
-				}
+			// or combine them.  That would result in complicated race conditions
+			// where we stay asleep a lot longer than we should.
+			#ifdef NN_NINTENDO_SDK
+				// Sorry, but this code is covered under NDA with Nintendo, and
+				// we don't have permission to distribute it.
+			#else
+				Assert( pPollFDs[idx].fd == s_hSockWakeThreadRead );
+				char buf[ 16 ];
+				::recv( s_hSockWakeThreadRead, buf, sizeof(buf), 0 );
 			#endif
+			continue;
 		}
+		CRawUDPSocketImpl *pSock = pSocketsToPoll[ idx ];
+#endif
+
+		// Drain the socket
+		if ( !DrainRawUDPSocket( pSock ) )
+			break; // Shutdown request.  We still own the lock
 	}
+	s_bDispatchingRawUDPPackets = false;
 
 	// We retained the lock
 	return true;
+
+	#endif // #ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_EPOLL
 }
 
 void ProcessPendingDestroyClosedRawUDPSockets()
 {
 	SteamDatagramTransportLock::AssertHeldByCurrentThread();
 
-	for ( CRawUDPSocketImpl *pSock: s_vecRawSocketsPendingDeletion )
+	for ( int i = s_vecRawSocketsPendingDeletion.Count()-1 ; i >= 0 ; --i )
 	{
+		CRawUDPSocketImpl *pSock = s_vecRawSocketsPendingDeletion[ i ];
 		Assert( pSock->m_callback.m_fnCallback == nullptr );
+
+		// Still waiting for the kernel to finish with it?
+		#ifdef STEAMNETWORKINGSOCKETS_IOURING
+			if ( pSock->m_bIOUringRecvArmed )
+				continue;
+		#endif
+
 		delete pSock;
+		s_vecRawSocketsPendingDeletion.FastRemove( i );
 	}
-
-	s_vecRawSocketsPendingDeletion.RemoveAll();
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -1321,6 +3403,31 @@ void ProcessPendingDestroyClosedRawUDPSockets()
 //
 /////////////////////////////////////////////////////////////////////////////
 
+/// If the service thread is busy polling, keep going until this time.
+/// Only accessed while holding the lock.
+static SteamNetworkingMicroseconds s_usecBusyPollUntil = 0;
+
+/// Do everything that needs to happen after the sockets have been drained.
+/// We must hold the lock.  Returns the number of thinkers that were run.
+static int ProcessWorkAfterPoll()
+{
+	// Messages sent by other threads.  Do this first, so we
+	// can send them right away
+	ServiceLockFreeSendQueue();
+
+	// Check for periodic processing
+	const int nThinkers = Thinker_ProcessThinkers();
+
+	// Tasks that were queued to be run while we hold the lock
+	ISteamNetworkingSocketsRunWithLock::ServiceQueue();
+
+	// Close any sockets pending delete, if we discarded a server
+	// We can close the sockets safely now, because we know we're
+	// not polling on them and we know we hold the lock
+	ProcessPendingDestroyClosedRawUDPSockets();
+	return nThinkers;
+}
+
 //
 // Polling function.
 // On entry: lock is held *exactly once*
@@ -1332,53 +3439,65 @@ static bool SteamNetworkingSockets_InternalPoll( int msWait, bool bManualPoll )
 	SteamDatagramTransportLock::AssertHeldByCurrentThread(); // We should own the lock
 	Assert( SteamDatagramTransportLock::s_nLocked == 1 ); // exactly once
 
+	// Don't ever sleep for too long, just in case.  This timeout
+	// is long enough so that if we have a bug where we really need to
+	// be explicitly waking the thread for good perf, we will notice
+	// the delay.  But not so long that a bug in some rare 
+	// shutdown race condition (or the like) will be catastrophic
+	SteamNetworkingMicroseconds usecWait = SteamNetworkingMicroseconds( std::min( msWait, 5000 ) ) * 1000;
+
+	// Read the clock once for our own scheduling decisions in this pass.
+	// NOTE: We don't hand this time down to the packet handlers or thinkers.
+	// They (and things like fake lag) read the clock themselves as they go,
+	// and if some of them used an older time than others, then time would
+	// appear to go backwards.  (See Thinker_ProcessThinkers.)  Kernel receive
+	// timestamps are converted using one clock reading per receive batch.
+	SteamNetworkingMicroseconds usecNow = SteamNetworkingSockets_GetLocalTimestamp();
+
 	// Figure out how long to sleep
 	IThinker *pNextThinker = Thinker_GetNextScheduled();
 	if ( pNextThinker )
 	{
 
-		// Calc wait time to wake up as late as possible,
-		// rounded up to the nearest millisecond.
+		// Calc wait time to wake up as late as possible.  We pass the
+		// exact time down, and if the platform can't wait with that
+		// much precision, it will round it.
+		//
+		// NOTE: On windows, we could use an alertable timer, and presumably when
+		// we set the we could use a high precision relative time, and Windows could do
+		// smart stuff.
 		SteamNetworkingMicroseconds usecNextWakeTime = pNextThinker->GetNextThinkTime();
-		SteamNetworkingMicroseconds usecNow = SteamNetworkingSockets_GetLocalTimestamp();
 		int64 usecUntilNextThinkTime = usecNextWakeTime - usecNow;
 
-		if ( usecNow >= usecNextWakeTime )
+		// Earliest thinker in the queue is ready to go now, or so soon
+		// that the kernel probably can't wake us up on time?  Then
+		// don't go to sleep.  We'll just check the sockets and come
+		// right back here.
+		if ( usecUntilNextThinkTime <= g_Config_ServiceThreadSpinWindow.Get() )
 		{
-			// Earliest thinker in the queue is ready to go now.
-			// There is no point in going to sleep
-			msWait = 0;
+			usecWait = 0;
 		}
 		else
 		{
-
-			// Set wake time to wake up at the target time.  We assume the scheduler
-			// only has 1ms precision, so we round to the nearest ms, so that we don't
-			// always wake up exactly 1ms early, go to sleep and wait for 1ms.
-			//
-			// NOTE: On linux, we have a precise timer and we could probably do better
-			// than this.  On windows, we could use an alertable timer, and presumably when
-			// we set the we could use a high precision relative time, and Windows could do
-			// smart stuff.
-			int msTaskWait = ( usecUntilNextThinkTime + 500 ) / 1000;
-
-			// We must wait at least 1 ms
-			msTaskWait = std::max( 1, msTaskWait );
-
 			// Limit to what the caller has requested
-			msWait = std::min( msWait, msTaskWait );
+			usecWait = std::min( usecWait, usecUntilNextThinkTime );
 		}
 	}
 
-	// Don't ever sleep for too long, just in case.  This timeout
-	// is long enough so that if we have a bug where we really need to
-	// be explicitly waking the thread for good perf, we will notice
-	// the delay.  But not so long that a bug in some rare 
-	// shutdown race condition (or the like) will be catastrophic
-	msWait = std::min( msWait, 5000 );
+	// Busy polling?  Then don't sleep if we've had something to do recently
+	bool bBusyPoll = false;
+	if ( !bManualPoll && usecWait > 0 && g_Config_ServiceThreadBusyPoll.Get() > 0 )
+	{
+		if ( usecNow < s_usecBusyPollUntil )
+		{
+			usecWait = 0;
+			bBusyPoll = true;
+		}
+	}
+	const int64 nRecvPacketsBeforePoll = s_udpStats.m_nRecvPackets;
 
 	// Poll sockets
-	if ( !PollRawUDPSockets( msWait, bManualPoll ) )
+	if ( !PollRawUDPSockets( usecWait, bManualPoll ) )
 	{
 		// Shutdown request, and they did NOT re-acquire the lock
 		return false;
@@ -1394,16 +3513,34 @@ static bool SteamNetworkingSockets_InternalPoll( int msWait, bool bManualPoll )
 		return false; // Shutdown request, we have released the lock
 	}
 
-	// Check for periodic processing
-	Thinker_ProcessThinkers();
-
-	// Tasks that were queued to be run while we hold the lock
-	ISteamNetworkingSocketsRunWithLock::ServiceQueue();
+	// Did we find anything to do?  If so, keep busy polling for a while
+	if ( !bManualPoll && g_Config_ServiceThreadBusyPoll.Get() > 0 )
+	{
+		usecNow = SteamNetworkingSockets_GetLocalTimestamp(); // We might have slept
+		bool bDidWork = s_udpStats.m_nRecvPackets != nRecvPacketsBeforePoll;
+		if ( !bDidWork )
+		{
+			IThinker *pThinker = Thinker_GetNextScheduled();
+			bDidWork = pThinker && pThinker->GetNextThinkTime() <= usecNow;
+		}
+		if ( bDidWork )
+			s_usecBusyPollUntil = usecNow + g_Config_ServiceThreadBusyPoll.Get();
+		if ( bBusyPoll )
+		{
+			++s_udpStats.m_nBusyPollSpins;
+			if ( bDidWork )
+				++s_udpStats.m_nBusyPollUseful;
+		}
+	}
 
-	// Close any sockets pending delete, if we discarded a server
-	// We can close the sockets safely now, because we know we're
-	// not polling on them and we know we hold the lock
-	ProcessPendingDestroyClosedRawUDPSockets();
+	// Keep track of how often we actually sleep, and why we woke up
+	const int nThinkers = ProcessWorkAfterPoll();
+	if ( usecWait > 0 )
+	{
+		++s_udpStats.m_nWakeups;
+		if ( nThinkers > 0 )
+			++s_udpStats.m_nThinkerWakeups;
+	}
 	return true;
 }
 
@@ -1414,33 +3551,10 @@ static void SteamNetworkingThreadProc()
 	// we need to take priority above normal threads and wake up immediately
 	// to process the packet.  We should be asleep most of the time waiting
 	// for packets to arrive.
+	// (On other platforms, this is done once we hold the lock and
+	// can read the config.  See ApplyThreadSettings.)
 	#if defined(_WIN32)
 		DbgVerify( SetThreadPriority( GetCurrentThread(), THREAD_PRIORITY_HIGHEST ) );
-	#elif defined(POSIX)
-		// This probably won't work on Linux, because you cannot raise thread priority
-		// without being root.  But on some systems it works.  So we try, and if it
-		// works, great.
-		struct sched_param sched;
-		int policy;
-		pthread_t thread = pthread_self();
-		if ( pthread_getschedparam(thread, &policy, &sched) == 0 )
-		{
-			// Make sure we're not already at max.  No matter what, we don't
-			// want to lower our priority!  On linux, it appears that what happens
-			// is that the current and max priority values here are 0.
-			int max_priority = sched_get_priority_max(policy);
-			//printf( "pthread_getschedparam worked, policy=%d, pri=%d, max_pri=%d\n", policy, sched.sched_priority, max_priority );
-			if ( max_priority > sched.sched_priority )
-			{
-
-				// Determine new priority.
-				int min_priority = sched_get_priority_min(policy);
-				sched.sched_priority = std::max( sched.sched_priority+1, (min_priority + max_priority*3) / 4 );
-
-				// Try to set it
-				pthread_setschedparam( thread, policy, &sched );
-			}
-		}
 	#endif
 
 	#if defined(_WIN32) && !defined(__GNUC__)
@@ -1472,8 +3586,8 @@ static void SteamNetworkingThreadProc()
 		}
 
 	#else
-		// Help!  Really we should do this for all platforms.  Seems it's not
-		// totally straightforward the correct way to do this on Linux.
+		// On Linux, the name is set by ApplyThreadSettings.  Help!  Really
+		// we should do this for all platforms.
 	#endif
 
 	// In the loop, we will always hold global lock while we're awake.
@@ -1485,6 +3599,13 @@ static void SteamNetworkingThreadProc()
 			return;
 	} while ( !SteamDatagramTransportLock::TryLock( "ServiceThread", 10 ) );
 
+	// Set our name, affinity, and scheduling policy
+	{
+		ThreadSettings_t settings;
+		GetThreadSettings( settings, g_Config_ServiceThreadAffinity.Get() );
+		ApplyThreadSettings( settings );
+	}
+
 	// Random number generator may be per thread!  Make sure and see it for
 	// this thread, if so
 	SeedWeakRandomGenerator();
@@ -1577,7 +3698,7 @@ IBoundUDPSocket *OpenUDPSocketBoundToHost( const netadr_t &adrRemote, CRecvPacke
 
 	// Create a socket, bind it to the desired local address
 	CDedicatedBoundSocket *pTempContext = nullptr; // don't yet know the context
-	CRawUDPSocketImpl *pRawSock = OpenRawUDPSocketInternal( CRecvPacketCallback( DedicatedBoundSocketCallback, pTempContext ), errMsg, nullptr, &nAddressFamilies );
+	CRawUDPSocketImpl *pRawSock = OpenRawUDPSocketInternal( CRecvPacketCallback( DedicatedBoundSocketCallback, pTempContext ), errMsg, nullptr, &nAddressFamilies, 0 );
 	if ( !pRawSock )
 		return nullptr;
 
@@ -1600,11 +3721,11 @@ bool CreateBoundSocketPair( CRecvPacketCallback callback1, CRecvPacketCallback c
 	uint32 nLocalIP = 0x7f000001; // 127.0.0.1
 	CDedicatedBoundSocket *pTempContext = nullptr; // don't yet know the context
 	localAddr.SetIPv4( nLocalIP, 0 );
-	pRawSock[0] = OpenRawUDPSocketInternal( CRecvPacketCallback( DedicatedBoundSocketCallback, pTempContext ), errMsg, &localAddr, nullptr );
+	pRawSock[0] = OpenRawUDPSocketInternal( CRecvPacketCallback( DedicatedBoundSocketCallback, pTempContext ), errMsg, &localAddr, nullptr, 0 );
 	if ( !pRawSock[0] )
 		return false;
 	localAddr.SetIPv4( nLocalIP, 0 );
-	pRawSock[1] = OpenRawUDPSocketInternal( CRecvPacketCallback( DedicatedBoundSocketCallback, pTempContext ), errMsg, &localAddr, nullptr );
+	pRawSock[1] = OpenRawUDPSocketInternal( CRecvPacketCallback( DedicatedBoundSocketCallback, pTempContext ), errMsg, &localAddr, nullptr, 0 );
 	if ( !pRawSock[1] )
 	{
 		delete pRawSock[0];
@@ -1625,7 +3746,9 @@ bool CreateBoundSocketPair( CRecvPacketCallback callback1, CRecvPacketCallback c
 
 CSharedSocket::CSharedSocket()
 {
-	m_pRawSock = nullptr;
+	m_nShards = 0;
+	m_pRawSockRecv = nullptr;
+	m_nConnectionIDTableCount = 0;
 }
 
 CSharedSocket::~CSharedSocket()
@@ -1633,28 +3756,82 @@ CSharedSocket::~CSharedSocket()
 	Kill();
 }
 
-void CSharedSocket::CallbackRecvPacket( const void *pPkt, int cbPkt, const netadr_t &adrFrom, CSharedSocket *pSock )
+void CSharedSocket::CallbackRecvPacket( const void *pPkt, int cbPkt, const netadr_t &adrFrom, Shard *pShard )
 {
-	// Locate the client
-	int idx = pSock->m_mapRemoteHosts.Find( adrFrom );
+	CSharedSocket *pSock = pShard->m_pOwner;
+
+	// Data packets are the most common, and tell us who they are for.
+	// Try to route them by connection ID without hashing the address.
+	// The address must still match, so this is purely a faster path
+	// to the same answer as the map lookup.
+	RemoteHost *pHost = nullptr;
+	const uint8 *pbPkt = static_cast<const uint8 *>( pPkt );
+	if (
+		pSock->m_nConnectionIDTableCount > 0
+		&& cbPkt >= k_cbSharedSocketDataPacketConnectionIDOffset + (int)sizeof(uint32)
+		&& ( *pbPkt & k_nSharedSocketDataPacketLeadBit )
+	) {
+		uint32 unConnectionID;
+		memcpy( &unConnectionID, pbPkt + k_cbSharedSocketDataPacketConnectionIDOffset, sizeof(unConnectionID) );
+		pHost = pSock->FindRemoteHostByConnectionID( LittleDWord( unConnectionID ) );
+		if ( pHost && pHost->m_adr != adrFrom )
+			pHost = nullptr;
+	}
+
+	// Locate the client by address
+	if ( !pHost )
+	{
+		int idx = pSock->m_mapRemoteHosts.Find( adrFrom );
+		if ( idx != pSock->m_mapRemoteHosts.InvalidIndex() )
+			pHost = pSock->m_mapRemoteHosts[ idx ];
+	}
 
 	// Select the callback to invoke, ether client-specific, or the default
-	const CRecvPacketCallback &callback = ( idx == pSock->m_mapRemoteHosts.InvalidIndex() ) ? pSock->m_callbackDefault : pSock->m_mapRemoteHosts[ idx ]->m_callback;
+	const CRecvPacketCallback &callback = pHost ? pHost->m_callback : pSock->m_callbackDefault;
+
+	// Remember which shard it arrived on, so that any replies, or a remote
+	// host added in response, will use the same one.  (Don't touch pSock
+	// after the callback, it's possible for it to be destroyed.)
+	pSock->m_pRawSockRecv = pShard->m_pRawSock;
 
 	// Execute the callback
 	callback( pPkt, cbPkt, adrFrom );
 }
 
-bool CSharedSocket::BInit( const SteamNetworkingIPAddr &localAddr, CRecvPacketCallback callbackDefault, SteamDatagramErrMsg &errMsg )
+bool CSharedSocket::BInit( const SteamNetworkingIPAddr &localAddr, int nShards, CRecvPacketCallback callbackDefault, SteamDatagramErrMsg &errMsg )
 {
 	SteamDatagramTransportLock::AssertHeldByCurrentThread();
 
 	Kill();
 
+	nShards = std::max( 1, std::min( nShards, k_nMaxSharedSocketShards ) );
+	#ifndef LINUX
+		if ( nShards > 1 )
+		{
+			SpewWarning( "Sharding a socket across %d SO_REUSEPORT sockets is not supported on this platform.  Using a single socket.\n", nShards );
+			nShards = 1;
+		}
+	#endif
+	const int nOpenFlags = ( nShards > 1 ) ? k_nRawUDPSocketOpen_ReusePort : 0;
+
+	// Open the first socket.  The rest must bind to exactly the
+	// same address and port, so use what it actually got.
 	SteamNetworkingIPAddr bindAddr = localAddr;
-	m_pRawSock = OpenRawUDPSocket( CRecvPacketCallback( CallbackRecvPacket, this ), errMsg, &bindAddr, nullptr );
-	if ( m_pRawSock == nullptr )
-		return false;
+	int nAddressFamilies = k_nAddressFamily_Auto;
+	for ( int i = 0 ; i < nShards ; ++i )
+	{
+		Shard &shard = m_arShards[i];
+		shard.m_pOwner = this;
+		shard.m_pRawSock = OpenRawUDPSocket( CRecvPacketCallback( CallbackRecvPacket, &shard ), errMsg, &bindAddr, &nAddressFamilies, nOpenFlags );
+		if ( shard.m_pRawSock == nullptr )
+		{
+			Kill();
+			return false;
+		}
+		++m_nShards;
+		if ( i == 0 )
+			bindAddr.m_port = shard.m_pRawSock->m_boundAddr.m_port;
+	}
 
 	m_callbackDefault = callbackDefault;
 	return true;
@@ -1665,21 +3842,27 @@ void CSharedSocket::Kill()
 	SteamDatagramTransportLock::AssertHeldByCurrentThread();
 
 	m_callbackDefault.m_fnCallback = nullptr;
-	if ( m_pRawSock )
+	for ( int i = 0 ; i < m_nShards ; ++i )
 	{
-		m_pRawSock->Close();
-		m_pRawSock = nullptr;
+		m_arShards[i].m_pRawSock->Close();
+		m_arShards[i].m_pRawSock = nullptr;
 	}
+	m_nShards = 0;
+	m_pRawSockRecv = nullptr;
 	FOR_EACH_HASHMAP( m_mapRemoteHosts, idx )
 	{
 		CloseRemoteHostByIndex( idx );
 	}
+	Assert( m_nConnectionIDTableCount == 0 );
+	m_vecConnectionIDTable.Purge();
+	m_nConnectionIDTableCount = 0;
 }
 
 void CSharedSocket::CloseRemoteHostByIndex( int idx )
 {
 	SteamDatagramTransportLock::AssertHeldByCurrentThread();
 
+	RemoveConnectionID( m_mapRemoteHosts[ idx ] );
 	delete m_mapRemoteHosts[ idx ];
 	m_mapRemoteHosts[idx] = nullptr; // just for grins
 	m_mapRemoteHosts.RemoveAt( idx );
@@ -1694,7 +3877,9 @@ IBoundUDPSocket *CSharedSocket::AddRemoteHost( const netadr_t &adrRemote, CRecvP
 		AssertMsg1( false, "Already talking to %s on this shared socket, cannot add another remote host!", CUtlNetAdrRender( adrRemote ).String() );
 		return nullptr;
 	}
-	RemoteHost *pRemoteHost = new RemoteHost( m_pRawSock, adrRemote );
+
+	// Talk to them on the shard that their traffic arrives on
+	RemoteHost *pRemoteHost = new RemoteHost( GetSendShard(), adrRemote );
 	pRemoteHost->m_pOwner = this;
 	pRemoteHost->m_callback = callback;
 	m_mapRemoteHosts.Insert( adrRemote, pRemoteHost );
@@ -1702,6 +3887,109 @@ IBoundUDPSocket *CSharedSocket::AddRemoteHost( const netadr_t &adrRemote, CRecvP
 	return pRemoteHost;
 }
 
+void CSharedSocket::SetRemoteHostConnectionID( IBoundUDPSocket *pBoundSock, uint32 unConnectionIDLocal )
+{
+	SteamDatagramTransportLock::AssertHeldByCurrentThread();
+
+	RemoteHost *pHost = static_cast<RemoteHost *>( pBoundSock );
+	if ( !pHost || pHost->m_pOwner != this )
+	{
+		AssertMsg( false, "Remote host doesn't belong to this shared socket!" );
+		return;
+	}
+
+	RemoveConnectionID( pHost );
+	pHost->m_unConnectionIDLocal = unConnectionIDLocal;
+	if ( unConnectionIDLocal )
+		InsertConnectionID( pHost );
+}
+
+CSharedSocket::RemoteHost *CSharedSocket::FindRemoteHostByConnectionID( uint32 unConnectionID ) const
+{
+	if ( unConnectionID == 0 || m_nConnectionIDTableCount == 0 )
+		return nullptr;
+	const uint32 nMask = (uint32)m_vecConnectionIDTable.Count() - 1;
+	for ( uint32 i = unConnectionID & nMask ;; i = ( i+1 ) & nMask )
+	{
+		const ConnectionIDSlot &slot = m_vecConnectionIDTable[ i ];
+		if ( slot.m_unConnectionID == unConnectionID )
+			return slot.m_pHost;
+		if ( slot.m_unConnectionID == 0 )
+			return nullptr;
+	}
+}
+
+void CSharedSocket::InsertConnectionID( RemoteHost *pHost )
+{
+	Assert( pHost->m_unConnectionIDLocal );
+
+	// Grow, keeping the table no more than half full
+	if ( ( m_nConnectionIDTableCount + 1 ) * 2 > m_vecConnectionIDTable.Count() )
+	{
+		CUtlVector<ConnectionIDSlot> vecOld;
+		vecOld.Swap( m_vecConnectionIDTable );
+		int nNewSize = std::max( 64, vecOld.Count()*2 );
+		m_vecConnectionIDTable.SetCount( nNewSize );
+		memset( m_vecConnectionIDTable.Base(), 0, nNewSize * sizeof(ConnectionIDSlot) );
+		m_nConnectionIDTableCount = 0;
+		for ( const ConnectionIDSlot &slot: vecOld )
+		{
+			if ( slot.m_unConnectionID )
+				InsertConnectionID( slot.m_pHost );
+		}
+	}
+
+	const uint32 nMask = (uint32)m_vecConnectionIDTable.Count() - 1;
+	uint32 i = pHost->m_unConnectionIDLocal & nMask;
+	while ( m_vecConnectionIDTable[ i ].m_unConnectionID != 0 )
+	{
+		AssertMsg( m_vecConnectionIDTable[ i ].m_unConnectionID != pHost->m_unConnectionIDLocal, "Duplicate connection ID on shared socket" );
+		i = ( i+1 ) & nMask;
+	}
+	m_vecConnectionIDTable[ i ].m_unConnectionID = pHost->m_unConnectionIDLocal;
+	m_vecConnectionIDTable[ i ].m_pHost = pHost;
+	++m_nConnectionIDTableCount;
+}
+
+void CSharedSocket::RemoveConnectionID( RemoteHost *pHost )
+{
+	if ( pHost->m_unConnectionIDLocal == 0 || m_nConnectionIDTableCount == 0 )
+		return;
+
+	const uint32 nMask = (uint32)m_vecConnectionIDTable.Count() - 1;
+	uint32 i = pHost->m_unConnectionIDLocal & nMask;
+	for (;;)
+	{
+		ConnectionIDSlot &slot = m_vecConnectionIDTable[ i ];
+		if ( slot.m_unConnectionID == 0 )
+		{
+			AssertMsg( false, "CSharedSocket connection ID table corruption!" );
+			return;
+		}
+		if ( slot.m_pHost == pHost )
+			break;
+		i = ( i+1 ) & nMask;
+	}
+
+	// Backward shift deletion, so that lookups never need tombstones.
+	// Pull up any later entry in the run whose home slot doesn't
+	// lie cyclically in (hole, entry].
+	uint32 nHole = i;
+	for ( uint32 j = ( i+1 ) & nMask ; m_vecConnectionIDTable[ j ].m_unConnectionID != 0 ; j = ( j+1 ) & nMask )
+	{
+		uint32 nHome = m_vecConnectionIDTable[ j ].m_unConnectionID & nMask;
+		if ( ( ( j - nHome ) & nMask ) >= ( ( j - nHole ) & nMask ) )
+		{
+			m_vecConnectionIDTable[ nHole ] = m_vecConnectionIDTable[ j ];
+			nHole = j;
+		}
+	}
+	m_vecConnectionIDTable[ nHole ].m_unConnectionID = 0;
+	m_vecConnectionIDTable[ nHole ].m_pHost = nullptr;
+	--m_nConnectionIDTableCount;
+	pHost->m_unConnectionIDLocal = 0;
+}
+
 void CSharedSocket::RemoteHost::Close()
 {
 	SteamDatagramTransportLock::AssertHeldByCurrentThread();
@@ -1879,6 +4167,16 @@ bool BSteamNetworkingSocketsLowLevelAddRef( SteamDatagramErrMsg &errMsg )
 		#elif defined( NN_NINTENDO_SDK )
 			// Sorry, but this code is covered under NDA with Nintendo, and
 			// we don't have permission to distribute it.
+		#else
+		#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_EVENTFD
+			Assert( s_eventFDWakeThread < 0 );
+			s_eventFDWakeThread = eventfd( 0, EFD_CLOEXEC | EFD_NONBLOCK );
+			if ( s_eventFDWakeThread < 0 )
+			{
+				V_sprintf_safe( errMsg, "eventfd() call failed.  Error code 0x%08x.", GetLastSocketError() );
+				return false;
+			}
+			const int fdWake = s_eventFDWakeThread;
 		#else
 			Assert( s_hSockWakeThreadRead == INVALID_SOCKET );
 			Assert( s_hSockWakeThreadWrite == INVALID_SOCKET );
@@ -1907,6 +4205,93 @@ bool BSteamNetworkingSocketsLowLevelAddRef( SteamDatagramErrMsg &errMsg )
 			{
 				AssertMsg1( false, "Failed to set socket nonblocking mode.  Error code 0x%08x.", GetLastSocketError() );
 			}
+			const SOCKET fdWake = s_hSockWakeThreadRead;
+		#endif
+
+			// Create the epoll instance that we will register all of our sockets with.
+			// The wake object is registered level-triggered, with a null pointer.
+			#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_EPOLL
+				Assert( s_epollFD < 0 );
+				s_epollFD = epoll_create1( EPOLL_CLOEXEC );
+				if ( s_epollFD < 0 )
+				{
+					V_sprintf_safe( errMsg, "epoll_create1() call failed.  Error code 0x%08x.", GetLastSocketError() );
+				}
+				else
+				{
+					epoll_event ev;
+					memset( &ev, 0, sizeof(ev) );
+					ev.events = EPOLLIN;
+					ev.data.ptr = nullptr;
+					if ( epoll_ctl( s_epollFD, EPOLL_CTL_ADD, fdWake, &ev ) != 0 )
+					{
+						V_sprintf_safe( errMsg, "epoll_ctl(EPOLL_CTL_ADD) failed for wake object.  Error code 0x%08x.", GetLastSocketError() );
+						close( s_epollFD );
+						s_epollFD = -1;
+					}
+				}
+				if ( s_epollFD < 0 )
+				{
+					#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_EVENTFD
+						close( s_eventFDWakeThread );
+						s_eventFDWakeThread = -1;
+					#else
+						closesocket( s_hSockWakeThreadRead );
+						s_hSockWakeThreadRead = INVALID_SOCKET;
+						closesocket( s_hSockWakeThreadWrite );
+						s_hSockWakeThreadWrite = INVALID_SOCKET;
+					#endif
+					return false;
+				}
+			#endif
+
+			// Use io_uring, if requested and the kernel supports it
+			#ifdef STEAMNETWORKINGSOCKETS_IOURING
+				if ( g_Config_UDPIOUring.Get() )
+				{
+					SteamDatagramErrMsg errMsgIOUring;
+					if ( BIOUringInit( errMsgIOUring ) )
+						SpewMsg( "Using io_uring for raw UDP sockets.\n" );
+					else
+						SpewMsg( "io_uring not available (%s).  Falling back to ordinary socket calls.\n", errMsgIOUring );
+				}
+			#endif
+
+			// Bypass the kernel stack with AF_XDP?  The socket is drained by
+			// the service thread, so it doesn't mix with io_uring.
+			#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_XDP
+				if ( !g_Config_XDP_Interface.Get().empty() )
+				{
+					const char *pszInterface = g_Config_XDP_Interface.Get().c_str();
+					SteamDatagramErrMsg errMsgXDP;
+					bool bOK = false;
+					#ifdef STEAMNETWORKINGSOCKETS_IOURING
+						if ( s_ioUring.IsValid() )
+							V_strcpy_safe( errMsgXDP, "Can't be used with io_uring" );
+						else
+					#endif
+					if ( s_xdp.BInit( pszInterface, g_Config_XDP_Queue.Get(), errMsgXDP ) )
+					{
+						epoll_event ev;
+						memset( &ev, 0, sizeof(ev) );
+						ev.events = EPOLLIN; // Level triggered
+						ev.data.ptr = &s_xdp;
+						if ( epoll_ctl( s_epollFD, EPOLL_CTL_ADD, s_xdp.GetFD(), &ev ) == 0 )
+						{
+							bOK = true;
+						}
+						else
+						{
+							V_sprintf_safe( errMsgXDP, "epoll_ctl(EPOLL_CTL_ADD) failed.  Error code 0x%08x.", GetLastSocketError() );
+							s_xdp.Kill();
+						}
+					}
+					if ( bOK )
+						SpewMsg( "Using AF_XDP on %s queue %d for IPv4 raw UDP sockets.\n", pszInterface, g_Config_XDP_Queue.Get() );
+					else
+						SpewWarning( "AF_XDP not available on %s (%s).  Falling back to ordinary sockets.\n", pszInterface, errMsgXDP );
+				}
+			#endif
 		#endif
 
 		SpewMsg( "Initialized low level socket/threading support.\n" );
@@ -1983,21 +4368,57 @@ void SteamNetworkingSocketsLowLevelDecRef()
 		// Sorry, but this code is covered under NDA with Nintendo, and
 		// we don't have permission to distribute it.
 	#else
-		if ( s_hSockWakeThreadRead != INVALID_SOCKET )
-		{
-			closesocket( s_hSockWakeThreadRead );
-			s_hSockWakeThreadRead = INVALID_SOCKET;
-		}
-		if ( s_hSockWakeThreadWrite != INVALID_SOCKET )
-		{
-			closesocket( s_hSockWakeThreadWrite );
-			s_hSockWakeThreadWrite = INVALID_SOCKET;
-		}
+		#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_EVENTFD
+			if ( s_eventFDWakeThread >= 0 )
+			{
+				close( s_eventFDWakeThread );
+				s_eventFDWakeThread = -1;
+			}
+		#else
+			if ( s_hSockWakeThreadRead != INVALID_SOCKET )
+			{
+				closesocket( s_hSockWakeThreadRead );
+				s_hSockWakeThreadRead = INVALID_SOCKET;
+			}
+			if ( s_hSockWakeThreadWrite != INVALID_SOCKET )
+			{
+				closesocket( s_hSockWakeThreadWrite );
+				s_hSockWakeThreadWrite = INVALID_SOCKET;
+			}
+		#endif
+		#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_XDP
+			if ( s_xdp.IsValid() )
+			{
+				s_xdp.FlushTx(); // Send anything queued
+				s_xdp.Kill();
+			}
+			s_mapXDPPorts.Purge();
+			s_mapXDPRoutes.Purge();
+		#endif
+		#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_EPOLL
+			if ( s_epollFD >= 0 )
+			{
+				close( s_epollFD );
+				s_epollFD = -1;
+			}
+		#endif
 	#endif
 
+	// Discard any messages that were sent after the connections were destroyed
+	ServiceLockFreeSendQueue();
+
 	// Check for any leftover tasks that were queued to be run while we hold the lock
 	ISteamNetworkingSocketsRunWithLock::ServiceQueue();
 
+	// Shutdown io_uring.  This releases any sockets it was still using
+	#ifdef STEAMNETWORKINGSOCKETS_IOURING
+		if ( s_ioUring.IsValid() )
+		{
+			IOUringSubmit(); // Send anything queued
+			IOUringKill();
+		}
+	#endif
+
 	// Make sure we actually destroy socket objects.  It's safe to do so now.
 	ProcessPendingDestroyClosedRawUDPSockets();
 
@@ -2086,8 +4507,10 @@ SteamNetworkingMicroseconds SteamNetworkingSockets_GetLocalTimestamp()
 	}
 
 	// Save the last value returned.  Unless another thread snuck in there while we were busy.
-	// If so, that's OK.
-	SteamNetworkingSocketsLib::s_usecTimeLastReturned.compare_exchange_strong( usecLastReturned, usecResult );
+	// If so, that's OK.  This is only used to detect big jumps, so don't bother
+	// writing to the shared cache line every time we are called.
+	if ( usecResult - usecLastReturned >= 1000 )
+		SteamNetworkingSocketsLib::s_usecTimeLastReturned.compare_exchange_strong( usecLastReturned, usecResult );
 
 	return usecResult;
 }
@@ -2144,6 +4567,69 @@ STEAMNETWORKINGSOCKETS_INTERFACE void SteamNetworkingSockets_Poll( int msMaxWait
 		SteamDatagramTransportLock::Unlock();
 }
 
+STEAMNETWORKINGSOCKETS_INTERFACE int SteamNetworkingSockets_GetPollFD()
+{
+	#ifdef STEAMNETWORKINGSOCKETS_IOURING
+		if ( s_ioUring.IsValid() )
+			return -1;
+	#endif
+	#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_EPOLL
+		return s_epollFD;
+	#else
+		return -1;
+	#endif
+}
+
+STEAMNETWORKINGSOCKETS_INTERFACE SteamNetworkingMicroseconds SteamNetworkingSockets_GetNextThinkTime()
+{
+	SteamDatagramTransportLock scopeLock( "SteamNetworkingSockets_GetNextThinkTime" );
+	IThinker *pNextThinker = Thinker_GetNextScheduled();
+	return pNextThinker ? pNextThinker->GetNextThinkTime() : k_nThinkTime_Never;
+}
+
+STEAMNETWORKINGSOCKETS_INTERFACE void SteamNetworkingSockets_ProcessReady()
+{
+	if ( !s_bManualPollMode )
+	{
+		AssertMsg( false, "Not in manual poll mode!" );
+		return;
+	}
+	Assert( s_nLowLevelSupportRefCount.load(std::memory_order_acquire) > 0 );
+
+	SteamDatagramTransportLock::Lock( "SteamNetworkingSockets_ProcessReady" );
+	Assert( SteamDatagramTransportLock::s_nLocked == 1 );
+	s_bPollerSleeping.store( false, std::memory_order_relaxed );
+
+	// With epoll, we can check for ready sockets without releasing the lock
+	bool bEpoll = false;
+	#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_EPOLL
+		bEpoll = SteamNetworkingSockets_GetPollFD() >= 0;
+		if ( bEpoll )
+		{
+			epoll_event epollEvents[ k_nMaxEpollEvents ];
+			int nEpollEvents = epoll_wait( s_epollFD, epollEvents, k_nMaxEpollEvents, 0 );
+			DispatchEpollEvents( epollEvents, nEpollEvents );
+
+			// The caller presumably slept until they had a reason to call us
+			++s_udpStats.m_nWakeups;
+			if ( ProcessWorkAfterPoll() > 0 )
+				++s_udpStats.m_nThinkerWakeups;
+		}
+	#endif
+	if ( !bEpoll )
+	{
+		// Just do one ordinary pass, without waiting
+		if ( !SteamNetworkingSockets_InternalPoll( 0, true ) )
+			return; // Shutdown request, lock already released
+	}
+
+	// The caller is going to wait on the fd.  If anybody schedules
+	// a thinker earlier than what they think the next deadline is,
+	// make sure the fd becomes readable, so they come back here.
+	s_bPollerSleeping.store( true, std::memory_order_release );
+	SteamDatagramTransportLock::Unlock();
+}
+
 STEAMNETWORKINGSOCKETS_INTERFACE void SteamNetworkingSockets_SetLockWaitWarningThreshold( SteamNetworkingMicroseconds usecTheshold )
 {
 	s_usecLockWaitWarningThreshold = usecTheshold;
@@ -2153,3 +4639,66 @@ STEAMNETWORKINGSOCKETS_INTERFACE void SteamNetworkingSockets_SetLockAcquiredCall
 {
 	s_fLockAcquiredCallback = callback;
 }
+
+STEAMNETWORKINGSOCKETS_INTERFACE int SteamNetworkingSockets_GetLockStats( SteamNetworkingSocketsLockStats *pStats, int nMaxTags )
+{
+	SteamDatagramTransportLock scopeLock( "SteamNetworkingSockets_GetLockStats" );
+	for ( int i = 0 ; i < s_nLockTagStats && i < nMaxTags ; ++i )
+	{
+		const LockTagStats_t &tag = s_lockTagStats[i];
+		SteamNetworkingSocketsLockStats &stats = pStats[i];
+		V_strcpy_safe( stats.m_szTag, tag.m_pszTag );
+
+		stats.m_nWaits = tag.m_wait.m_nCount;
+		stats.m_usecWaitTotal = tag.m_wait.m_usecTotal;
+		stats.m_usecWaitMax = tag.m_wait.m_usecMax;
+		memcpy( stats.m_nWaitHistogram, tag.m_wait.m_nHistogram, sizeof(stats.m_nWaitHistogram) );
+
+		stats.m_nHolds = tag.m_hold.m_nCount;
+		stats.m_usecHoldTotal = tag.m_hold.m_usecTotal;
+		stats.m_usecHoldMax = tag.m_hold.m_usecMax;
+		memcpy( stats.m_nHoldHistogram, tag.m_hold.m_nHistogram, sizeof(stats.m_nHoldHistogram) );
+	}
+	return s_nLockTagStats;
+}
+
+STEAMNETWORKINGSOCKETS_INTERFACE void SteamNetworkingSockets_ResetLockStats()
+{
+	SteamDatagramTransportLock scopeLock( "SteamNetworkingSockets_ResetLockStats" );
+	for ( int i = 0 ; i < s_nLockTagStats ; ++i )
+	{
+		memset( &s_lockTagStats[i].m_wait, 0, sizeof(s_lockTagStats[i].m_wait) );
+		memset( &s_lockTagStats[i].m_hold, 0, sizeof(s_lockTagStats[i].m_hold) );
+	}
+}
+
+STEAMNETWORKINGSOCKETS_INTERFACE void SteamNetworkingSockets_GetUDPStats( SteamNetworkingSocketsUDPStats *pStats )
+{
+	SteamDatagramTransportLock scopeLock( "SteamNetworkingSockets_GetUDPStats" );
+	*pStats = s_udpStats;
+}
+
+STEAMNETWORKINGSOCKETS_INTERFACE int SteamNetworkingSockets_GetUDPSocketStats( SteamNetworkingSocketsUDPSocketStats *pStats, int nMaxSockets )
+{
+	SteamDatagramTransportLock scopeLock( "SteamNetworkingSockets_GetUDPSocketStats" );
+	const int nSockets = s_vecRawSockets.Count();
+	for ( int i = 0 ; i < nSockets && i < nMaxSockets ; ++i )
+	{
+		const CRawUDPSocketImpl *pSock = s_vecRawSockets[i];
+		SteamNetworkingSocketsUDPSocketStats &stats = pStats[i];
+		memset( &stats, 0, sizeof(stats) );
+		stats.m_addrLocal = pSock->m_boundAddr;
+		stats.m_nRecvPackets = pSock->m_nRecvPackets;
+		#ifdef STEAMNETWORKINGSOCKETS_LOWLEVEL_RXQ_OVFL
+			stats.m_nKernelDrops = pSock->m_nKernelDrops;
+		#endif
+
+		// Ask the kernel what it's actually using.  (Linux doubles
+		// what we ask for, and might cap it.)
+		int cbRecvBuffer = 0;
+		socklen_t cbOpt = sizeof(cbRecvBuffer);
+		if ( getsockopt( pSock->m_socket, SOL_SOCKET, SO_RCVBUF, (char *)&cbRecvBuffer, &cbOpt ) == 0 )
+			stats.m_cbRecvBuffer = cbRecvBuffer;
+	}
+	return nSockets;
+}
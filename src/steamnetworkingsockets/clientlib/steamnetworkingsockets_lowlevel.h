@@ -103,6 +103,15 @@ const int k_nAddressFamily_IPv4 = 1;
 const int k_nAddressFamily_IPv6 = 2;
 const int k_nAddressFamily_DualStack = k_nAddressFamily_IPv4|k_nAddressFamily_IPv6;
 
+/// Options when opening a raw socket
+enum ERawUDPSocketOpenFlags
+{
+	/// Set SO_REUSEPORT before binding, so that several sockets can be bound
+	/// to the same address and the kernel will spread incoming traffic across
+	/// them.  Linux only.
+	k_nRawUDPSocketOpen_ReusePort = 1<<0,
+};
+
 /// Create a UDP socket, set all the socket options for non-blocking, etc, bind it to the desired interface and port, and
 /// make sure we're setup to poll the socket efficiently and deliver packets received to the specified callback.
 ///
@@ -120,7 +129,20 @@ const int k_nAddressFamily_DualStack = k_nAddressFamily_IPv4|k_nAddressFamily_IP
 ///
 /// Upon exit, the address and address families are modified to contain the actual bound
 /// address (specifically, the port!) and available address families.
-extern IRawUDPSocket *OpenRawUDPSocket( CRecvPacketCallback callback, SteamDatagramErrMsg &errMsg, SteamNetworkingIPAddr *pAddrLocal, int *pnAddressFamilies );
+///
+/// nOpenFlags is a combination of ERawUDPSocketOpenFlags
+extern IRawUDPSocket *OpenRawUDPSocket( CRecvPacketCallback callback, SteamDatagramErrMsg &errMsg, SteamNetworkingIPAddr *pAddrLocal, int *pnAddressFamilies, int nOpenFlags );
+
+/// Call this from inside a CRecvPacketCallback to find out when the packet
+/// actually arrived, if the kernel told us.  (See k_ESteamNetworkingConfig_UDPRecvKernelTimestamps.)
+/// Otherwise, or if you aren't inside a callback, returns usecNow.
+extern SteamNetworkingMicroseconds GetRawUDPPacketRecvTime( SteamNetworkingMicroseconds usecNow );
+
+/// Call this from inside a CRecvPacketCallback once you have verified that the
+/// packet really came from who it says it came from (e.g. it decrypted OK).
+/// Some backends use this to learn how to reach the sender.  Harmless if you
+/// aren't inside a callback.
+extern void RawUDPPacketAuthenticated();
 
 /// A single socket could, in theory, be used to communicate with every single remote host.
 /// Or we may decide to open up one socket per remote host, to workaround weird firewall/NAT
@@ -171,16 +193,35 @@ extern IBoundUDPSocket *OpenUDPSocketBoundToHost( const netadr_t &adrRemote, CRe
 /// Create a pair of sockets that are bound to talk to each other.
 extern bool CreateBoundSocketPair( CRecvPacketCallback callback1, CRecvPacketCallback callback2, IBoundUDPSocket **ppOutSockets, SteamDatagramErrMsg &errMsg );
 
-/// Manage a single underlying socket that is used to talk to multiple remote hosts
+/// Max number of raw sockets a CSharedSocket will spread its traffic over
+const int k_nMaxSharedSocketShards = 16;
+
+/// Packets with the high bit of the lead byte set are data packets, and carry
+/// the recipient's connection ID (little endian) immediately after the lead
+/// byte.  CSharedSocket uses this to demultiplex.  (See UDPDataMsgHdr.)
+const uint8 k_nSharedSocketDataPacketLeadBit = 0x80;
+const int k_cbSharedSocketDataPacketConnectionIDOffset = 1;
+
+/// Manage a single underlying socket that is used to talk to multiple remote hosts.
+///
+/// On Linux, the "single" socket can actually be a group of sockets bound to the
+/// same address with SO_REUSEPORT ("shards").  The kernel hashes the 4-tuple of
+/// each incoming datagram to select the shard, so a given remote host always
+/// arrives on the same one, and we talk back to it using that same shard.  This
+/// only gives each shard its own kernel receive queue.  All shards are polled by
+/// the service thread and processed under the global lock, just like a single
+/// socket.
 class CSharedSocket
 {
 public:
 	CSharedSocket();
 	~CSharedSocket();
 
-	/// Allocate a raw socket and setup bookkeeping structures so we can add
-	/// clients that will talk using it.
-	bool BInit( const SteamNetworkingIPAddr &localAddr, CRecvPacketCallback callbackDefault, SteamDatagramErrMsg &errMsg );
+	/// Allocate raw socket(s) and setup bookkeeping structures so we can add
+	/// clients that will talk using it.  If nShards > 1, we will try to open
+	/// that many sockets on the same address, using SO_REUSEPORT.  On platforms
+	/// where that isn't supported, we just use a single socket.
+	bool BInit( const SteamNetworkingIPAddr &localAddr, int nShards, CRecvPacketCallback callbackDefault, SteamDatagramErrMsg &errMsg );
 
 	/// Close all sockets and clean up all resources
 	void Kill();
@@ -189,30 +230,57 @@ public:
 	/// are done.
 	IBoundUDPSocket *AddRemoteHost( const netadr_t &adrRemote, CRecvPacketCallback callback );
 
+	/// Once the local connection ID for a remote host is known, register it
+	/// so that data packets addressed to that ID are routed without hashing
+	/// the source address.  pBoundSock must have been returned by AddRemoteHost
+	/// on this object.  Pass 0 to unregister.
+	void SetRemoteHostConnectionID( IBoundUDPSocket *pBoundSock, uint32 unConnectionIDLocal );
+
 	/// Send a packet to a remove host.  It doesn't matter if the remote host
-	/// is in the client table a client already or not.
+	/// is in the client table a client already or not.  If we are sharded, this
+	/// uses the shard that most recently received a packet, which is the one
+	/// the remote host is talking to if we are replying to them.
 	bool BSendRawPacket( const void *pPkt, int cbPkt, const netadr_t &adrTo ) const
 	{
-		return m_pRawSock->BSendRawPacket( pPkt, cbPkt, adrTo );
+		return GetSendShard()->BSendRawPacket( pPkt, cbPkt, adrTo );
 	}
 
 	const SteamNetworkingIPAddr *GetBoundAddr() const
 	{
-		if ( !m_pRawSock )
+		if ( m_nShards <= 0 )
 		{
 			Assert( false );
 			return nullptr;
 		}
-		return &m_pRawSock->m_boundAddr;
+		return &m_arShards[0].m_pRawSock->m_boundAddr;
 	}
 
+	/// Number of raw sockets we actually opened
+	int GetShardCount() const { return m_nShards; }
+
 private:
 
 	/// Call this if we get a packet from somebody we don't recognize
 	CRecvPacketCallback m_callbackDefault;
 
-	/// The raw socket that is being shared
-	IRawUDPSocket *m_pRawSock;
+	/// The raw socket(s) that are being shared
+	struct Shard
+	{
+		IRawUDPSocket *m_pRawSock;
+		CSharedSocket *m_pOwner;
+	};
+	Shard m_arShards[ k_nMaxSharedSocketShards ];
+	int m_nShards;
+
+	/// Raw socket that most recently delivered a packet, if any
+	IRawUDPSocket *m_pRawSockRecv;
+
+	/// Socket to use when talking to a remote host that isn't in our table
+	IRawUDPSocket *GetSendShard() const
+	{
+		Assert( m_nShards > 0 );
+		return m_pRawSockRecv ? m_pRawSockRecv : m_arShards[0].m_pRawSock;
+	}
 
 	class RemoteHost : public IBoundUDPSocket
 	{
@@ -223,6 +291,7 @@ private:
 		inline RemoteHost( IRawUDPSocket *pRawSock, const netadr_t &adr ) : IBoundUDPSocket( pRawSock, adr ) {}
 		CRecvPacketCallback m_callback;
 		CSharedSocket *m_pOwner;
+		uint32 m_unConnectionIDLocal = 0;
 		virtual void Close() OVERRIDE;
 	};
 	friend class RemoteHost;
@@ -239,7 +308,24 @@ private:
 
 	void CloseRemoteHostByIndex( int idx );
 
-	static void CallbackRecvPacket( const void *pPkt, int cbPkt, const netadr_t &adrFrom, CSharedSocket *pSock );
+	/// Remote hosts indexed directly by the low bits of their local connection
+	/// ID, which is random.  Open addressing with linear probing; the size is
+	/// a power of two and kept at most half full.  Data packets carry the
+	/// recipient's connection ID in a fixed position, so we can route them
+	/// with a single array lookup and a compare of the address, and only
+	/// hash the address for handshake traffic and strays.
+	struct ConnectionIDSlot
+	{
+		uint32 m_unConnectionID; // 0 if empty
+		RemoteHost *m_pHost;
+	};
+	CUtlVector<ConnectionIDSlot> m_vecConnectionIDTable;
+	int m_nConnectionIDTableCount;
+	RemoteHost *FindRemoteHostByConnectionID( uint32 unConnectionID ) const;
+	void InsertConnectionID( RemoteHost *pHost );
+	void RemoveConnectionID( RemoteHost *pHost );
+
+	static void CallbackRecvPacket( const void *pPkt, int cbPkt, const netadr_t &adrFrom, Shard *pShard );
 };
 
 /////////////////////////////////////////////////////////////////////////////
@@ -252,6 +338,11 @@ private:
 /// This is when: 1.) We own the lock and 2.) we aren't polling in the service thread.
 extern void ProcessPendingDestroyClosedRawUDPSockets();
 
+/// Pass any messages that were sent without taking the lock on to their
+/// connections.  (See k_ESteamNetworkingConfig_LockFreeSendQueueSize.)
+/// We must hold the lock.
+extern void ServiceLockFreeSendQueue();
+
 /// Last time that we spewed something that was subject to rate limit 
 extern SteamNetworkingMicroseconds g_usecLastRateLimitSpew;
 extern int g_nRateLimitSpewCount;
@@ -334,6 +425,11 @@ extern void SteamNetworkingSockets_SetDebugOutputFunction( ESteamNetworkingSocke
 /// but is safe to call from the service thread as well.
 extern void WakeSteamDatagramThread();
 
+/// Like WakeSteamDatagramThread, but skips the wake if the service thread is
+/// not currently asleep.  You must hold the lock, so that the thread is
+/// guaranteed to notice whatever you changed before it goes back to sleep.
+extern void WakeSteamDatagramThreadIfSleeping();
+
 /// Class used to take some action while we have the global thread locked,
 /// perhaps later and in another thread if necessary.  Intended to be used
 /// from callbacks and other contexts where we don't know what thread we are
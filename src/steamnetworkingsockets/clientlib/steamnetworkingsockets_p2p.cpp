@@ -749,9 +749,10 @@ void CSteamNetworkConnectionP2P::DestroyTransport()
 
 CSteamNetworkConnectionP2P *CSteamNetworkConnectionP2P::FindDuplicateConnection( CSteamNetworkingSockets *pInterfaceLocal, int nLocalVirtualPort, const SteamNetworkingIdentity &identityRemote, int nRemoteVirtualPort, bool bOnlySymmetricConnections, CSteamNetworkConnectionP2P *pIgnore )
 {
-	for ( CSteamNetworkConnectionBase *pConn: g_mapConnections.IterValues() )
+	for ( int nSlot = 0 ; nSlot < g_tableConnections.NumSlots() ; ++nSlot )
 	{
-		if ( pConn->m_pSteamNetworkingSocketsInterface != pInterfaceLocal )
+		CSteamNetworkConnectionBase *pConn = g_tableConnections.GetAtSlot( nSlot );
+		if ( !pConn || pConn->m_pSteamNetworkingSocketsInterface != pInterfaceLocal )
 			continue;
 		if ( !(  pConn->m_identityRemote == identityRemote ) )
 			continue;
@@ -1848,9 +1849,10 @@ void CConnectionTransportP2PBase::P2PTransportThink( SteamNetworkingMicroseconds
 		}
 	}
 
+	// None of this is urgent, so we can share a wakeup with other thinkers
 	if ( m_usecEndToEndInFlightReplyTimeout )
 		usecNextThink = std::min( usecNextThink, m_usecEndToEndInFlightReplyTimeout );
-	m_pSelfAsThinker->EnsureMinThinkTime( usecNextThink );
+	m_pSelfAsThinker->EnsureMinThinkTime( usecNextThink, g_Config_TimerSlack.Get() );
 }
 
 void CConnectionTransportP2PBase::P2PTransportEndToEndConnectivityNotConfirmed( SteamNetworkingMicroseconds usecNow )
@@ -873,7 +873,7 @@ bool CSteamNetworkConnectionBase::ProcessPlainTextDataChunk( int usecTimeSinceLa
 				if ( nPackedDelay != 0xffff && inFlightPkt->first == nLatestRecvSeqNum && inFlightPkt->second.m_pTransport == ctx.m_pTransport )
 				{
 					SteamNetworkingMicroseconds usecDelay = SteamNetworkingMicroseconds( nPackedDelay ) << k_nAckDelayPrecisionShift;
-					SteamNetworkingMicroseconds usecElapsed = usecNow - inFlightPkt->second.m_usecWhenSent;
+					SteamNetworkingMicroseconds usecElapsed = ctx.m_usecRecvTime - inFlightPkt->second.m_usecWhenSent;
 					Assert( usecElapsed >= 0 );
 
 					// Account for their reported delay, and calculate ping, in MS
@@ -1129,7 +1129,10 @@ bool CSteamNetworkConnectionBase::ProcessPlainTextDataChunk( int usecTimeSinceLa
 	//
 	// Also, note that order of operations is important.  This call must
 	// happen after the SNP_RecordReceivedPktNum call above
-	m_statsEndToEnd.TrackProcessSequencedPacket( nPktNum, usecNow, usecTimeSinceLast );
+	//
+	// We pass the time the packet arrived.  It's used to measure jitter,
+	// and the ack delay we report to our peer, which they subtract from ping
+	m_statsEndToEnd.TrackProcessSequencedPacket( nPktNum, ctx.m_usecRecvTime, usecTimeSinceLast );
 
 	// Packet can be processed further
 	return true;
@@ -249,12 +249,14 @@ bool CSteamNetworkListenSocketDirectUDP::BInit( const SteamNetworkingIPAddr &loc
 	}
 
 	m_pSock = new CSharedSocket;
-	if ( !m_pSock->BInit( localAddr, CRecvPacketCallback( ReceivedFromUnknownHost, this ), errMsg ) )
+	if ( !m_pSock->BInit( localAddr, m_connectionConfig.m_IP_ListenSocketShards.Get(), CRecvPacketCallback( ReceivedFromUnknownHost, this ), errMsg ) )
 	{
 		delete m_pSock;
 		m_pSock = nullptr;
 		return false;
 	}
+	if ( m_pSock->GetShardCount() > 1 )
+		SpewVerbose( "Listen socket on port %d is sharded across %d sockets\n", localAddr.m_port, m_pSock->GetShardCount() );
 
 	CCrypto::GenerateRandomBlock( m_argbChallengeSecret, sizeof(m_argbChallengeSecret) );
 
@@ -860,16 +862,21 @@ void CConnectionTransportUDPBase::Received_Data( const uint8 *pPkt, int cbPkt, S
 	// Decrypt it, and check packet number
 	UDPRecvPacketContext_t ctx;
 	ctx.m_usecNow = usecNow;
+	ctx.m_usecRecvTime = GetRawUDPPacketRecvTime( usecNow );
 	ctx.m_pTransport = this;
 	ctx.m_pStatsIn = pMsgStatsIn;
 	if ( !m_connection.DecryptDataChunk( nWirePktNumber, cbPkt, pChunk, cbChunk, ctx ) )
 		return;
 
-	// This is a valid packet.  P2P connections might want to make a note of this
+	// This is a valid packet.  P2P connections might want to make a note of this,
+	// and so might the low level code
+	RawUDPPacketAuthenticated();
 	RecvValidUDPDataPacket( ctx );
 
-	// Process plaintext
-	int usecTimeSinceLast = 0; // FIXME - should we plumb this through so we can measure jitter?
+	// Process plaintext.  Our receive times are accurate, but the
+	// wire format doesn't carry the sender's spacing between packets,
+	// which we would need to measure jitter
+	int usecTimeSinceLast = 0;
 	if ( !m_connection.ProcessPlainTextDataChunk( usecTimeSinceLast, ctx ) )
 		return;
 
@@ -1346,6 +1353,11 @@ bool CSteamNetworkConnectionUDP::BBeginAccept(
 		return false;
 	}
 
+	// Now that we know our connection ID, let the shared socket route data
+	// packets to us by ID, rather than by hashing the address
+	COMPILE_TIME_ASSERT( offsetof( UDPDataMsgHdr, m_unToConnectionID ) == k_cbSharedSocketDataPacketConnectionIDOffset );
+	pSharedSock->SetRemoteHostConnectionID( pTransport->m_pSocket, m_unConnectionIDLocal );
+
 	// Process crypto handshake now
 	if ( !BRecvCryptoHandshake( msgCert, msgCryptSessionInfo, true ) )
 	{
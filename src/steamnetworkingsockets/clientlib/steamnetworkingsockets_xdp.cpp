@@ -0,0 +1,587 @@
+//====== Copyright Valve Corporation, All rights reserved. ====================
+
+#include "steamnetworkingsockets_xdp.h"
+
+#ifdef STEAMNETWORKINGSOCKETS_XDP
+
+#include <linux/bpf.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <net/if.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <errno.h>
+
+// memdbgon must be the last include file in a .cpp file!!!
+#include "tier0/memdbgon.h"
+
+namespace SteamNetworkingSocketsLib {
+
+/// Total number of frames in the UMEM.  Half for receiving, half for sending.
+/// Each half is also the size of the corresponding pair of rings.
+constexpr uint32 k_nXDPFrames = 4096;
+constexpr uint32 k_nXDPRxFrames = k_nXDPFrames/2;
+constexpr uint32 k_nXDPTxFrames = k_nXDPFrames - k_nXDPRxFrames;
+
+/// Max number of ports we can redirect, and queues we can bind to
+constexpr uint32 k_nXDPMaxPorts = 256;
+constexpr uint32 k_nXDPMaxQueues = 64;
+
+static int sys_bpf( int nCmd, bpf_attr *pAttr )
+{
+	return (int)syscall( __NR_bpf, nCmd, pAttr, sizeof(*pAttr) );
+}
+
+static int BPFCreateMap( bpf_map_type eType, uint32 cbKey, uint32 cbValue, uint32 nMaxEntries )
+{
+	bpf_attr attr;
+	memset( &attr, 0, sizeof(attr) );
+	attr.map_type = eType;
+	attr.key_size = cbKey;
+	attr.value_size = cbValue;
+	attr.max_entries = nMaxEntries;
+	return sys_bpf( BPF_MAP_CREATE, &attr );
+}
+
+static int BPFMapUpdate( int fdMap, const void *pKey, const void *pValue )
+{
+	bpf_attr attr;
+	memset( &attr, 0, sizeof(attr) );
+	attr.map_fd = fdMap;
+	attr.key = (uint64)(uintptr_t)pKey;
+	attr.value = (uint64)(uintptr_t)pValue;
+	attr.flags = BPF_ANY;
+	return sys_bpf( BPF_MAP_UPDATE_ELEM, &attr );
+}
+
+static int BPFMapDelete( int fdMap, const void *pKey )
+{
+	bpf_attr attr;
+	memset( &attr, 0, sizeof(attr) );
+	attr.map_fd = fdMap;
+	attr.key = (uint64)(uintptr_t)pKey;
+	return sys_bpf( BPF_MAP_DELETE_ELEM, &attr );
+}
+
+/// Assembles a BPF program, with forward jumps to a single label
+class CBPFAssembler
+{
+public:
+	std::vector<bpf_insn> m_vecInsns;
+	std::vector<int> m_vecJumpsToLabel;
+
+	void Emit( uint8 nCode, int nDst, int nSrc, int16 nOffset, int32 nImm )
+	{
+		bpf_insn insn;
+		memset( &insn, 0, sizeof(insn) );
+		insn.code = nCode;
+		insn.dst_reg = nDst;
+		insn.src_reg = nSrc;
+		insn.off = nOffset;
+		insn.imm = nImm;
+		m_vecInsns.push_back( insn );
+	}
+	void Mov64Reg( int nDst, int nSrc ) { Emit( BPF_ALU64 | BPF_MOV | BPF_X, nDst, nSrc, 0, 0 ); }
+	void Mov64Imm( int nDst, int32 nImm ) { Emit( BPF_ALU64 | BPF_MOV | BPF_K, nDst, 0, 0, nImm ); }
+	void Add64Imm( int nDst, int32 nImm ) { Emit( BPF_ALU64 | BPF_ADD | BPF_K, nDst, 0, 0, nImm ); }
+	void And64Imm( int nDst, int32 nImm ) { Emit( BPF_ALU64 | BPF_AND | BPF_K, nDst, 0, 0, nImm ); }
+	void Load( int nSize, int nDst, int nSrc, int16 nOffset ) { Emit( BPF_LDX | BPF_MEM | nSize, nDst, nSrc, nOffset, 0 ); }
+	void Store( int nSize, int nDst, int16 nOffset, int nSrc ) { Emit( BPF_STX | BPF_MEM | nSize, nDst, nSrc, nOffset, 0 ); }
+	void LoadMapFD( int nDst, int fdMap )
+	{
+		Emit( BPF_LD | BPF_DW | BPF_IMM, nDst, BPF_PSEUDO_MAP_FD, 0, fdMap );
+		Emit( 0, 0, 0, 0, 0 );
+	}
+	void Call( int32 nHelper ) { Emit( BPF_JMP | BPF_CALL, 0, 0, 0, nHelper ); }
+	void Exit() { Emit( BPF_JMP | BPF_EXIT, 0, 0, 0, 0 ); }
+
+	// Conditional jumps to the label
+	void JumpToLabelIfImm( int nOp, int nDst, int32 nImm )
+	{
+		m_vecJumpsToLabel.push_back( (int)m_vecInsns.size() );
+		Emit( BPF_JMP | nOp | BPF_K, nDst, 0, 0, nImm );
+	}
+	void JumpToLabelIfReg( int nOp, int nDst, int nSrc )
+	{
+		m_vecJumpsToLabel.push_back( (int)m_vecInsns.size() );
+		Emit( BPF_JMP | nOp | BPF_X, nDst, nSrc, 0, 0 );
+	}
+
+	// Place the label here
+	void Label()
+	{
+		int idxLabel = (int)m_vecInsns.size();
+		for ( int idx: m_vecJumpsToLabel )
+			m_vecInsns[idx].off = (int16)( idxLabel - ( idx+1 ) );
+		m_vecJumpsToLabel.clear();
+	}
+};
+
+bool CXDPSocket::BMapRing( Ring_t &ring, const xdp_ring_offset &off, uint32 nSize, size_t cbDesc, uint64 nPageOffset, SteamDatagramErrMsg &errMsg )
+{
+	ring.m_cbMap = off.desc + nSize * cbDesc;
+	void *pMap = mmap( nullptr, ring.m_cbMap, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, nPageOffset );
+	if ( pMap == MAP_FAILED )
+	{
+		V_sprintf_safe( errMsg, "mmap of AF_XDP ring failed.  Error code %d.", errno );
+		return false;
+	}
+	char *p = (char *)pMap;
+	ring.m_pMap = pMap;
+	ring.m_pProducer = (uint32 *)( p + off.producer );
+	ring.m_pConsumer = (uint32 *)( p + off.consumer );
+	ring.m_pFlags = (uint32 *)( p + off.flags );
+	ring.m_pDesc = p + off.desc;
+	ring.m_nSize = nSize;
+	return true;
+}
+
+void CXDPSocket::UnmapRing( Ring_t &ring )
+{
+	if ( ring.m_pMap )
+		munmap( ring.m_pMap, ring.m_cbMap );
+	ring = Ring_t();
+}
+
+bool CXDPSocket::BInit( const char *pszInterface, int nQueue, SteamDatagramErrMsg &errMsg )
+{
+	Assert( m_fd < 0 );
+
+	m_nIfIndex = if_nametoindex( pszInterface );
+	if ( m_nIfIndex == 0 )
+	{
+		V_sprintf_safe( errMsg, "Network interface '%s' not found.", pszInterface );
+		return false;
+	}
+	if ( nQueue < 0 || nQueue >= (int)k_nXDPMaxQueues )
+	{
+		V_sprintf_safe( errMsg, "Invalid queue %d.", nQueue );
+		return false;
+	}
+
+	m_fd = socket( AF_XDP, SOCK_RAW | SOCK_CLOEXEC, 0 );
+	if ( m_fd < 0 )
+	{
+		V_sprintf_safe( errMsg, "socket(AF_XDP) failed.  Error code %d.", errno );
+		return false;
+	}
+
+	// Register the UMEM
+	m_cbUMEM = (size_t)k_nXDPFrames * k_cbFrame;
+	void *pUMEM = mmap( nullptr, m_cbUMEM, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0 );
+	if ( pUMEM == MAP_FAILED )
+	{
+		V_sprintf_safe( errMsg, "mmap of UMEM failed.  Error code %d.", errno );
+		Kill();
+		return false;
+	}
+	m_pUMEM = (uint8 *)pUMEM;
+
+	xdp_umem_reg reg;
+	memset( &reg, 0, sizeof(reg) );
+	reg.addr = (uint64)(uintptr_t)m_pUMEM;
+	reg.len = m_cbUMEM;
+	reg.chunk_size = k_cbFrame;
+	reg.headroom = 0;
+	if ( setsockopt( m_fd, SOL_XDP, XDP_UMEM_REG, &reg, sizeof(reg) ) != 0 )
+	{
+		V_sprintf_safe( errMsg, "XDP_UMEM_REG failed.  Error code %d.", errno );
+		Kill();
+		return false;
+	}
+
+	// Create the rings
+	int nRxRingSize = k_nXDPRxFrames;
+	int nTxRingSize = k_nXDPTxFrames;
+	if (
+		setsockopt( m_fd, SOL_XDP, XDP_UMEM_FILL_RING, &nRxRingSize, sizeof(nRxRingSize) ) != 0
+		|| setsockopt( m_fd, SOL_XDP, XDP_RX_RING, &nRxRingSize, sizeof(nRxRingSize) ) != 0
+		|| setsockopt( m_fd, SOL_XDP, XDP_UMEM_COMPLETION_RING, &nTxRingSize, sizeof(nTxRingSize) ) != 0
+		|| setsockopt( m_fd, SOL_XDP, XDP_TX_RING, &nTxRingSize, sizeof(nTxRingSize) ) != 0
+	) {
+		V_sprintf_safe( errMsg, "Failed to create AF_XDP rings.  Error code %d.", errno );
+		Kill();
+		return false;
+	}
+
+	xdp_mmap_offsets off;
+	memset( &off, 0, sizeof(off) );
+	socklen_t cbOff = sizeof(off);
+	if ( getsockopt( m_fd, SOL_XDP, XDP_MMAP_OFFSETS, &off, &cbOff ) != 0 )
+	{
+		V_sprintf_safe( errMsg, "XDP_MMAP_OFFSETS failed.  Error code %d.", errno );
+		Kill();
+		return false;
+	}
+	if (
+		!BMapRing( m_ringFill, off.fr, k_nXDPRxFrames, sizeof(uint64), XDP_UMEM_PGOFF_FILL_RING, errMsg )
+		|| !BMapRing( m_ringRx, off.rx, k_nXDPRxFrames, sizeof(xdp_desc), XDP_PGOFF_RX_RING, errMsg )
+		|| !BMapRing( m_ringCompletion, off.cr, k_nXDPTxFrames, sizeof(uint64), XDP_UMEM_PGOFF_COMPLETION_RING, errMsg )
+		|| !BMapRing( m_ringTx, off.tx, k_nXDPTxFrames, sizeof(xdp_desc), XDP_PGOFF_TX_RING, errMsg )
+	) {
+		Kill();
+		return false;
+	}
+	m_nTxProducerLocal = *m_ringTx.m_pProducer;
+
+	// Bind to the queue.  Try zero copy first, then fall back to copy mode,
+	// which works with any driver (and the generic XDP path)
+	sockaddr_xdp sxdp;
+	memset( &sxdp, 0, sizeof(sxdp) );
+	sxdp.sxdp_family = AF_XDP;
+	sxdp.sxdp_ifindex = m_nIfIndex;
+	sxdp.sxdp_queue_id = nQueue;
+	sxdp.sxdp_flags = XDP_USE_NEED_WAKEUP | XDP_ZEROCOPY;
+	if ( bind( m_fd, (const sockaddr *)&sxdp, sizeof(sxdp) ) != 0 )
+	{
+		sxdp.sxdp_flags = XDP_USE_NEED_WAKEUP | XDP_COPY;
+		if ( bind( m_fd, (const sockaddr *)&sxdp, sizeof(sxdp) ) != 0 )
+		{
+			V_sprintf_safe( errMsg, "Failed to bind AF_XDP socket to %s queue %d.  Error code %d.", pszInterface, nQueue, errno );
+			Kill();
+			return false;
+		}
+	}
+	m_bNeedWakeup = true;
+
+	// Give the receive frames to the kernel
+	{
+		uint64 *pFill = (uint64 *)m_ringFill.m_pDesc;
+		uint32 nProducer = *m_ringFill.m_pProducer;
+		for ( uint32 i = 0 ; i < k_nXDPRxFrames ; ++i )
+			pFill[ ( nProducer + i ) & ( m_ringFill.m_nSize-1 ) ] = (uint64)i * k_cbFrame;
+		__atomic_store_n( m_ringFill.m_pProducer, nProducer + k_nXDPRxFrames, __ATOMIC_RELEASE );
+	}
+	m_vecTxFramesFree.clear();
+	m_vecTxFramesFree.reserve( k_nXDPTxFrames );
+	for ( uint32 i = k_nXDPRxFrames ; i < k_nXDPFrames ; ++i )
+		m_vecTxFramesFree.push_back( (uint64)i * k_cbFrame );
+
+	// Create the maps.  One tells the program which ports we want, the
+	// other is where it redirects them
+	m_fdMapPorts = BPFCreateMap( BPF_MAP_TYPE_HASH, sizeof(uint32), sizeof(uint32), k_nXDPMaxPorts );
+	m_fdMapXSKs = BPFCreateMap( BPF_MAP_TYPE_XSKMAP, sizeof(uint32), sizeof(uint32), k_nXDPMaxQueues );
+	if ( m_fdMapPorts < 0 || m_fdMapXSKs < 0 )
+	{
+		V_sprintf_safe( errMsg, "Failed to create BPF maps.  Error code %d.", errno );
+		Kill();
+		return false;
+	}
+	uint32 nKey = nQueue;
+	uint32 nValue = m_fd;
+	if ( BPFMapUpdate( m_fdMapXSKs, &nKey, &nValue ) != 0 )
+	{
+		V_sprintf_safe( errMsg, "Failed to insert AF_XDP socket into XSKMAP.  Error code %d.", errno );
+		Kill();
+		return false;
+	}
+
+	// Assemble the program.  Registers on entry: r1 = xdp_md.
+	// Values are loaded from the packet raw, so we compare them against
+	// constants in network byte order.
+	//
+	//    if ( ethertype != IPv4 || ip.ver_ihl != 0x45 || ip.proto != UDP || fragment )
+	//        return XDP_PASS;
+	//    if ( !map_lookup( ports, udp.dest ) )
+	//        return XDP_PASS;
+	//    return redirect_map( xsks, rx_queue_index, XDP_PASS );
+	CBPFAssembler bpf;
+	bpf.Mov64Reg( BPF_REG_6, BPF_REG_1 );
+	bpf.Load( BPF_W, BPF_REG_2, BPF_REG_6, offsetof( xdp_md, data ) );
+	bpf.Load( BPF_W, BPF_REG_3, BPF_REG_6, offsetof( xdp_md, data_end ) );
+	bpf.Mov64Reg( BPF_REG_4, BPF_REG_2 );
+	bpf.Add64Imm( BPF_REG_4, k_cbXDPUDPHeaders );
+	bpf.JumpToLabelIfReg( BPF_JGT, BPF_REG_4, BPF_REG_3 );
+	bpf.Load( BPF_H, BPF_REG_5, BPF_REG_2, 12 ); // ethertype
+	bpf.JumpToLabelIfImm( BPF_JNE, BPF_REG_5, htons( 0x0800 ) );
+	bpf.Load( BPF_B, BPF_REG_5, BPF_REG_2, 14 ); // version, header length
+	bpf.JumpToLabelIfImm( BPF_JNE, BPF_REG_5, 0x45 );
+	bpf.Load( BPF_B, BPF_REG_5, BPF_REG_2, 14+9 ); // protocol
+	bpf.JumpToLabelIfImm( BPF_JNE, BPF_REG_5, IPPROTO_UDP );
+	bpf.Load( BPF_H, BPF_REG_5, BPF_REG_2, 14+6 ); // flags, fragment offset
+	bpf.And64Imm( BPF_REG_5, htons( 0x3fff ) ); // more fragments, or offset?
+	bpf.JumpToLabelIfImm( BPF_JNE, BPF_REG_5, 0 );
+	bpf.Load( BPF_H, BPF_REG_5, BPF_REG_2, 14+20+2 ); // dest port
+	bpf.Store( BPF_W, BPF_REG_10, -4, BPF_REG_5 );
+	bpf.Mov64Reg( BPF_REG_2, BPF_REG_10 );
+	bpf.Add64Imm( BPF_REG_2, -4 );
+	bpf.LoadMapFD( BPF_REG_1, m_fdMapPorts );
+	bpf.Call( BPF_FUNC_map_lookup_elem );
+	bpf.JumpToLabelIfImm( BPF_JEQ, BPF_REG_0, 0 );
+	bpf.Load( BPF_W, BPF_REG_2, BPF_REG_6, offsetof( xdp_md, rx_queue_index ) );
+	bpf.LoadMapFD( BPF_REG_1, m_fdMapXSKs );
+	bpf.Mov64Imm( BPF_REG_3, XDP_PASS ); // If there's no socket for this queue
+	bpf.Call( BPF_FUNC_redirect_map );
+	bpf.Exit();
+	bpf.Label();
+	bpf.Mov64Imm( BPF_REG_0, XDP_PASS );
+	bpf.Exit();
+
+	static const char szLicense[] = "BSD";
+	bpf_attr attr;
+	memset( &attr, 0, sizeof(attr) );
+	attr.prog_type = BPF_PROG_TYPE_XDP;
+	attr.insns = (uint64)(uintptr_t)bpf.m_vecInsns.data();
+	attr.insn_cnt = (uint32)bpf.m_vecInsns.size();
+	attr.license = (uint64)(uintptr_t)szLicense;
+	m_fdProg = sys_bpf( BPF_PROG_LOAD, &attr );
+	if ( m_fdProg < 0 )
+	{
+		V_sprintf_safe( errMsg, "Failed to load XDP program.  Error code %d.", errno );
+		Kill();
+		return false;
+	}
+
+	// Attach it.  Using a link means it will be detached automatically
+	// if we exit without cleaning up.  The kernel will use native mode if
+	// the driver supports it, otherwise generic mode.
+	memset( &attr, 0, sizeof(attr) );
+	attr.link_create.prog_fd = m_fdProg;
+	attr.link_create.target_ifindex = m_nIfIndex;
+	attr.link_create.attach_type = BPF_XDP;
+	m_fdLink = sys_bpf( BPF_LINK_CREATE, &attr );
+	if ( m_fdLink < 0 )
+	{
+		V_sprintf_safe( errMsg, "Failed to attach XDP program to %s.  Error code %d.", pszInterface, errno );
+		Kill();
+		return false;
+	}
+
+	return true;
+}
+
+void CXDPSocket::Kill()
+{
+	// Detach the program first, so nothing else gets redirected to us
+	if ( m_fdLink >= 0 )
+	{
+		close( m_fdLink );
+		m_fdLink = -1;
+	}
+	if ( m_fdProg >= 0 )
+	{
+		close( m_fdProg );
+		m_fdProg = -1;
+	}
+	if ( m_fdMapXSKs >= 0 )
+	{
+		close( m_fdMapXSKs );
+		m_fdMapXSKs = -1;
+	}
+	if ( m_fdMapPorts >= 0 )
+	{
+		close( m_fdMapPorts );
+		m_fdMapPorts = -1;
+	}
+
+	UnmapRing( m_ringFill );
+	UnmapRing( m_ringRx );
+	UnmapRing( m_ringCompletion );
+	UnmapRing( m_ringTx );
+	m_nTxProducerLocal = 0;
+	m_vecTxFramesFree.clear();
+
+	if ( m_fd >= 0 )
+	{
+		close( m_fd );
+		m_fd = -1;
+	}
+	if ( m_pUMEM )
+	{
+		munmap( m_pUMEM, m_cbUMEM );
+		m_pUMEM = nullptr;
+	}
+	m_nIfIndex = 0;
+	m_bNeedWakeup = false;
+}
+
+bool CXDPSocket::BAddPort( uint16 nPort )
+{
+	Assert( IsValid() );
+	uint32 nKey = htons( nPort );
+	uint32 nValue = 1;
+	return BPFMapUpdate( m_fdMapPorts, &nKey, &nValue ) == 0;
+}
+
+void CXDPSocket::RemovePort( uint16 nPort )
+{
+	Assert( IsValid() );
+	uint32 nKey = htons( nPort );
+	BPFMapDelete( m_fdMapPorts, &nKey );
+}
+
+int CXDPSocket::ReceiveFrames( RecvFrame_t *pFrames, int nMaxFrames )
+{
+	Assert( IsValid() );
+
+	// We are the only one who writes the consumer index
+	uint32 nConsumer = *m_ringRx.m_pConsumer;
+	uint32 nProducer = __atomic_load_n( m_ringRx.m_pProducer, __ATOMIC_ACQUIRE );
+	int nFrames = std::min( (int)( nProducer - nConsumer ), nMaxFrames );
+	const xdp_desc *pDescs = (const xdp_desc *)m_ringRx.m_pDesc;
+	for ( int i = 0 ; i < nFrames ; ++i )
+	{
+		const xdp_desc &desc = pDescs[ ( nConsumer + i ) & ( m_ringRx.m_nSize-1 ) ];
+		pFrames[i].m_nAddr = desc.addr;
+		pFrames[i].m_pData = m_pUMEM + desc.addr;
+		pFrames[i].m_cbData = desc.len;
+	}
+
+	// The frames belong to us until we put them back on the fill
+	// ring, so we can release the descriptors right away
+	__atomic_store_n( m_ringRx.m_pConsumer, nConsumer + nFrames, __ATOMIC_RELEASE );
+	return nFrames;
+}
+
+void CXDPSocket::RecycleRecvFrames( const RecvFrame_t *pFrames, int nFrames )
+{
+	Assert( IsValid() );
+	if ( nFrames <= 0 )
+		return;
+
+	// There are never more receive frames than slots in the fill ring,
+	// so there is always room
+	uint32 nProducer = *m_ringFill.m_pProducer;
+	Assert( nProducer + nFrames - __atomic_load_n( m_ringFill.m_pConsumer, __ATOMIC_ACQUIRE ) <= m_ringFill.m_nSize );
+	uint64 *pFill = (uint64 *)m_ringFill.m_pDesc;
+	for ( int i = 0 ; i < nFrames ; ++i )
+		pFill[ ( nProducer + i ) & ( m_ringFill.m_nSize-1 ) ] = pFrames[i].m_nAddr & ~(uint64)( k_cbFrame-1 );
+	__atomic_store_n( m_ringFill.m_pProducer, nProducer + nFrames, __ATOMIC_RELEASE );
+
+	// Kernel might have stopped filling frames when it ran out
+	if ( m_bNeedWakeup && ( __atomic_load_n( m_ringFill.m_pFlags, __ATOMIC_RELAXED ) & XDP_RING_NEED_WAKEUP ) )
+		recvfrom( m_fd, nullptr, 0, MSG_DONTWAIT, nullptr, nullptr );
+}
+
+void CXDPSocket::ReapCompletions()
+{
+	uint32 nConsumer = *m_ringCompletion.m_pConsumer;
+	uint32 nProducer = __atomic_load_n( m_ringCompletion.m_pProducer, __ATOMIC_ACQUIRE );
+	if ( nConsumer == nProducer )
+		return;
+	const uint64 *pAddrs = (const uint64 *)m_ringCompletion.m_pDesc;
+	for ( uint32 n = nConsumer ; n != nProducer ; ++n )
+		m_vecTxFramesFree.push_back( pAddrs[ n & ( m_ringCompletion.m_nSize-1 ) ] );
+	__atomic_store_n( m_ringCompletion.m_pConsumer, nProducer, __ATOMIC_RELEASE );
+}
+
+uint8 *CXDPSocket::AllocTxFrame( uint64 &nAddr )
+{
+	Assert( IsValid() );
+	if ( m_vecTxFramesFree.empty() )
+	{
+		ReapCompletions();
+		if ( m_vecTxFramesFree.empty() )
+			return nullptr;
+	}
+	nAddr = m_vecTxFramesFree.back();
+	m_vecTxFramesFree.pop_back();
+	return m_pUMEM + nAddr;
+}
+
+void CXDPSocket::QueueTxFrame( uint64 nAddr, int cbFrame )
+{
+	Assert( IsValid() );
+	Assert( cbFrame > 0 && cbFrame <= k_cbFrame );
+
+	// There are never more transmit frames than slots in the ring
+	xdp_desc *pDescs = (xdp_desc *)m_ringTx.m_pDesc;
+	xdp_desc &desc = pDescs[ m_nTxProducerLocal & ( m_ringTx.m_nSize-1 ) ];
+	desc.addr = nAddr;
+	desc.len = cbFrame;
+	desc.options = 0;
+	++m_nTxProducerLocal;
+}
+
+void CXDPSocket::FlushTx()
+{
+	Assert( IsValid() );
+	if ( BHasQueuedTx() )
+	{
+		__atomic_store_n( m_ringTx.m_pProducer, m_nTxProducerLocal, __ATOMIC_RELEASE );
+
+		// Kick the kernel, if it needs it.  In copy mode, it always does,
+		// and this is where the frames are actually sent.  If it's busy,
+		// it will pick them up on the next kick.
+		if ( !m_bNeedWakeup || ( __atomic_load_n( m_ringTx.m_pFlags, __ATOMIC_RELAXED ) & XDP_RING_NEED_WAKEUP ) )
+			sendto( m_fd, nullptr, 0, MSG_DONTWAIT, nullptr, 0 );
+	}
+
+	ReapCompletions();
+}
+
+static uint16 IPv4HeaderChecksum( const uint8 *pHdr )
+{
+	uint32 nSum = 0;
+	for ( int i = 0 ; i < 20 ; i += 2 )
+		nSum += ( pHdr[i] << 8 ) | pHdr[i+1];
+	while ( nSum >> 16 )
+		nSum = ( nSum & 0xffff ) + ( nSum >> 16 );
+	return (uint16)~nSum;
+}
+
+static inline uint16 ReadBE16( const uint8 *p ) { return (uint16)( ( p[0] << 8 ) | p[1] ); }
+static inline uint32 ReadBE32( const uint8 *p ) { return ( uint32(p[0]) << 24 ) | ( uint32(p[1]) << 16 ) | ( uint32(p[2]) << 8 ) | p[3]; }
+static inline void WriteBE16( uint8 *p, uint16 x ) { p[0] = (uint8)( x >> 8 ); p[1] = (uint8)x; }
+static inline void WriteBE32( uint8 *p, uint32 x ) { p[0] = (uint8)( x >> 24 ); p[1] = (uint8)( x >> 16 ); p[2] = (uint8)( x >> 8 ); p[3] = (uint8)x; }
+
+bool XDPParseUDPFrame( const uint8 *pFrame, int cbFrame, XDPUDPFrame_t &frame )
+{
+	// Our program has already checked the ethertype, the IP version and
+	// header length, the protocol, and that it's not a fragment.
+	if ( cbFrame < k_cbXDPUDPHeaders )
+		return false;
+	const uint8 *pIP = pFrame + 14;
+	const uint8 *pUDP = pIP + 20;
+
+	// Trust the lengths in the headers, not the frame size, which might
+	// include Ethernet padding
+	int cbIP = ReadBE16( pIP + 2 );
+	int cbUDP = ReadBE16( pUDP + 4 );
+	if ( cbIP < 20+8 || 14 + cbIP > cbFrame || cbUDP < 8 || 20 + cbUDP > cbIP )
+		return false;
+
+	memcpy( frame.m_macDst, pFrame, 6 );
+	memcpy( frame.m_macSrc, pFrame + 6, 6 );
+	frame.m_nSrcIP = ReadBE32( pIP + 12 );
+	frame.m_nDstIP = ReadBE32( pIP + 16 );
+	frame.m_nSrcPort = ReadBE16( pUDP );
+	frame.m_nDstPort = ReadBE16( pUDP + 2 );
+	frame.m_pPayload = pUDP + 8;
+	frame.m_cbPayload = cbUDP - 8;
+	return true;
+}
+
+void XDPWriteUDPHeaders( uint8 *pFrame, const XDPUDPFrame_t &frame )
+{
+	// Ethernet
+	memcpy( pFrame, frame.m_macDst, 6 );
+	memcpy( pFrame + 6, frame.m_macSrc, 6 );
+	WriteBE16( pFrame + 12, 0x0800 );
+
+	// IPv4.  Don't fragment, so the ID doesn't matter
+	uint8 *pIP = pFrame + 14;
+	pIP[0] = 0x45;
+	pIP[1] = 0;
+	WriteBE16( pIP + 2, (uint16)( 20 + 8 + frame.m_cbPayload ) );
+	WriteBE16( pIP + 4, 0 );
+	WriteBE16( pIP + 6, 0x4000 );
+	pIP[8] = 64; // TTL
+	pIP[9] = IPPROTO_UDP;
+	WriteBE16( pIP + 10, 0 );
+	WriteBE32( pIP + 12, frame.m_nSrcIP );
+	WriteBE32( pIP + 16, frame.m_nDstIP );
+	WriteBE16( pIP + 10, IPv4HeaderChecksum( pIP ) );
+
+	// UDP
+	uint8 *pUDP = pIP + 20;
+	WriteBE16( pUDP, frame.m_nSrcPort );
+	WriteBE16( pUDP + 2, frame.m_nDstPort );
+	WriteBE16( pUDP + 4, (uint16)( 8 + frame.m_cbPayload ) );
+	WriteBE16( pUDP + 6, 0 );
+}
+
+} // namespace SteamNetworkingSocketsLib
+
+#endif // #ifdef STEAMNETWORKINGSOCKETS_XDP
@@ -0,0 +1,165 @@
+//====== Copyright Valve Corporation, All rights reserved. ====================
+//
+// Minimal AF_XDP socket bound to one queue of a network interface, so that
+// raw UDP sockets can bypass most of the kernel network stack.  Like our
+// io_uring wrapper, this talks to the kernel directly through the system
+// calls.  (We don't depend on libbpf or libxdp.)  It sets up the UMEM region
+// and the four rings, and loads a tiny XDP program (assembled by hand) that
+// redirects IPv4 UDP packets addressed to the ports we are interested in.
+// Everything else goes up the normal stack.
+//
+//=============================================================================
+
+#ifndef STEAMNETWORKINGSOCKETS_XDP_H
+#define STEAMNETWORKINGSOCKETS_XDP_H
+#ifdef _WIN32
+#pragma once
+#endif
+
+#include "../steamnetworkingsockets_internal.h"
+
+// Only available on Linux, and only if the kernel headers we are building
+// against are new enough to know about the need_wakeup flags and XDP links.
+// Whether the kernel we are actually running on supports it is checked at runtime.
+#if defined( LINUX ) && defined( __has_include )
+	#if __has_include( <linux/if_xdp.h> ) && __has_include( <linux/bpf.h> ) && __has_include( <linux/if_link.h> )
+		#include <linux/if_xdp.h>
+		#include <linux/if_link.h>
+		#if defined( XDP_USE_NEED_WAKEUP ) && defined( XDP_FLAGS_REPLACE )
+			#define STEAMNETWORKINGSOCKETS_XDP
+		#endif
+	#endif
+#endif
+
+#ifdef STEAMNETWORKINGSOCKETS_XDP
+
+namespace SteamNetworkingSocketsLib {
+
+/// Ethernet + IPv4 + UDP headers.  We don't handle IP options or VLAN tags.
+constexpr int k_cbXDPUDPHeaders = 14 + 20 + 8;
+
+/// Addresses and payload of an Ethernet/IPv4/UDP frame.  Addresses and
+/// ports are in host byte order.
+struct XDPUDPFrame_t
+{
+	uint8 m_macSrc[6];
+	uint8 m_macDst[6];
+	uint32 m_nSrcIP;
+	uint32 m_nDstIP;
+	uint16 m_nSrcPort;
+	uint16 m_nDstPort;
+	const uint8 *m_pPayload;
+	int m_cbPayload;
+};
+
+/// Parse a frame that our XDP program redirected to us.  Returns false if it's
+/// malformed.  We don't check the UDP checksum; our protocols have their own
+/// integrity checks.
+extern bool XDPParseUDPFrame( const uint8 *pFrame, int cbFrame, XDPUDPFrame_t &frame );
+
+/// Fill in the Ethernet, IPv4 and UDP headers, for a payload of the
+/// specified size that immediately follows them.  (The UDP checksum is
+/// left blank, which is allowed for IPv4.)
+extern void XDPWriteUDPHeaders( uint8 *pFrame, const XDPUDPFrame_t &frame );
+
+class CXDPSocket
+{
+public:
+	CXDPSocket() {}
+	~CXDPSocket() { Kill(); }
+
+	/// Size of each frame in the UMEM.  One packet per frame.
+	static constexpr int k_cbFrame = 2048;
+
+	/// Load and attach the XDP program to the interface, and create the
+	/// socket bound to the specified queue.  Returns false if anything fails,
+	/// in which case the caller should just use ordinary sockets.
+	bool BInit( const char *pszInterface, int nQueue, SteamDatagramErrMsg &errMsg );
+
+	/// Detach the program and tear everything down
+	void Kill();
+
+	inline bool IsValid() const { return m_fd >= 0; }
+
+	/// Descriptor to wait on.  It is readable when there are received frames
+	inline int GetFD() const { return m_fd; }
+
+	/// Start or stop redirecting IPv4 UDP packets addressed to the
+	/// specified port (host byte order) to us.
+	bool BAddPort( uint16 nPort );
+	void RemovePort( uint16 nPort );
+
+	/// A received frame.  m_pData points into the UMEM, and is valid until
+	/// the frame is given back with RecycleRecvFrames.
+	struct RecvFrame_t
+	{
+		uint64 m_nAddr;
+		uint8 *m_pData;
+		int m_cbData;
+	};
+
+	/// Pull up to nMaxFrames frames off of the receive ring
+	int ReceiveFrames( RecvFrame_t *pFrames, int nMaxFrames );
+
+	/// Give received frames back to the kernel, so they can be filled again
+	void RecycleRecvFrames( const RecvFrame_t *pFrames, int nFrames );
+
+	/// Get a frame buffer to transmit from.  Returns nullptr if all of our
+	/// transmit frames are in flight.
+	uint8 *AllocTxFrame( uint64 &nAddr );
+
+	/// Queue a frame from AllocTxFrame to be sent.  Nothing is actually
+	/// handed to the kernel until FlushTx.
+	void QueueTxFrame( uint64 nAddr, int cbFrame );
+
+	inline bool BHasQueuedTx() const { return m_nTxProducerLocal != *m_ringTx.m_pProducer; }
+
+	/// Hand all queued frames to the kernel
+	void FlushTx();
+
+private:
+
+	/// One of the four rings shared with the kernel
+	struct Ring_t
+	{
+		uint32 *m_pProducer = nullptr;
+		uint32 *m_pConsumer = nullptr;
+		uint32 *m_pFlags = nullptr;
+		void *m_pDesc = nullptr;
+		uint32 m_nSize = 0;
+		void *m_pMap = nullptr;
+		size_t m_cbMap = 0;
+	};
+	bool BMapRing( Ring_t &ring, const xdp_ring_offset &off, uint32 nSize, size_t cbDesc, uint64 nPageOffset, SteamDatagramErrMsg &errMsg );
+	void UnmapRing( Ring_t &ring );
+
+	/// Recycle transmit frames that the kernel is done with
+	void ReapCompletions();
+
+	int m_fd = -1;
+	int m_nIfIndex = 0;
+	bool m_bNeedWakeup = false;
+
+	// BPF objects
+	int m_fdMapPorts = -1;
+	int m_fdMapXSKs = -1;
+	int m_fdProg = -1;
+	int m_fdLink = -1;
+
+	// UMEM.  The first half of the frames are used for receiving, the
+	// second half for transmitting.
+	uint8 *m_pUMEM = nullptr;
+	size_t m_cbUMEM = 0;
+	Ring_t m_ringFill;
+	Ring_t m_ringCompletion;
+	Ring_t m_ringRx;
+	Ring_t m_ringTx;
+	uint32 m_nTxProducerLocal = 0; // Filled in, but might not be published to the kernel
+	std::vector<uint64> m_vecTxFramesFree;
+};
+
+} // namespace SteamNetworkingSocketsLib
+
+#endif // #ifdef STEAMNETWORKINGSOCKETS_XDP
+
+#endif // STEAMNETWORKINGSOCKETS_XDP_H
@@ -207,7 +207,11 @@ struct SteamDatagramLinkLifetimeStats
 	short m_nPingNtile75th; // 70% of ping samples were <= Nms
 	short m_nPingNtile95th; // 95% of ping samples were <= Nms
 	short m_nPingNtile98th; // 98% of ping samples were <= Nms
-	short m__pad1;
+
+	// True if any of the percentiles (ping, quality, speed) were estimated
+	// from the histograms, rather than computed from individual samples.
+	// (See k_ESteamNetworkingConfig_LinkStatsDetail.)
+	bool m_bNtilesEstimated;
 
 
 	//
@@ -158,25 +158,36 @@ protected:
 	void ReceivedPing( int nPingMS, SteamNetworkingMicroseconds usecNow );
 };
 
+/// Estimate a percentile from counts by bucket, for when we didn't keep the
+/// samples.  (See LinkStatsPercentileSamples.)  Buckets are in increasing
+/// order.  arUpper[i] is the largest value counted in bucket i, and the
+/// first bucket starts at nLowest.  We assume values are spread evenly
+/// within each bucket.  Returns -1 if there are fewer than nMinSamples.
+extern int EstimatePercentileFromHistogram( float flPct, int nMinSamples, int nBuckets, const int *arCount, int nLowest, const int *arUpper );
+
 /// Ping tracker that tracks detailed lifetime stats
 struct PingTrackerDetailed : PingTracker
 {
 	void Reset()
 	{
 		PingTracker::Reset();
-		m_sample.Clear();
+		if ( m_pSample )
+			m_pSample->Clear();
 		m_histogram.Reset();
 	}
 	void ReceivedPing( int nPingMS, SteamNetworkingMicroseconds usecNow )
 	{
 		PingTracker::ReceivedPing( nPingMS, usecNow );
-		m_sample.AddSample( std::min( nPingMS, 0xffff ) );
+		if ( m_pSample )
+			m_pSample->AddSample( std::min( nPingMS, 0xffff ) );
 		m_histogram.AddSample( nPingMS );
 	}
 
 	/// Track sample of pings received so we can generate percentiles.
-	/// Also tracks how many pings we have received total
-	PercentileGenerator<uint16> m_sample;
+	/// Also tracks how many pings we have received total.  This is
+	/// owned by the link stats tracker, and is null unless we are
+	/// collecting percentiles.  (See LinkStatsPercentileSamples)
+	PercentileGenerator<uint16> *m_pSample = nullptr;
 
 	/// Counts by bucket
 	PingHistogram m_histogram;
@@ -186,14 +197,53 @@ struct PingTrackerDetailed : PingTracker
 	{
 		s.m_pingHistogram  = m_histogram;
 
-		s.m_nPingNtile5th  = m_sample.NumSamples() < 20 ? -1 : m_sample.GetPercentile( .05f );
-		s.m_nPingNtile50th = m_sample.NumSamples() <  2 ? -1 : m_sample.GetPercentile( .50f );
-		s.m_nPingNtile75th = m_sample.NumSamples() <  4 ? -1 : m_sample.GetPercentile( .75f );
-		s.m_nPingNtile95th = m_sample.NumSamples() < 20 ? -1 : m_sample.GetPercentile( .95f );
-		s.m_nPingNtile98th = m_sample.NumSamples() < 50 ? -1 : m_sample.GetPercentile( .98f );
+		// Use the samples if they saw every ping.  Otherwise, estimate
+		// from the histogram, which always does.
+		if ( m_pSample && m_pSample->NumSamplesTotal() >= m_histogram.TotalCount() )
+		{
+			const int nSamples = m_pSample->NumSamples();
+			s.m_nPingNtile5th  = nSamples < 20 ? -1 : m_pSample->GetPercentile( .05f );
+			s.m_nPingNtile50th = nSamples <  2 ? -1 : m_pSample->GetPercentile( .50f );
+			s.m_nPingNtile75th = nSamples <  4 ? -1 : m_pSample->GetPercentile( .75f );
+			s.m_nPingNtile95th = nSamples < 20 ? -1 : m_pSample->GetPercentile( .95f );
+			s.m_nPingNtile98th = nSamples < 50 ? -1 : m_pSample->GetPercentile( .98f );
+		}
+		else
+		{
+			// We don't know how high pings in the top bucket went, so
+			// they count as the lowest value in the bucket
+			const int arCount[] = { m_histogram.m_n25, m_histogram.m_n50, m_histogram.m_n75, m_histogram.m_n100, m_histogram.m_n125, m_histogram.m_n150, m_histogram.m_n200, m_histogram.m_n300, m_histogram.m_nMax };
+			static const int arUpper[] = { 25, 50, 75, 100, 125, 150, 200, 300, 301 };
+			s.m_nPingNtile5th  = EstimatePercentileFromHistogram( .05f, 20, V_ARRAYSIZE( arCount ), arCount, 0, arUpper );
+			s.m_nPingNtile50th = EstimatePercentileFromHistogram( .50f,  2, V_ARRAYSIZE( arCount ), arCount, 0, arUpper );
+			s.m_nPingNtile75th = EstimatePercentileFromHistogram( .75f,  4, V_ARRAYSIZE( arCount ), arCount, 0, arUpper );
+			s.m_nPingNtile95th = EstimatePercentileFromHistogram( .95f, 20, V_ARRAYSIZE( arCount ), arCount, 0, arUpper );
+			s.m_nPingNtile98th = EstimatePercentileFromHistogram( .98f, 50, V_ARRAYSIZE( arCount ), arCount, 0, arUpper );
+			if ( s.m_nPingNtile50th >= 0 )
+				s.m_bNtilesEstimated = true;
+		}
 	}
 };
 
+/// Samples used to compute lifetime percentiles.  These are several KB,
+/// most connections never have anybody look at them, and the histograms
+/// (which are small and always kept) are usually enough.  So they live
+/// in a side structure that is only allocated when asked for.  (See
+/// k_ESteamNetworkingConfig_LinkStatsDetail.)  If the samples don't cover
+/// the whole connection, lifetime percentiles are estimated from the
+/// histograms instead.  The speed samples are only used for end-to-end
+/// stats.
+struct LinkStatsPercentileSamples
+{
+	PercentileGenerator<uint16> m_ping;
+	PercentileGenerator<uint8> m_quality;
+	PercentileGenerator<int> m_TXSpeed;
+	PercentileGenerator<int> m_RXSpeed;
+};
+
+/// Number of entries in the debug history of received sequence numbers
+const int k_nLinkStatsDebugHistoryRecvSeqNum = 256;
+
 /// Before switching to a different route, we need to make sure that we have a ping
 /// sample in at least N recent time buckets.  (See PingTrackerForRouteSelection)
 const int k_nRecentValidTimeBucketsToSwitchRoute = 15;
@@ -463,7 +513,7 @@ struct LinkStatsTrackerBase
 	// TEMP delete this once I track down the accounting bug
 	int64 m_nDebugLastInitMaxRecvPktNum;
 	int64 m_nDebugPktsRecvInOrder;
-	int64 m_arDebugHistoryRecvSeqNum[ 256 ];
+	int64 *m_pDebugHistoryRecvSeqNum = nullptr; // k_nLinkStatsDebugHistoryRecvSeqNum entries, only if LinkStatsDetail >= 2
 	std::string HistoryRecvSeqNumDebugString( int nMaxPkts ) const;
 
 	/// Setup state to expect the next packet to be nPktNum+1,
@@ -561,8 +611,13 @@ struct LinkStatsTrackerBase
 	int64 m_nPktsRecvDuplicate;
 	int64 m_nPktsRecvSequenceNumberLurch; // sequence number had a really large discontinuity
 
-	/// Lifetime quality statistics
-	PercentileGenerator<uint8> m_qualitySample;
+	/// Samples for lifetime percentiles.  Null unless somebody asked for
+	/// them.  The histograms are always kept.
+	LinkStatsPercentileSamples *m_pSamples = nullptr;
+
+	/// Allocate m_pSamples, if we haven't already.  Percentiles only
+	/// cover what happens after this.
+	void EnsurePercentileSamples();
 
 	/// Histogram of quality intervals
 	QualityHistogram m_qualityHistogram;
@@ -720,6 +775,9 @@ protected:
 	// Make sure it's used as abstract base.  Note that we require you to call Init()
 	// with a timestamp value, so the constructor is empty by default.
 	inline LinkStatsTrackerBase() {}
+	~LinkStatsTrackerBase();
+	LinkStatsTrackerBase( const LinkStatsTrackerBase & ) = delete;
+	LinkStatsTrackerBase &operator=( const LinkStatsTrackerBase & ) = delete;
 
 	/// Initialize the stats tracking object
 	void InitInternal( SteamNetworkingMicroseconds usecNow );
@@ -886,7 +944,6 @@ struct LinkStatsTrackerEndToEnd : public LinkStatsTrackerBase
 	/// TX Speed, should match CMsgSteamDatagramLinkLifetimeStats 
 	int m_nTXSpeed; 
 	int m_nTXSpeedMax; 
-	PercentileGenerator<int> m_TXSpeedSample;
 	int m_nTXSpeedHistogram16; // Speed at kb/s
 	int m_nTXSpeedHistogram32; 
 	int m_nTXSpeedHistogram64;
@@ -899,7 +956,6 @@ struct LinkStatsTrackerEndToEnd : public LinkStatsTrackerBase
 	/// RX Speed, should match CMsgSteamDatagramLinkLifetimeStats 
 	int m_nRXSpeed;
 	int m_nRXSpeedMax;
-	PercentileGenerator<int> m_RXSpeedSample;
 	int m_nRXSpeedHistogram16; // Speed at kb/s
 	int m_nRXSpeedHistogram32; 
 	int m_nRXSpeedHistogram64;
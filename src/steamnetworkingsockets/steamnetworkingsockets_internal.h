@@ -738,6 +738,7 @@ struct ConnectionConfig
 	ConfigValue<int32> m_Unencrypted;
 	ConfigValue<int32> m_SymmetricConnect;
 	ConfigValue<int32> m_LocalVirtualPort;
+	ConfigValue<int32> m_IP_ListenSocketShards;
 
 	ConfigValue<int32> m_LogLevel_AckRTT;
 	ConfigValue<int32> m_LogLevel_PacketDecode;
@@ -781,6 +782,25 @@ extern GlobalConfigValue<float> g_Config_FakePacketDup_Send;
 extern GlobalConfigValue<float> g_Config_FakePacketDup_Recv;
 extern GlobalConfigValue<int32> g_Config_FakePacketDup_TimeMax;
 extern GlobalConfigValue<int32> g_Config_EnumerateDevVars;
+extern GlobalConfigValue<int32> g_Config_UDPSendBatchSize;
+extern GlobalConfigValue<int32> g_Config_UDPSendGSO;
+extern GlobalConfigValue<int32> g_Config_UDPRecvGRO;
+extern GlobalConfigValue<int32> g_Config_UDPIOUring;
+extern GlobalConfigValue<int32> g_Config_UDPRecvKernelTimestamps;
+extern GlobalConfigValue<int32> g_Config_ServiceThreadSpinWindow;
+extern GlobalConfigValue<int32> g_Config_ServiceThreadBusyPoll;
+extern GlobalConfigValue<int32> g_Config_UDPSocketBusyPoll;
+extern GlobalConfigValue<std::string> g_Config_XDP_Interface;
+extern GlobalConfigValue<int32> g_Config_XDP_Queue;
+extern GlobalConfigValue<int32> g_Config_UDPRecvBufferMax;
+extern GlobalConfigValue<std::string> g_Config_ServiceThreadAffinity;
+extern GlobalConfigValue<int32> g_Config_ServiceThreadSchedPolicy;
+extern GlobalConfigValue<int32> g_Config_ServiceThreadSchedPriority;
+extern GlobalConfigValue<std::string> g_Config_ServiceThreadName;
+extern GlobalConfigValue<int32> g_Config_TimerSlack;
+extern GlobalConfigValue<int32> g_Config_LockFreeSendQueueSize;
+extern GlobalConfigValue<int32> g_Config_PollGroupRecvRingSize;
+extern GlobalConfigValue<int32> g_Config_LinkStatsDetail;
 
 #ifdef STEAMNETWORKINGSOCKETS_ENABLE_STEAMNETWORKINGMESSAGES
 extern GlobalConfigValue<void*> g_Config_Callback_MessagesSessionRequest;
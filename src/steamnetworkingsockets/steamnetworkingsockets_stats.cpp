@@ -138,8 +138,37 @@ int PingTracker::WorstPingInRecentSample() const
 	return nResult;
 }
 
+LinkStatsTrackerBase::~LinkStatsTrackerBase()
+{
+	m_ping.m_pSample = nullptr;
+	delete m_pSamples;
+	delete [] m_pDebugHistoryRecvSeqNum;
+}
+
+void LinkStatsTrackerBase::EnsurePercentileSamples()
+{
+	if ( m_pSamples )
+		return;
+	m_pSamples = new LinkStatsPercentileSamples;
+	m_ping.m_pSample = &m_pSamples->m_ping;
+}
+
 void LinkStatsTrackerBase::InitInternal( SteamNetworkingMicroseconds usecNow )
 {
+	// Side structures, only allocated if asked for.  If we already
+	// have them, keep them, they are cleared below.
+	const int nDetail = g_Config_LinkStatsDetail.Get();
+	if ( nDetail >= 1 )
+		EnsurePercentileSamples();
+	if ( m_pSamples )
+	{
+		m_pSamples->m_quality.Clear();
+		m_pSamples->m_TXSpeed.Clear();
+		m_pSamples->m_RXSpeed.Clear();
+	}
+	if ( nDetail >= 2 && !m_pDebugHistoryRecvSeqNum )
+		m_pDebugHistoryRecvSeqNum = new int64[ k_nLinkStatsDebugHistoryRecvSeqNum ];
+
 	m_nPeerProtocolVersion = 0;
 	m_bPassive = false;
 	m_sent.Reset();
@@ -167,7 +196,6 @@ void LinkStatsTrackerBase::InitInternal( SteamNetworkingMicroseconds usecNow )
 	//m_seqnumUnackedSentLifetime = -1;
 	//m_seqnumPendingAckRecvTimelife = -1;
 	m_qualityHistogram.Reset();
-	m_qualitySample.Clear();
 	m_jitterHistogram.Reset();
 }
 
@@ -217,7 +245,8 @@ void LinkStatsTrackerBase::UpdateInterval( SteamNetworkingMicroseconds usecNow )
 			if ( nBad == 0 )
 			{
 				// Perfect connection.  This will hopefully be relatively common
-				m_qualitySample.AddSample( 100 );
+				if ( m_pSamples )
+					m_pSamples->m_quality.AddSample( 100 );
 				++m_qualityHistogram.m_n100;
 			}
 			else
@@ -232,17 +261,20 @@ void LinkStatsTrackerBase::UpdateInterval( SteamNetworkingMicroseconds usecNow )
 				// I don't think it's possible for the calculation above to ever produce 100, but whatever.
 				if ( nQuality >= 99 )
 				{
-					m_qualitySample.AddSample( 99 );
+					if ( m_pSamples )
+						m_pSamples->m_quality.AddSample( 99 );
 					++m_qualityHistogram.m_n99;
 				}
 				else if ( nQuality <= 1 ) // in case accounting is hosed or every single packet was out of order, clamp.  0 means "totally dead connection"
 				{
-					m_qualitySample.AddSample( 1 );
+					if ( m_pSamples )
+						m_pSamples->m_quality.AddSample( 1 );
 					++m_qualityHistogram.m_n1;
 				}
 				else
 				{
-					m_qualitySample.AddSample( nQuality );
+					if ( m_pSamples )
+						m_pSamples->m_quality.AddSample( nQuality );
 					if ( nQuality >= 97 )
 						++m_qualityHistogram.m_n97;
 					else if ( nQuality >= 95 )
@@ -265,7 +297,8 @@ void LinkStatsTrackerBase::UpdateInterval( SteamNetworkingMicroseconds usecNow )
 			// He's dead, Jim.  But we've been trying pretty hard to talk to him, so it probably isn't
 			// because the connection is just idle or shutting down.  The connection has probably
 			// dropped.
-			m_qualitySample.AddSample(0);
+			if ( m_pSamples )
+				m_pSamples->m_quality.AddSample( 0 );
 			++m_qualityHistogram.m_nDead;
 		}
 	}
@@ -326,16 +359,18 @@ std::string LinkStatsTrackerBase::RecvPktNumStateDebugString() const
 
 std::string LinkStatsTrackerBase::HistoryRecvSeqNumDebugString( int nMaxPkts ) const
 {
-	constexpr int N = V_ARRAYSIZE( m_arDebugHistoryRecvSeqNum );
+	constexpr int N = k_nLinkStatsDebugHistoryRecvSeqNum;
 	COMPILE_TIME_ASSERT( ( N & (N-1) ) == 0 );
 	nMaxPkts = std::min( nMaxPkts, N );
 
 	std::string result;
+	if ( !m_pDebugHistoryRecvSeqNum )
+		return "(set LinkStatsDetail=2)";
 	int64 idx = m_nPktsRecvSequenced;
 	while ( --nMaxPkts >= 0 && --idx >= 0 )
 	{
 		char buf[32];
-		V_sprintf_safe( buf, "%s%lld", result.empty() ? "" : ",", (long long)m_arDebugHistoryRecvSeqNum[ idx & (N-1) ] );
+		V_sprintf_safe( buf, "%s%lld", result.empty() ? "" : ",", (long long)m_pDebugHistoryRecvSeqNum[ idx & (N-1) ] );
 		result.append( buf );
 	}
 
@@ -347,7 +382,8 @@ bool LinkStatsTrackerBase::BCheckPacketNumberOldOrDuplicate( int64 nPktNum )
 	// We've received a packet with a sequence number.
 	// Update stats
 	++m_nPktsRecvSequencedCurrentInterval;
-	m_arDebugHistoryRecvSeqNum[ m_nPktsRecvSequenced & 255 ] = nPktNum;
+	if ( m_pDebugHistoryRecvSeqNum )
+		m_pDebugHistoryRecvSeqNum[ m_nPktsRecvSequenced & ( k_nLinkStatsDebugHistoryRecvSeqNum-1 ) ] = nPktNum;
 	++m_nPktsRecvSequenced;
 
 	// Packet number is increasing?
@@ -474,20 +510,20 @@ void LinkStatsTrackerBase::TrackProcessSequencedPacket( int64 nPktNum, SteamNetw
 					Describe().c_str()
 				);
 				#ifdef IS_STEAMDATAGRAMROUTER
-				int64 idx = m_nPktsRecvSequenced-1;
+				int64 idx = m_pDebugHistoryRecvSeqNum ? m_nPktsRecvSequenced-1 : -1;
 				while ( idx >= 0 )
 				{
 					CUtlBuffer buf( 0, 1024, CUtlBuffer::TEXT_BUFFER );
 					switch ( idx )
 					{
-						default: buf.Printf( "%7lld", (long long)m_arDebugHistoryRecvSeqNum[ idx-- & 255 ] ); 
-						case  6: buf.Printf( "%7lld", (long long)m_arDebugHistoryRecvSeqNum[ idx-- & 255 ] ); 
-						case  5: buf.Printf( "%7lld", (long long)m_arDebugHistoryRecvSeqNum[ idx-- & 255 ] ); 
-						case  4: buf.Printf( "%7lld", (long long)m_arDebugHistoryRecvSeqNum[ idx-- & 255 ] ); 
-						case  3: buf.Printf( "%7lld", (long long)m_arDebugHistoryRecvSeqNum[ idx-- & 255 ] ); 
-						case  2: buf.Printf( "%7lld", (long long)m_arDebugHistoryRecvSeqNum[ idx-- & 255 ] ); 
-						case  1: buf.Printf( "%7lld", (long long)m_arDebugHistoryRecvSeqNum[ idx-- & 255 ] ); 
-						case  0: buf.Printf( "%7lld", (long long)m_arDebugHistoryRecvSeqNum[ idx-- & 255 ] );
+						default: buf.Printf( "%7lld", (long long)m_pDebugHistoryRecvSeqNum[ idx-- & 255 ] ); 
+						case  6: buf.Printf( "%7lld", (long long)m_pDebugHistoryRecvSeqNum[ idx-- & 255 ] ); 
+						case  5: buf.Printf( "%7lld", (long long)m_pDebugHistoryRecvSeqNum[ idx-- & 255 ] ); 
+						case  4: buf.Printf( "%7lld", (long long)m_pDebugHistoryRecvSeqNum[ idx-- & 255 ] ); 
+						case  3: buf.Printf( "%7lld", (long long)m_pDebugHistoryRecvSeqNum[ idx-- & 255 ] ); 
+						case  2: buf.Printf( "%7lld", (long long)m_pDebugHistoryRecvSeqNum[ idx-- & 255 ] ); 
+						case  1: buf.Printf( "%7lld", (long long)m_pDebugHistoryRecvSeqNum[ idx-- & 255 ] ); 
+						case  0: buf.Printf( "%7lld", (long long)m_pDebugHistoryRecvSeqNum[ idx-- & 255 ] );
 					}
 					buf.PutChar( '\n' );
 					g_pLogger->Write( buf.Base(), buf.TellPut() );
@@ -710,11 +746,29 @@ void LinkStatsTrackerBase::GetLifetimeStats( SteamDatagramLinkLifetimeStats &s )
 	s.m_nPktsRecvSequenceNumberLurch = m_nPktsRecvSequenceNumberLurch;
 
 	s.m_qualityHistogram = m_qualityHistogram;
+	s.m_bNtilesEstimated = false;
 
-	s.m_nQualityNtile50th = m_qualitySample.NumSamples() <  2 ? -1 : m_qualitySample.GetPercentile( .50f );
-	s.m_nQualityNtile25th = m_qualitySample.NumSamples() <  4 ? -1 : m_qualitySample.GetPercentile( .25f );
-	s.m_nQualityNtile5th  = m_qualitySample.NumSamples() < 20 ? -1 : m_qualitySample.GetPercentile( .05f );
-	s.m_nQualityNtile2nd  = m_qualitySample.NumSamples() < 50 ? -1 : m_qualitySample.GetPercentile( .02f );
+	// Use the samples if they saw every interval.  Otherwise, estimate from
+	// the histogram, which always does.
+	if ( m_pSamples && m_pSamples->m_quality.NumSamplesTotal() >= m_qualityHistogram.TotalCount() )
+	{
+		const int nQualitySamples = m_pSamples->m_quality.NumSamples();
+		s.m_nQualityNtile50th = nQualitySamples <  2 ? -1 : m_pSamples->m_quality.GetPercentile( .50f );
+		s.m_nQualityNtile25th = nQualitySamples <  4 ? -1 : m_pSamples->m_quality.GetPercentile( .25f );
+		s.m_nQualityNtile5th  = nQualitySamples < 20 ? -1 : m_pSamples->m_quality.GetPercentile( .05f );
+		s.m_nQualityNtile2nd  = nQualitySamples < 50 ? -1 : m_pSamples->m_quality.GetPercentile( .02f );
+	}
+	else
+	{
+		const int arCount[] = { m_qualityHistogram.m_nDead, m_qualityHistogram.m_n1, m_qualityHistogram.m_n50, m_qualityHistogram.m_n75, m_qualityHistogram.m_n90, m_qualityHistogram.m_n95, m_qualityHistogram.m_n97, m_qualityHistogram.m_n99, m_qualityHistogram.m_n100 };
+		static const int arUpper[] = { 0, 49, 74, 89, 94, 96, 98, 99, 100 };
+		s.m_nQualityNtile50th = EstimatePercentileFromHistogram( .50f,  2, V_ARRAYSIZE( arCount ), arCount, 0, arUpper );
+		s.m_nQualityNtile25th = EstimatePercentileFromHistogram( .25f,  4, V_ARRAYSIZE( arCount ), arCount, 0, arUpper );
+		s.m_nQualityNtile5th  = EstimatePercentileFromHistogram( .05f, 20, V_ARRAYSIZE( arCount ), arCount, 0, arUpper );
+		s.m_nQualityNtile2nd  = EstimatePercentileFromHistogram( .02f, 50, V_ARRAYSIZE( arCount ), arCount, 0, arUpper );
+		if ( s.m_nQualityNtile50th >= 0 )
+			s.m_bNtilesEstimated = true;
+	}
 
 	m_ping.GetLifetimeStats( s );
 
@@ -794,7 +848,6 @@ void LinkStatsTrackerEndToEnd::InitInternal( SteamNetworkingMicroseconds usecNow
 	m_usecWhenStartedConnectedState = 0;
 	m_usecWhenEndedConnectedState = 0;
 
-	m_TXSpeedSample.Clear();
 	m_nTXSpeed = 0;
 	m_nTXSpeedHistogram16 = 0; // Speed at kb/s
 	m_nTXSpeedHistogram32 = 0; 
@@ -805,7 +858,6 @@ void LinkStatsTrackerEndToEnd::InitInternal( SteamNetworkingMicroseconds usecNow
 	m_nTXSpeedHistogram1024 = 0;
 	m_nTXSpeedHistogramMax = 0;
 
-	m_RXSpeedSample.Clear();
 	m_nRXSpeed = 0;
 	m_nRXSpeedHistogram16 = 0; // Speed at kb/s
 	m_nRXSpeedHistogram32 = 0; 
@@ -830,7 +882,8 @@ void LinkStatsTrackerEndToEnd::UpdateSpeedInterval( SteamNetworkingMicroseconds
 	flElapsed = Max( flElapsed, .001f ); // make sure math doesn't blow up
 
 	int nTXKBs = ( m_nTXSpeed + 512 ) / 1024;
-	m_TXSpeedSample.AddSample( nTXKBs );
+	if ( m_pSamples )
+		m_pSamples->m_TXSpeed.AddSample( nTXKBs );
 
 	if ( nTXKBs <= 16 ) ++m_nTXSpeedHistogram16;
 	else if ( nTXKBs <= 32 ) ++m_nTXSpeedHistogram32; 
@@ -842,7 +895,8 @@ void LinkStatsTrackerEndToEnd::UpdateSpeedInterval( SteamNetworkingMicroseconds
 	else ++m_nTXSpeedHistogramMax;
 	
 	int nRXKBs = ( m_nRXSpeed + 512 ) / 1024;
-	m_RXSpeedSample.AddSample( nRXKBs );
+	if ( m_pSamples )
+		m_pSamples->m_RXSpeed.AddSample( nRXKBs );
 
 	if ( nRXKBs <= 16 ) ++m_nRXSpeedHistogram16;
 	else if ( nRXKBs <= 32 ) ++m_nRXSpeedHistogram32; 
@@ -891,11 +945,28 @@ void LinkStatsTrackerEndToEnd::GetLifetimeStats( SteamDatagramLinkLifetimeStats
 	s.m_nTXSpeedHistogram1024 = m_nTXSpeedHistogram1024;
 	s.m_nTXSpeedHistogramMax  = m_nTXSpeedHistogramMax; 
 
-	s.m_nTXSpeedNtile5th  = m_TXSpeedSample.NumSamples() < 20 ? -1 : m_TXSpeedSample.GetPercentile( .05f );
-	s.m_nTXSpeedNtile50th = m_TXSpeedSample.NumSamples() <  2 ? -1 : m_TXSpeedSample.GetPercentile( .50f );
-	s.m_nTXSpeedNtile75th = m_TXSpeedSample.NumSamples() <  4 ? -1 : m_TXSpeedSample.GetPercentile( .75f );
-	s.m_nTXSpeedNtile95th = m_TXSpeedSample.NumSamples() < 20 ? -1 : m_TXSpeedSample.GetPercentile( .95f );
-	s.m_nTXSpeedNtile98th = m_TXSpeedSample.NumSamples() < 50 ? -1 : m_TXSpeedSample.GetPercentile( .98f );
+	// Same as quality and ping.  (See LinkStatsTrackerBase::GetLifetimeStats)
+	if ( m_pSamples && m_pSamples->m_TXSpeed.NumSamplesTotal() >= s.TXSpeedHistogramTotalCount() )
+	{
+		const int nTXSpeedSamples = m_pSamples->m_TXSpeed.NumSamples();
+		s.m_nTXSpeedNtile5th  = nTXSpeedSamples < 20 ? -1 : m_pSamples->m_TXSpeed.GetPercentile( .05f );
+		s.m_nTXSpeedNtile50th = nTXSpeedSamples <  2 ? -1 : m_pSamples->m_TXSpeed.GetPercentile( .50f );
+		s.m_nTXSpeedNtile75th = nTXSpeedSamples <  4 ? -1 : m_pSamples->m_TXSpeed.GetPercentile( .75f );
+		s.m_nTXSpeedNtile95th = nTXSpeedSamples < 20 ? -1 : m_pSamples->m_TXSpeed.GetPercentile( .95f );
+		s.m_nTXSpeedNtile98th = nTXSpeedSamples < 50 ? -1 : m_pSamples->m_TXSpeed.GetPercentile( .98f );
+	}
+	else
+	{
+		const int arCount[] = { m_nTXSpeedHistogram16, m_nTXSpeedHistogram32, m_nTXSpeedHistogram64, m_nTXSpeedHistogram128, m_nTXSpeedHistogram256, m_nTXSpeedHistogram512, m_nTXSpeedHistogram1024, m_nTXSpeedHistogramMax };
+		const int arUpper[] = { 16, 32, 64, 128, 256, 512, 1024, std::max( 1025, ( m_nTXSpeedMax + 512 ) / 1024 ) };
+		s.m_nTXSpeedNtile5th  = EstimatePercentileFromHistogram( .05f, 20, V_ARRAYSIZE( arCount ), arCount, 0, arUpper );
+		s.m_nTXSpeedNtile50th = EstimatePercentileFromHistogram( .50f,  2, V_ARRAYSIZE( arCount ), arCount, 0, arUpper );
+		s.m_nTXSpeedNtile75th = EstimatePercentileFromHistogram( .75f,  4, V_ARRAYSIZE( arCount ), arCount, 0, arUpper );
+		s.m_nTXSpeedNtile95th = EstimatePercentileFromHistogram( .95f, 20, V_ARRAYSIZE( arCount ), arCount, 0, arUpper );
+		s.m_nTXSpeedNtile98th = EstimatePercentileFromHistogram( .98f, 50, V_ARRAYSIZE( arCount ), arCount, 0, arUpper );
+		if ( s.m_nTXSpeedNtile50th >= 0 )
+			s.m_bNtilesEstimated = true;
+	}
 
 	s.m_nRXSpeedMax           = m_nRXSpeedMax;
 
@@ -908,16 +979,59 @@ void LinkStatsTrackerEndToEnd::GetLifetimeStats( SteamDatagramLinkLifetimeStats
 	s.m_nRXSpeedHistogram1024 = m_nRXSpeedHistogram1024;
 	s.m_nRXSpeedHistogramMax  = m_nRXSpeedHistogramMax; 
 
-	s.m_nRXSpeedNtile5th  = m_RXSpeedSample.NumSamples() < 20 ? -1 : m_RXSpeedSample.GetPercentile( .05f );
-	s.m_nRXSpeedNtile50th = m_RXSpeedSample.NumSamples() <  2 ? -1 : m_RXSpeedSample.GetPercentile( .50f );
-	s.m_nRXSpeedNtile75th = m_RXSpeedSample.NumSamples() <  4 ? -1 : m_RXSpeedSample.GetPercentile( .75f );
-	s.m_nRXSpeedNtile95th = m_RXSpeedSample.NumSamples() < 20 ? -1 : m_RXSpeedSample.GetPercentile( .95f );
-	s.m_nRXSpeedNtile98th = m_RXSpeedSample.NumSamples() < 50 ? -1 : m_RXSpeedSample.GetPercentile( .98f );
+	if ( m_pSamples && m_pSamples->m_RXSpeed.NumSamplesTotal() >= s.RXSpeedHistogramTotalCount() )
+	{
+		const int nRXSpeedSamples = m_pSamples->m_RXSpeed.NumSamples();
+		s.m_nRXSpeedNtile5th  = nRXSpeedSamples < 20 ? -1 : m_pSamples->m_RXSpeed.GetPercentile( .05f );
+		s.m_nRXSpeedNtile50th = nRXSpeedSamples <  2 ? -1 : m_pSamples->m_RXSpeed.GetPercentile( .50f );
+		s.m_nRXSpeedNtile75th = nRXSpeedSamples <  4 ? -1 : m_pSamples->m_RXSpeed.GetPercentile( .75f );
+		s.m_nRXSpeedNtile95th = nRXSpeedSamples < 20 ? -1 : m_pSamples->m_RXSpeed.GetPercentile( .95f );
+		s.m_nRXSpeedNtile98th = nRXSpeedSamples < 50 ? -1 : m_pSamples->m_RXSpeed.GetPercentile( .98f );
+	}
+	else
+	{
+		const int arCount[] = { m_nRXSpeedHistogram16, m_nRXSpeedHistogram32, m_nRXSpeedHistogram64, m_nRXSpeedHistogram128, m_nRXSpeedHistogram256, m_nRXSpeedHistogram512, m_nRXSpeedHistogram1024, m_nRXSpeedHistogramMax };
+		const int arUpper[] = { 16, 32, 64, 128, 256, 512, 1024, std::max( 1025, ( m_nRXSpeedMax + 512 ) / 1024 ) };
+		s.m_nRXSpeedNtile5th  = EstimatePercentileFromHistogram( .05f, 20, V_ARRAYSIZE( arCount ), arCount, 0, arUpper );
+		s.m_nRXSpeedNtile50th = EstimatePercentileFromHistogram( .50f,  2, V_ARRAYSIZE( arCount ), arCount, 0, arUpper );
+		s.m_nRXSpeedNtile75th = EstimatePercentileFromHistogram( .75f,  4, V_ARRAYSIZE( arCount ), arCount, 0, arUpper );
+		s.m_nRXSpeedNtile95th = EstimatePercentileFromHistogram( .95f, 20, V_ARRAYSIZE( arCount ), arCount, 0, arUpper );
+		s.m_nRXSpeedNtile98th = EstimatePercentileFromHistogram( .98f, 50, V_ARRAYSIZE( arCount ), arCount, 0, arUpper );
+		if ( s.m_nRXSpeedNtile50th >= 0 )
+			s.m_bNtilesEstimated = true;
+	}
 }
 
 namespace SteamNetworkingSocketsLib
 {
 
+int EstimatePercentileFromHistogram( float flPct, int nMinSamples, int nBuckets, const int *arCount, int nLowest, const int *arUpper )
+{
+	int nTotal = 0;
+	for ( int i = 0 ; i < nBuckets ; ++i )
+		nTotal += arCount[i];
+	if ( nTotal < nMinSamples || nTotal <= 0 )
+		return -1;
+
+	// Find the bucket with the sample at this rank, and interpolate
+	// within it
+	const float flRank = flPct * nTotal;
+	int nBefore = 0;
+	int nBucketLowest = nLowest;
+	for ( int i = 0 ; i < nBuckets ; ++i )
+	{
+		if ( arCount[i] > 0 && nBefore + arCount[i] > flRank )
+		{
+			const float flFrac = ( flRank - nBefore ) / arCount[i];
+			const int nResult = nBucketLowest + int( flFrac * ( arUpper[i] - nBucketLowest + 1 ) );
+			return std::min( nResult, arUpper[i] );
+		}
+		nBefore += arCount[i];
+		nBucketLowest = arUpper[i] + 1;
+	}
+	return arUpper[ nBuckets-1 ];
+}
+
 void LinkStatsInstantaneousStructToMsg( const SteamDatagramLinkInstantaneousStats &s, CMsgSteamDatagramLinkInstantaneousStats &msg )
 {
 	msg.set_out_packets_per_sec_x10( uint32( s.m_flOutPacketsPerSec * 10.0f ) );
@@ -1054,6 +1168,9 @@ void LinkStatsLifetimeStructToMsg( const SteamDatagramLinkLifetimeStats &s, CMsg
 	SET_NTILE( s.m_nRXSpeedNtile95th, rxspeed_ntile_95th )
 	SET_NTILE( s.m_nRXSpeedNtile98th, rxspeed_ntile_98th )
 
+	if ( s.m_bNtilesEstimated )
+		msg.set_ntiles_estimated( true );
+
 	#undef SET_HISTOGRAM
 	#undef SET_NTILE
 }
@@ -1146,6 +1263,8 @@ void LinkStatsLifetimeMsgToStruct( const CMsgSteamDatagramLinkLifetimeStats &msg
 	SET_NTILE( s.m_nRXSpeedNtile95th, rxspeed_ntile_95th )
 	SET_NTILE( s.m_nRXSpeedNtile98th, rxspeed_ntile_98th )
 
+	s.m_bNtilesEstimated = msg.ntiles_estimated();
+
 	#undef SET_HISTOGRAM
 	#undef SET_NTILE
 }
@@ -1274,7 +1393,7 @@ void LinkStatsPrintLifetimeToBuf( const char *pszLeader, const SteamDatagramLink
 
 			if ( temp1[0] != '\0' )
 			{
-				buf.Printf( "%sPing distribution:\n", pszLeader );
+				buf.Printf( "%sPing distribution:%s\n", pszLeader, stats.m_bNtilesEstimated ? "  (estimated from histogram)" : "" );
 				buf.Printf( "%s%s\n", pszLeader, temp1 );
 				buf.Printf( "%s%s\n", pszLeader, temp2 );
 			}
@@ -1339,7 +1458,7 @@ void LinkStatsPrintLifetimeToBuf( const char *pszLeader, const SteamDatagramLink
 
 			if ( temp1[0] != '\0' )
 			{
-				buf.Printf( "%sConnection quality distribution:\n", pszLeader );
+				buf.Printf( "%sConnection quality distribution:%s\n", pszLeader, stats.m_bNtilesEstimated ? "  (estimated from histogram)" : "" );
 				buf.Printf( "%s%s\n", pszLeader, temp1 );
 				buf.Printf( "%s%s\n", pszLeader, temp2 );
 			}
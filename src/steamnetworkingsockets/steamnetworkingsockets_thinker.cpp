@@ -6,7 +6,8 @@
 	#pragma GCC diagnostic ignored "-Wstrict-overflow"
 #endif
 
-#include <tier1/utlpriorityqueue.h>
+#include <algorithm>
+#include <vector>
 
 #include "steamnetworkingsockets_thinker.h"
 
@@ -27,24 +28,217 @@ namespace SteamNetworkingSocketsLib {
 //
 /////////////////////////////////////////////////////////////////////////////
 
-struct ThinkerLess
+static CThinkerWheel s_wheelThinkers;
+
+/// Scratch space for thinkers that we are moving down while advancing the wheel
+static std::vector<IThinker *> s_vecThinkersToRefile;
+
+void CThinkerWheel::File( IThinker *pThinker )
+{
+	const uint64 usecThink = (uint64)pThinker->m_usecNextThinkTime;
+	if ( usecThink <= m_usecCurrent )
+	{
+		// Insert into the due list, keeping it in order.  Usually this is
+		// an append, when we are refiling in order while advancing.  But an
+		// ASAP request goes before anything else that is due.  Ties go
+		// after the thinkers that were already there.
+		IThinker *pPrev = m_pDueTail;
+		while ( pPrev && (uint64)pPrev->m_usecNextThinkTime > usecThink )
+			pPrev = pPrev->m_pPrevScheduled;
+		IThinker *pNext = pPrev ? pPrev->m_pNextScheduled : m_pSlotHead[ k_nDueSlot ];
+		pThinker->m_nScheduledSlot = k_nDueSlot;
+		pThinker->m_pPrevScheduled = pPrev;
+		pThinker->m_pNextScheduled = pNext;
+		if ( pPrev )
+			pPrev->m_pNextScheduled = pThinker;
+		else
+			m_pSlotHead[ k_nDueSlot ] = pThinker;
+		if ( pNext )
+			pNext->m_pPrevScheduled = pThinker;
+		else
+			m_pDueTail = pThinker;
+		return;
+	}
+
+	const int nLevel = FindMostSignificantBit64( usecThink ^ m_usecCurrent ) / k_nSlotBits;
+	const int nSlot = nLevel*k_nSlotsPerLevel + (int)( ( usecThink >> ( nLevel*k_nSlotBits ) ) & ( k_nSlotsPerLevel-1 ) );
+	pThinker->m_nScheduledSlot = nSlot;
+	pThinker->m_pPrevScheduled = nullptr;
+	pThinker->m_pNextScheduled = m_pSlotHead[ nSlot ];
+	if ( m_pSlotHead[ nSlot ] )
+		m_pSlotHead[ nSlot ]->m_pPrevScheduled = pThinker;
+	m_pSlotHead[ nSlot ] = pThinker;
+	m_nOccupied[ nLevel ] |= uint64(1) << ( nSlot & ( k_nSlotsPerLevel-1 ) );
+}
+
+void CThinkerWheel::Unlink( IThinker *pThinker )
+{
+	const int nSlot = pThinker->m_nScheduledSlot;
+	Assert( nSlot >= 0 && nSlot <= k_nDueSlot );
+	if ( pThinker->m_pPrevScheduled )
+	{
+		pThinker->m_pPrevScheduled->m_pNextScheduled = pThinker->m_pNextScheduled;
+	}
+	else
+	{
+		Assert( m_pSlotHead[ nSlot ] == pThinker );
+		m_pSlotHead[ nSlot ] = pThinker->m_pNextScheduled;
+	}
+	if ( pThinker->m_pNextScheduled )
+		pThinker->m_pNextScheduled->m_pPrevScheduled = pThinker->m_pPrevScheduled;
+	else if ( nSlot == k_nDueSlot )
+		m_pDueTail = pThinker->m_pPrevScheduled;
+
+	if ( nSlot < k_nDueSlot && !m_pSlotHead[ nSlot ] )
+		m_nOccupied[ nSlot / k_nSlotsPerLevel ] &= ~( uint64(1) << ( nSlot & ( k_nSlotsPerLevel-1 ) ) );
+
+	pThinker->m_pPrevScheduled = nullptr;
+	pThinker->m_pNextScheduled = nullptr;
+	pThinker->m_nScheduledSlot = -1;
+}
+
+void CThinkerWheel::Insert( IThinker *pThinker, SteamNetworkingMicroseconds usecThink )
+{
+	Assert( pThinker->m_nScheduledSlot < 0 );
+	Assert( usecThink > 0 && usecThink != k_nThinkTime_Never );
+	pThinker->m_usecNextThinkTime = usecThink;
+	File( pThinker );
+	++m_nCount;
+
+	// New earliest?  (If we don't know the earliest, but we are at the
+	// lower bound, then we are one of the earliest.)
+	if ( usecThink < m_usecEarliestLowerBound || ( usecThink == m_usecEarliestLowerBound && !m_pEarliest ) )
+	{
+		m_pEarliest = pThinker;
+		m_usecEarliestLowerBound = usecThink;
+	}
+}
+
+void CThinkerWheel::Remove( IThinker *pThinker )
 {
-	bool operator()( const IThinker *a, const IThinker *b ) const
+	Unlink( pThinker );
+	Assert( m_nCount > 0 );
+	--m_nCount;
+
+	// Removing the earliest doesn't make anything else earlier, so
+	// the lower bound is still good.  We'll search when somebody asks.
+	if ( m_nCount == 0 )
 	{
-		return a->GetNextThinkTime() > b->GetNextThinkTime();
+		m_pEarliest = nullptr;
+		m_usecEarliestLowerBound = k_nThinkTime_Never;
 	}
-};
-class ThinkerSetIndex
+	else if ( pThinker == m_pEarliest )
+	{
+		m_pEarliest = nullptr;
+	}
+}
+
+IThinker *CThinkerWheel::GetEarliest()
 {
-public:
-	static void SetIndex( IThinker *p, int idx ) { p->m_queueIndex = idx; }
-};
+	if ( m_pEarliest || m_nCount == 0 )
+		return m_pEarliest;
+
+	// Anything due?  Then that's all before anything on the wheel,
+	// and the due list is in order.
+	IThinker *pList = m_pSlotHead[ k_nDueSlot ];
+	if ( pList )
+	{
+		m_pEarliest = pList;
+		m_usecEarliestLowerBound = pList->m_usecNextThinkTime;
+		return pList;
+	}
+
+	// Otherwise, search the first occupied slot on the lowest occupied level
+	for ( int nLevel = 0 ; nLevel < k_nLevels ; ++nLevel )
+	{
+		if ( m_nOccupied[ nLevel ] )
+		{
+			pList = m_pSlotHead[ nLevel*k_nSlotsPerLevel + FindLeastSignificantBit64( m_nOccupied[ nLevel ] ) ];
+			break;
+		}
+	}
+	Assert( pList );
 
-static CUtlPriorityQueue<IThinker*,ThinkerLess,ThinkerSetIndex> s_queueThinkers;
+	IThinker *pEarliest = pList;
+	for ( IThinker *p = pList->m_pNextScheduled ; p ; p = p->m_pNextScheduled )
+	{
+		if ( p->m_usecNextThinkTime < pEarliest->m_usecNextThinkTime )
+			pEarliest = p;
+	}
+
+	m_pEarliest = pEarliest;
+	m_usecEarliestLowerBound = pEarliest->m_usecNextThinkTime;
+	return pEarliest;
+}
+
+SteamNetworkingMicroseconds CThinkerWheel::ApplySlack( SteamNetworkingMicroseconds usecTime, SteamNetworkingMicroseconds usecSlack ) const
+{
+	const SteamNetworkingMicroseconds usecLatest = usecTime + usecSlack;
+
+	// Is the service thread already going to wake up during the window?
+	if ( m_usecEarliestLowerBound >= usecTime && m_usecEarliestLowerBound <= usecLatest )
+		return m_usecEarliestLowerBound;
+
+	// Round to the coarsest boundary in the window, so that thinkers
+	// that want to wake up at about the same time land on the same
+	// microsecond.  (The same thing the Linux kernel does with timer slack.)
+	const int nBit = FindMostSignificantBit64( uint64( usecTime ^ usecLatest ) );
+	return SteamNetworkingMicroseconds( uint64( usecLatest ) & ~( ( uint64(1) << nBit ) - 1 ) );
+}
+
+void CThinkerWheel::Advance( SteamNetworkingMicroseconds usecTime )
+{
+	const uint64 usecNew = (uint64)usecTime;
+	if ( usecTime <= 0 || usecNew <= m_usecCurrent )
+		return;
+
+	// Everything below the level where the new time differs from the current
+	// time needs to be refiled.  On that level, only the slots we are
+	// passing over do.  Levels above that are not affected.
+	const int nTopLevel = FindMostSignificantBit64( usecNew ^ m_usecCurrent ) / k_nSlotBits;
+	s_vecThinkersToRefile.clear();
+	for ( int nLevel = 0 ; nLevel <= nTopLevel ; ++nLevel )
+	{
+		uint64 nSlotMask = ~uint64(0);
+		if ( nLevel == nTopLevel )
+		{
+			const int nShift = nLevel*k_nSlotBits;
+			const int nSlotCur = (int)( ( m_usecCurrent >> nShift ) & ( k_nSlotsPerLevel-1 ) );
+			const int nSlotNew = (int)( ( usecNew >> nShift ) & ( k_nSlotsPerLevel-1 ) );
+			Assert( nSlotNew > nSlotCur );
+			nSlotMask = ( ( uint64(2) << nSlotNew ) - 1 ) & ~( ( uint64(2) << nSlotCur ) - 1 );
+		}
+
+		uint64 nSlots = m_nOccupied[ nLevel ] & nSlotMask;
+		m_nOccupied[ nLevel ] &= ~nSlotMask;
+		while ( nSlots )
+		{
+			const int nSlot = nLevel*k_nSlotsPerLevel + FindLeastSignificantBit64( nSlots );
+			nSlots &= nSlots-1;
+			for ( IThinker *p = m_pSlotHead[ nSlot ] ; p ; p = p->m_pNextScheduled )
+				s_vecThinkersToRefile.push_back( p );
+			m_pSlotHead[ nSlot ] = nullptr;
+		}
+	}
+
+	m_usecCurrent = usecNew;
+
+	// Refile them in order, so that the ones that are now due get
+	// added to the due list in the order they wanted to think.
+	if ( s_vecThinkersToRefile.size() > 1 )
+	{
+		std::sort( s_vecThinkersToRefile.begin(), s_vecThinkersToRefile.end(),
+			[]( const IThinker *a, const IThinker *b ) { return a->GetNextThinkTime() < b->GetNextThinkTime(); } );
+	}
+	for ( IThinker *p: s_vecThinkersToRefile )
+		File( p );
+}
 
 IThinker::IThinker()
 : m_usecNextThinkTime( k_nThinkTime_Never )
-, m_queueIndex( -1 )
+, m_pPrevScheduled( nullptr )
+, m_pNextScheduled( nullptr )
+, m_nScheduledSlot( -1 )
 {
 }
 
@@ -58,7 +252,7 @@ IThinker::~IThinker()
 	#pragma GCC diagnostic ignored "-Wstrict-overflow"
 #endif
 
-void IThinker::SetNextThinkTime( SteamNetworkingMicroseconds usecTargetThinkTime )
+void IThinker::SetNextThinkTime( SteamNetworkingMicroseconds usecTargetThinkTime, SteamNetworkingMicroseconds usecSlack )
 {
 	// Protect against us blowing up because of an invalid think time.
 	// Zero is reserved (since it often means there is an uninitialized value),
@@ -71,79 +265,74 @@ void IThinker::SetNextThinkTime( SteamNetworkingMicroseconds usecTargetThinkTime
 		usecTargetThinkTime = SteamNetworkingSockets_GetLocalTimestamp() + 2000;
 	}
 
+	// Allowed to be late?  Then try to share a wakeup
+	if ( usecSlack > 0 && usecTargetThinkTime < k_nThinkTime_Never - usecSlack )
+		usecTargetThinkTime = s_wheelThinkers.ApplySlack( usecTargetThinkTime, usecSlack );
+
+	// No change?
+	if ( usecTargetThinkTime == m_usecNextThinkTime )
+		return;
+
 	// Clearing it?
 	if ( usecTargetThinkTime == k_nThinkTime_Never )
 	{
-		if ( m_queueIndex >= 0 )
-		{
-			Assert( s_queueThinkers.Element( m_queueIndex ) == this );
-			s_queueThinkers.RemoveAt( m_queueIndex );
-			Assert( m_queueIndex == -1 );
-		}
+		if ( m_nScheduledSlot >= 0 )
+			s_wheelThinkers.Remove( this );
 
 		m_usecNextThinkTime = k_nThinkTime_Never;
 		return;
 	}
 
-	// Save current time when the next thinker wants service
+	// Save current time when the next thinker wants service.  (Or
+	// possibly a bit earlier.  That's fine.  If the earliest thinker was
+	// rescheduled later since the service thread went to sleep, the
+	// thread is still going to wake up at the earlier time.)
 	#ifndef IS_STEAMDATAGRAMROUTER
-		SteamNetworkingMicroseconds usecNextWake = ( s_queueThinkers.Count() > 0 ) ? s_queueThinkers.ElementAtHead()->GetNextThinkTime() : k_nThinkTime_Never;
+		SteamNetworkingMicroseconds usecNextWake = s_wheelThinkers.GetEarliestLowerBound();
 	#endif
 
-	// Not currently scheduled?
-	if ( m_queueIndex < 0 )
+	// Currently scheduled?  Then take us out of our old slot
+	if ( m_nScheduledSlot >= 0 )
 	{
-		Assert( m_usecNextThinkTime == k_nThinkTime_Never );
-		m_usecNextThinkTime = usecTargetThinkTime;
-		s_queueThinkers.Insert( this );
+		Assert( m_usecNextThinkTime != k_nThinkTime_Never );
+		s_wheelThinkers.Remove( this );
 	}
 	else
 	{
-
-		// We're already scheduled.
-		Assert( s_queueThinkers.Element( m_queueIndex ) == this );
-		Assert( m_usecNextThinkTime != k_nThinkTime_Never );
-
-		// Set the new schedule time
-		m_usecNextThinkTime = usecTargetThinkTime;
-
-		// And update our position in the queue
-		s_queueThinkers.RevaluateElement( m_queueIndex );
+		Assert( m_usecNextThinkTime == k_nThinkTime_Never );
 	}
 
-	// Check that we know our place
-	Assert( m_queueIndex >= 0 );
-	Assert( s_queueThinkers.Element( m_queueIndex ) == this );
+	// Set the new schedule time, and file us in the right slot
+	s_wheelThinkers.Insert( this, usecTargetThinkTime );
 
 	#ifndef IS_STEAMDATAGRAMROUTER
 		// Do we need service before we were previously schedule to wake up?
 		// If so, wake the thread now so that it can redo its schedule work
 		// NOTE: On Windows we could use a waitable timer.  This would avoid
 		// waking up the service thread just to re-schedule when it should
-		// wake up for real.
+		// wake up for real.  If the thread is awake, it will see the new
+		// schedule before it goes back to sleep, so don't bother.
 		if ( m_usecNextThinkTime < usecNextWake )
-			WakeSteamDatagramThread();
+			WakeSteamDatagramThreadIfSleeping();
 	#endif
 }
 
 IThinker *Thinker_GetNextScheduled()
 {
-	if ( s_queueThinkers.Count() == 0 )
-		return nullptr;
-	return s_queueThinkers.ElementAtHead();
+	return s_wheelThinkers.GetEarliest();
 }
 
-void Thinker_ProcessThinkers()
+int Thinker_ProcessThinkers()
 {
 
-	// Until the queue is empty
+	// Until nothing else is due.  If lots of thinkers all came due at once
+	// (e.g. many connections timed out together), it's legit to run each of
+	// them a couple of times, so scale our sanity check to how many there are.
 	int nIterations = 0;
-	while ( s_queueThinkers.Count() > 0 )
+	const int nMaxIterations = 10000 + 2*s_wheelThinkers.Count();
+	for (;;)
 	{
 
-		// Grab the head element
-		IThinker *pNextThinker = s_queueThinkers.ElementAtHead();
-
 		// Refetch timestamp each time.  The reason is that certain thinkers
 		// may pass through to other systems (e.g. fake lag) that fetch the time.
 		// If we don't update the time here, that code may have used the newer
@@ -152,31 +341,30 @@ void Thinker_ProcessThinkers()
 		// a thinker.
 		SteamNetworkingMicroseconds usecNow = SteamNetworkingSockets_GetLocalTimestamp();
 
-		// Scheduled too far in the future?
-		if ( pNextThinker->GetNextThinkTime() >= usecNow )
+		// Grab the first thinker that is due.  If we've run out, advance the
+		// wheel to pick up anything scheduled before the current time.
+		IThinker *pNextThinker = s_wheelThinkers.GetFirstDue();
+		if ( !pNextThinker )
 		{
-			// Keep waiting
-			break;
+			s_wheelThinkers.Advance( usecNow-1 );
+			pNextThinker = s_wheelThinkers.GetFirstDue();
+
+			// Everything else is scheduled in the future.  Keep waiting
+			if ( !pNextThinker )
+				break;
 		}
 
 		++nIterations;
-		if ( nIterations > 10000 )
+		if ( nIterations > nMaxIterations )
 		{
 			AssertMsg1( false, "Processed thinkers %d times -- probably one thinker keeps requesting an immediate wakeup call.", nIterations );
+			--nIterations;
 			break;
 		}
 
 		// Go ahead and clear his think time now and remove him
-		// from the heap.  He needs to schedule a new think time
-		// if heeds service again.  For thinkers that need frequent
-		// service, removing them and then re-inserting them when
-		// they reschedule is a bit of extra work that could be
-		// optimized by trying to not remove them now, but adjusting
-		// them once we know when they want to think.  But this
-		// is probably just a bit too complicated for the expected
-		// benefit.  If the number of total Thinkers is relatively
-		// small (which it probably will be), the heap operations
-		// are probably negligible.
+		// from the wheel.  He needs to schedule a new think time
+		// if heeds service again.
 		pNextThinker->ClearNextThinkTime();
 
 		// Execute callback.  (Note: this could result
@@ -184,12 +372,15 @@ void Thinker_ProcessThinkers()
 		// to the rest of the queue.)
 		pNextThinker->Think( usecNow );
 	}
+
+	return nIterations;
 }
 
 #ifdef DBGFLAG_VALIDATE
 void Thinker_ValidateStatics( CValidator &validator )
 {
-	ValidateObj( s_queueThinkers );
+	// The wheel is a fixed size, and doesn't allocate anything.  The
+	// thinkers are owned by whoever is scheduling them.
 }
 #endif
 
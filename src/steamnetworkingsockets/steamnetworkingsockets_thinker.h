@@ -16,7 +16,7 @@ namespace SteamNetworkingSocketsLib {
 
 const SteamNetworkingMicroseconds k_nThinkTime_Never = INT64_MAX;
 const SteamNetworkingMicroseconds k_nThinkTime_ASAP = 1; // by convention, we do not allow setting a think time to 0, since 0 is often an uninitialized variable.
-class ThinkerSetIndex;
+class CThinkerWheel;
 
 class IThinker
 {
@@ -37,14 +37,20 @@ public:
 	/// Called to set when you next want to get your Think() callback.
 	/// You should assume that, due to scheduler inaccuracy, you could
 	/// get your callback 1 or 2 ms late.
-	void SetNextThinkTime( SteamNetworkingMicroseconds usecTargetThinkTime );
+	///
+	/// If you don't mind getting your callback up to usecSlack later
+	/// than requested, the scheduler may move it later, so that it
+	/// shares a wakeup with other thinkers.  GetNextThinkTime will
+	/// return the time actually chosen.
+	void SetNextThinkTime( SteamNetworkingMicroseconds usecTargetThinkTime, SteamNetworkingMicroseconds usecSlack = 0 );
 
 	/// Adjust schedule time to the earlier of the current schedule time,
-	/// or the given time.
-	inline void EnsureMinThinkTime( SteamNetworkingMicroseconds usecTargetThinkTime )
+	/// or the given time.  (If we are already scheduled to think no
+	/// later than usecSlack after the given time, that's good enough.)
+	inline void EnsureMinThinkTime( SteamNetworkingMicroseconds usecTargetThinkTime, SteamNetworkingMicroseconds usecSlack = 0 )
 	{
-		if ( usecTargetThinkTime < m_usecNextThinkTime )
-			SetNextThinkTime( usecTargetThinkTime );
+		if ( usecTargetThinkTime < m_usecNextThinkTime - usecSlack )
+			SetNextThinkTime( usecTargetThinkTime, usecSlack );
 	}
 
 	/// Clear the next think time.  You won't get a callback.
@@ -65,12 +71,103 @@ protected:
 
 private:
 	SteamNetworkingMicroseconds m_usecNextThinkTime;
-	int m_queueIndex;
-	friend class ThinkerSetIndex;
+
+	// Links in our slot of the timer wheel
+	IThinker *m_pPrevScheduled;
+	IThinker *m_pNextScheduled;
+	int m_nScheduledSlot;
+	friend class CThinkerWheel;
+};
+
+/// Hashed hierarchical timer wheel.  Level L has 64 slots, each 64^L
+/// microseconds wide.  A thinker is filed on the level of the most
+/// significant group of 6 bits in which its think time differs from the
+/// current time of the wheel, in the slot given by those bits.  So near
+/// deadlines are kept to the microsecond, and far ones in coarse slots.
+/// Scheduling, rescheduling and cancelling are all O(1).
+///
+/// Everything on a level is due before everything on the levels above it,
+/// and the occupied slots on a level are always after the current time.
+/// So the earliest thinker is in the first occupied slot of the lowest
+/// occupied level, and we only need to search that one slot to find it.
+///
+/// When we advance the current time, the slots we pass are emptied, and
+/// their thinkers are filed again.  They end up either on a lower level,
+/// or on the due list, which holds everything scheduled at or before the
+/// current time.  The due list is kept sorted by think time.
+///
+/// There is one global wheel that schedules all the IThinkers.  The class
+/// is declared here so that it can be tested on its own.
+class CThinkerWheel
+{
+public:
+	constexpr CThinkerWheel()
+	: m_pSlotHead{}
+	, m_pDueTail( nullptr )
+	, m_nOccupied{}
+	, m_usecCurrent( 0 )
+	, m_nCount( 0 )
+	, m_pEarliest( nullptr )
+	, m_usecEarliestLowerBound( k_nThinkTime_Never )
+	{}
+
+	inline int Count() const { return m_nCount; }
+
+	/// Add a thinker that isn't currently scheduled, and set its think time
+	void Insert( IThinker *pThinker, SteamNetworkingMicroseconds usecThink );
+
+	/// Remove a thinker that was previously inserted
+	void Remove( IThinker *pThinker );
+
+	/// Find the thinker that is scheduled to think first
+	IThinker *GetEarliest();
+
+	/// Return a time that is not later than the earliest think time.  This is
+	/// cheap.  It is exact, unless the earliest thinker has been removed or
+	/// rescheduled later and nobody has asked for the new earliest one since.
+	inline SteamNetworkingMicroseconds GetEarliestLowerBound() const { return m_usecEarliestLowerBound; }
+
+	/// Pick a time in the window [usecTime, usecTime+usecSlack] that
+	/// is likely to be shared with other thinkers.
+	SteamNetworkingMicroseconds ApplySlack( SteamNetworkingMicroseconds usecTime, SteamNetworkingMicroseconds usecSlack ) const;
+
+	/// Advance the current time, moving everything scheduled at or before
+	/// that time to the due list.  They are added in order of think time.
+	void Advance( SteamNetworkingMicroseconds usecTime );
+
+	/// First thinker on the due list, or nullptr if nothing is due
+	inline IThinker *GetFirstDue() const { return m_pSlotHead[ k_nDueSlot ]; }
+
+private:
+	static constexpr int k_nSlotBits = 6;
+	static constexpr int k_nSlotsPerLevel = 1 << k_nSlotBits;
+	static constexpr int k_nLevels = ( 64 + k_nSlotBits - 1 ) / k_nSlotBits;
+	static constexpr int k_nDueSlot = k_nLevels * k_nSlotsPerLevel;
+
+	/// Put thinker into the slot where it belongs, relative to the current time
+	void File( IThinker *pThinker );
+
+	/// Take thinker out of whatever slot it is in
+	void Unlink( IThinker *pThinker );
+
+	/// Head of each slot's list.  The last one is the due list.
+	IThinker *m_pSlotHead[ k_nDueSlot + 1 ];
+	IThinker *m_pDueTail;
+
+	/// Bitmask of non-empty slots on each level
+	uint64 m_nOccupied[ k_nLevels ];
+
+	uint64 m_usecCurrent;
+	int m_nCount;
+
+	/// Cached earliest thinker, or nullptr if we need to search
+	IThinker *m_pEarliest;
+	SteamNetworkingMicroseconds m_usecEarliestLowerBound;
 };
 
 extern IThinker *Thinker_GetNextScheduled();
-extern void Thinker_ProcessThinkers();
+/// Run all thinkers that are due.  Returns the number that were run
+extern int Thinker_ProcessThinkers();
 
 #ifdef DBGFLAG_VALIDATE
 extern void Thinker_ValidateStatics( CValidator &validator );
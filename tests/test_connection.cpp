@@ -2,11 +2,36 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdarg.h>
+#include <algorithm>
 #include <string.h>
 #include <string>
 #include <random>
 #include <chrono>
 #include <thread>
+#include <atomic>
+#include <vector>
+
+#ifdef __linux__
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#endif
+#ifdef __GLIBC__
+#include <malloc.h>
+
+// Bytes allocated on the heap.  mallinfo2 needs glibc 2.33.  Before that,
+// mallinfo has int fields, but they're fine for what we measure.
+static size_t GetHeapBytesInUse()
+{
+	#if __GLIBC_PREREQ( 2, 33 )
+		return mallinfo2().uordblks;
+	#else
+		return (unsigned)mallinfo().uordblks;
+	#endif
+}
+#endif
 
 #include <steam/steamnetworkingsockets.h>
 #include <steam/isteamnetworkingutils.h>
@@ -18,6 +43,9 @@
 
 static std::default_random_engine g_rand;
 static SteamNetworkingMicroseconds g_usecTestElapsed;
+static bool g_bExternalPoll = false;
+static bool g_bIOUring = false;
+static bool g_bXDP = false;
 
 FILE *g_fpLog = nullptr;
 SteamNetworkingMicroseconds g_logTimeZero;
@@ -52,6 +80,10 @@ static void DebugOutput( ESteamNetworkingSocketsDebugOutputType eType, const cha
 	}
 }
 
+// Checks that stay on in release builds.  (assert is compiled out with NDEBUG.)
+static bool g_bTestFailed = false;
+#define CHECK(x) do { if ( !(x) ) { Printf( "%s(%d): CHECK FAILED: %s\n", __FILE__, __LINE__, #x ); g_bTestFailed = true; } } while(0)
+
 static void Printf( const char *fmt, ... )
 {
 	char text[ 2048 ];
@@ -67,8 +99,11 @@ static void Printf( const char *fmt, ... )
 
 static void InitSteamDatagramConnectionSockets()
 {
-	g_fpLog = fopen( "log.txt", "wt" );
-	g_logTimeZero = SteamNetworkingUtils()->GetLocalTimestamp();
+	if ( !g_fpLog )
+	{
+		g_fpLog = fopen( "log.txt", "wt" );
+		g_logTimeZero = SteamNetworkingUtils()->GetLocalTimestamp();
+	}
 
 	SteamNetworkingUtils()->SetDebugOutputFunction( k_ESteamNetworkingSocketsDebugOutputType_Debug, DebugOutput );
 	//SteamNetworkingUtils()->SetDebugOutputFunction( k_ESteamNetworkingSocketsDebugOutputType_Verbose, DebugOutput );
@@ -217,6 +252,9 @@ struct SFakePeer
 static SFakePeer g_peerServer( "Server" );
 static SFakePeer g_peerClient( "Client" );
 
+// If valid, both connections are put in this poll group, and we receive from it
+static HSteamNetPollGroup g_hPollGroup = k_HSteamNetPollGroup_Invalid;
+
 static void Recv( ISteamNetworkingSockets *pSteamSocketNetworking )
 {
 
@@ -224,13 +262,27 @@ static void Recv( ISteamNetworkingSockets *pSteamSocketNetworking )
 	{
 		SFakePeer *pConnection = &g_peerServer;
 		ISteamNetworkingMessage *pIncomingMsg = nullptr;
-		int numMsgs = pSteamSocketNetworking->ReceiveMessagesOnConnection( pConnection->m_hSteamNetConnection, &pIncomingMsg, 1 );
-		if ( numMsgs <= 0 )
+		if ( g_hPollGroup != k_HSteamNetPollGroup_Invalid )
 		{
-			pConnection = &g_peerClient;
-			numMsgs = pSteamSocketNetworking->ReceiveMessagesOnConnection( pConnection->m_hSteamNetConnection, &pIncomingMsg, 1 );
+			int numMsgs = pSteamSocketNetworking->ReceiveMessagesOnPollGroup( g_hPollGroup, &pIncomingMsg, 1 );
 			if ( numMsgs <= 0 )
 				return;
+			if ( pIncomingMsg->m_conn != g_peerServer.m_hSteamNetConnection )
+			{
+				pConnection = &g_peerClient;
+				CHECK( pIncomingMsg->m_conn == g_peerClient.m_hSteamNetConnection );
+			}
+		}
+		else
+		{
+			int numMsgs = pSteamSocketNetworking->ReceiveMessagesOnConnection( pConnection->m_hSteamNetConnection, &pIncomingMsg, 1 );
+			if ( numMsgs <= 0 )
+			{
+				pConnection = &g_peerClient;
+				numMsgs = pSteamSocketNetworking->ReceiveMessagesOnConnection( pConnection->m_hSteamNetConnection, &pIncomingMsg, 1 );
+				if ( numMsgs <= 0 )
+					return;
+			}
 		}
 
 		const TestMsg *pTestMsg = static_cast<const TestMsg*>( pIncomingMsg->GetData() );
@@ -322,6 +374,8 @@ void OnSteamNetConnectionStatusChanged( SteamNetConnectionStatusChangedCallback_
 			g_peerServer.m_bIsConnected = true;
 			SteamNetworkingSockets()->AcceptConnection( pInfo->m_hConn );
 			SteamNetworkingSockets()->SetConnectionName( g_peerServer.m_hSteamNetConnection, "Server" );
+			if ( g_hPollGroup != k_HSteamNetPollGroup_Invalid )
+				SteamNetworkingSockets()->SetConnectionPollGroup( g_peerServer.m_hSteamNetConnection, g_hPollGroup );
 
 		}
 		break;
@@ -341,10 +395,36 @@ void OnSteamNetConnectionStatusChanged( SteamNetConnectionStatusChangedCallback_
 	}
 }
 
+// Let some time pass.  If we are driving the library from our own
+// event loop, then we need to service it while we wait.
+static void Wait( int msWait )
+{
+	#ifdef __linux__
+		if ( g_bExternalPoll )
+		{
+			SteamNetworkingMicroseconds usecNow = SteamNetworkingUtils()->GetLocalTimestamp();
+			const SteamNetworkingMicroseconds usecEnd = usecNow + msWait*1000;
+			do
+			{
+				SteamNetworkingMicroseconds usecWake = std::min( usecEnd, SteamNetworkingSockets_GetNextThinkTime() );
+				pollfd p;
+				p.fd = SteamNetworkingSockets_GetPollFD();
+				p.events = POLLIN;
+				p.revents = 0;
+				poll( &p, 1, usecWake > usecNow ? int( ( usecWake - usecNow + 999 ) / 1000 ) : 0 );
+				SteamNetworkingSockets_ProcessReady();
+				usecNow = SteamNetworkingUtils()->GetLocalTimestamp();
+			} while ( usecNow < usecEnd );
+			return;
+		}
+	#endif
+	std::this_thread::sleep_for( std::chrono::milliseconds( msWait ) );
+}
+
 static void PumpCallbacks()
 {
 	SteamNetworkingSockets()->RunCallbacks();
-	std::this_thread::sleep_for( std::chrono::milliseconds( 2 ) );
+	Wait( 2 );
 }
 
 static void PumpCallbacksAndMakeSureStillConnected()
@@ -511,18 +591,37 @@ static void TestNetworkConditions( int rate, float loss, int lag, float reorderP
 		PumpCallbacksAndMakeSureStillConnected();
 		Recv( pSteamSocketNetworking );
 		if ( bActLikeGame )
-			std::this_thread::sleep_for( std::chrono::milliseconds( 30 ) );
+			Wait( 30 );
 	}
 }
 
-static void RunSteamDatagramConnectionTest()
+// Check if the kernel will let us coalesce UDP sends
+static bool BKernelSupportsUDPGSO()
+{
+	#if defined( __linux__ ) && defined( UDP_SEGMENT )
+		int sock = socket( AF_INET, SOCK_DGRAM, 0 );
+		if ( sock < 0 )
+			return false;
+		int nSegmentSize = 0;
+		socklen_t cbOpt = sizeof(nSegmentSize);
+		bool bResult = getsockopt( sock, IPPROTO_UDP, UDP_SEGMENT, &nSegmentSize, &cbOpt ) == 0;
+		close( sock );
+		return bResult;
+	#else
+		return false;
+	#endif
+}
+
+// Open a listen socket and connect the client to it, and wait for both
+// ends to be connected.  Sockets are opened using the current global
+// config, so this is how a test phase gets sockets with different options.
+static void ConnectPeers()
 {
 	ISteamNetworkingSockets *pSteamSocketNetworking = SteamNetworkingSockets();
 
+	g_peerServer = SFakePeer( "Server" );
+	g_peerClient = SFakePeer( "Client" );
 
-	// Command line options:
-	// -connect:ip -- don't create a server, just try to connect to the given ip
-	// -serveronly -- don't create a client only create a server and wait for connection
 	SteamNetworkingIPAddr bindServerAddress;
 	bindServerAddress.Clear();
 	bindServerAddress.m_port = PORT_SERVER;
@@ -530,6 +629,108 @@ static void RunSteamDatagramConnectionTest()
 	SteamNetworkingIPAddr connectToServerAddress;
 	connectToServerAddress.SetIPv4( 0x7f000001, PORT_SERVER );
 
+	// Spread the listen socket over a few SO_REUSEPORT sockets, where
+	// supported, so that path gets exercised
+	SteamNetworkingConfigValue_t optListen;
+	optListen.SetInt32( k_ESteamNetworkingConfig_IP_ListenSocketShards, 4 );
+	g_hSteamListenSocket = pSteamSocketNetworking->CreateListenSocketIP( bindServerAddress, 1, &optListen );
+	CHECK( g_hSteamListenSocket != k_HSteamListenSocket_Invalid );
+	g_peerClient.m_hSteamNetConnection = pSteamSocketNetworking->ConnectByIPAddress( connectToServerAddress, 0, nullptr );
+	pSteamSocketNetworking->SetConnectionName( g_peerClient.m_hSteamNetConnection, "Client" );
+	if ( g_hPollGroup != k_HSteamNetPollGroup_Invalid )
+		pSteamSocketNetworking->SetConnectionPollGroup( g_peerClient.m_hSteamNetConnection, g_hPollGroup );
+
+//	// Send a few random message, before we get connected, just to test that case
+//	g_peerClient.SendRandomMessage( true );
+//	g_peerClient.SendRandomMessage( true );
+//	g_peerClient.SendRandomMessage( true );
+
+	// Wait for connection to complete
+	while ( !g_peerClient.m_bIsConnected || !g_peerServer.m_bIsConnected )
+		PumpCallbacks();
+}
+
+// Close both ends and the listen socket
+static void DisconnectPeers()
+{
+	ISteamNetworkingSockets *pSteamSocketNetworking = SteamNetworkingSockets();
+	Recv( pSteamSocketNetworking );
+	pSteamSocketNetworking->CloseConnection( g_peerClient.m_hSteamNetConnection, 0, nullptr, false );
+	pSteamSocketNetworking->CloseConnection( g_peerServer.m_hSteamNetConnection, 0, nullptr, false );
+	pSteamSocketNetworking->CloseListenSocket( g_hSteamListenSocket );
+	g_hSteamListenSocket = k_HSteamListenSocket_Invalid;
+	g_peerClient.m_hSteamNetConnection = k_HSteamNetConnection_Invalid;
+	g_peerServer.m_hSteamNetConnection = k_HSteamNetConnection_Invalid;
+	g_peerClient.m_bIsConnected = false;
+	g_peerServer.m_bIsConnected = false;
+	PumpCallbacks();
+}
+
+// Send messages both ways for a little while, and make sure that all of
+// the reliable ones arrive
+static void ExchangeMessages( int msDuration )
+{
+	ISteamNetworkingSockets *pSteamSocketNetworking = SteamNetworkingSockets();
+
+	SteamNetworkingUtils()->SetGlobalConfigValueInt32( k_ESteamNetworkingConfig_SendRateMin, 2000000 );
+	SteamNetworkingUtils()->SetGlobalConfigValueInt32( k_ESteamNetworkingConfig_SendRateMax, 2000000 );
+	SteamNetworkingUtils()->SetGlobalConfigValueFloat( k_ESteamNetworkingConfig_FakePacketLoss_Send, 0 );
+	SteamNetworkingUtils()->SetGlobalConfigValueInt32( k_ESteamNetworkingConfig_FakePacketLag_Send, 0 );
+	SteamNetworkingUtils()->SetGlobalConfigValueFloat( k_ESteamNetworkingConfig_FakePacketReorder_Send, 0 );
+
+	const SteamNetworkingMicroseconds usecStart = SteamNetworkingUtils()->GetLocalTimestamp();
+	SteamNetworkingMicroseconds usecNow = usecStart;
+	while ( usecNow < usecStart + msDuration*1000 )
+	{
+		g_peerServer.UpdateStats();
+		g_peerClient.UpdateStats();
+		if ( g_peerServer.GetQueuedSendBytes() < g_peerServer.m_nMaxPendingBytes )
+			g_peerServer.Send();
+		if ( g_peerClient.GetQueuedSendBytes() < g_peerClient.m_nMaxPendingBytes )
+			g_peerClient.Send();
+		PumpCallbacksAndMakeSureStillConnected();
+		Recv( pSteamSocketNetworking );
+		usecNow = SteamNetworkingUtils()->GetLocalTimestamp();
+	}
+
+	// Wait for the queues to drain
+	const SteamNetworkingMicroseconds usecGiveUp = usecNow + 10*1000000;
+	while (
+		( g_peerServer.m_nReliableExpectedRecvMsg <= g_peerClient.m_nReliableSendMsgCount
+		|| g_peerClient.m_nReliableExpectedRecvMsg <= g_peerServer.m_nReliableSendMsgCount )
+		&& SteamNetworkingUtils()->GetLocalTimestamp() < usecGiveUp
+	) {
+		PumpCallbacksAndMakeSureStillConnected();
+		Recv( pSteamSocketNetworking );
+	}
+
+	Printf( "Exchanged %lld and %lld reliable messages\n",
+		(long long)g_peerClient.m_nReliableSendMsgCount, (long long)g_peerServer.m_nReliableSendMsgCount );
+	CHECK( g_peerClient.m_nReliableSendMsgCount > 0 );
+	CHECK( g_peerServer.m_nReliableSendMsgCount > 0 );
+	CHECK( g_peerServer.m_nReliableExpectedRecvMsg == g_peerClient.m_nReliableSendMsgCount + 1 );
+	CHECK( g_peerClient.m_nReliableExpectedRecvMsg == g_peerServer.m_nReliableSendMsgCount + 1 );
+
+	#ifdef STEAMNETWORKINGSOCKETS_OPENSOURCE
+	{
+		// If any messages were sent without the lock, none of them should
+		// have failed after the call returned
+		SteamNetworkingLockFreeSendStats lockFreeStats;
+		for ( HSteamNetConnection hConn: { g_peerServer.m_hSteamNetConnection, g_peerClient.m_hSteamNetConnection } )
+		{
+			bool bGotLockFreeStats = SteamNetworkingSockets_GetLockFreeSendStats( hConn, &lockFreeStats );
+			CHECK( bGotLockFreeStats );
+			CHECK( lockFreeStats.m_nFailed == 0 );
+		}
+	}
+	#endif
+}
+
+static void RunSteamDatagramConnectionTest()
+{
+	// Command line options:
+	// -connect:ip -- don't create a server, just try to connect to the given ip
+	// -serveronly -- don't create a client only create a server and wait for connection
 	//const char *s_pszConnectParm = "-connect:";
 	//for ( int i = 0; i < CommandLine()->ParmCount(); ++i )
 	//{
@@ -541,19 +742,14 @@ static void RunSteamDatagramConnectionTest()
 	//	}
 	//}
 
-	// Initiate connection
-	g_hSteamListenSocket = pSteamSocketNetworking->CreateListenSocketIP( bindServerAddress, 0, nullptr );
-	g_peerClient.m_hSteamNetConnection = pSteamSocketNetworking->ConnectByIPAddress( connectToServerAddress, 0, nullptr );
-	pSteamSocketNetworking->SetConnectionName( g_peerClient.m_hSteamNetConnection, "Client" );
+	// Measure ping from when packets actually arrived
+	SteamNetworkingUtils()->SetGlobalConfigValueInt32( k_ESteamNetworkingConfig_UDPRecvKernelTimestamps, 1 );
 
-//	// Send a few random message, before we get connected, just to test that case
-//	g_peerClient.SendRandomMessage( true );
-//	g_peerClient.SendRandomMessage( true );
-//	g_peerClient.SendRandomMessage( true );
+	// Grow receive buffers if the kernel drops anything
+	SteamNetworkingUtils()->SetGlobalConfigValueInt32( k_ESteamNetworkingConfig_UDPRecvBufferMax, 4*1024*1024 );
 
-	// Wait for connection to complete
-	while ( !g_peerClient.m_bIsConnected || !g_peerServer.m_bIsConnected )
-		PumpCallbacks();
+	// Initiate connection
+	ConnectPeers();
 
 	auto Test = []( int rate, float loss, int lag, float reorderPct, int reorderLag )
 	{
@@ -581,6 +777,376 @@ static void RunSteamDatagramConnectionTest()
 	Test( 64000, 5, 50, 2, 50 );
 #endif
 	Test( 1000000, 5, 50, 2, 10 );
+
+	// Outbound packets sent in batches.  (Use no fake lag, since lagged
+	// packets are sent individually when they come out of the lag queue.
+	// And use a high rate, so that there is usually more than one packet
+	// to send per pass.)
+	#ifdef STEAMNETWORKINGSOCKETS_OPENSOURCE
+		SteamNetworkingSocketsUDPStats udpStatsBeforeBatch;
+		SteamNetworkingSockets_GetUDPStats( &udpStatsBeforeBatch );
+	#endif
+	SteamNetworkingUtils()->SetGlobalConfigValueInt32( k_ESteamNetworkingConfig_UDPSendBatchSize, 32 );
+	Test( 20000000, 0, 0, 0, 0 );
+	SteamNetworkingUtils()->SetGlobalConfigValueInt32( k_ESteamNetworkingConfig_UDPSendBatchSize, 0 );
+	#ifdef STEAMNETWORKINGSOCKETS_OPENSOURCE
+	{
+		SteamNetworkingSocketsUDPStats udpStatsAfterBatch;
+		SteamNetworkingSockets_GetUDPStats( &udpStatsAfterBatch );
+		int64 nBatchPackets = udpStatsAfterBatch.m_nSendPackets - udpStatsBeforeBatch.m_nSendPackets;
+		int64 nBatchCalls = udpStatsAfterBatch.m_nSendCalls - udpStatsBeforeBatch.m_nSendCalls;
+		Printf( "Batched UDP send: %lld packets in %lld calls\n", (long long)nBatchPackets, (long long)nBatchCalls );
+		#ifdef __linux__
+			// Sends must actually have been batched
+			CHECK( nBatchPackets > nBatchCalls );
+		#endif
+	}
+	#endif
+
+	// Runs of same size packets coalesced with UDP GSO, where supported.
+	// Reconnect with GRO enabled on the new sockets, so these arrive
+	// coalesced, too.  (GRO only affects sockets opened after it is set.)
+	DisconnectPeers();
+	SteamNetworkingUtils()->SetGlobalConfigValueInt32( k_ESteamNetworkingConfig_UDPRecvGRO, 1 );
+	ConnectPeers();
+	#ifdef STEAMNETWORKINGSOCKETS_OPENSOURCE
+		SteamNetworkingSocketsUDPStats udpStatsBeforeGSO;
+		SteamNetworkingSockets_GetUDPStats( &udpStatsBeforeGSO );
+	#endif
+	SteamNetworkingUtils()->SetGlobalConfigValueInt32( k_ESteamNetworkingConfig_UDPSendGSO, 1 );
+	Test( 2000000, 0, 0, 0, 0 );
+	SteamNetworkingUtils()->SetGlobalConfigValueInt32( k_ESteamNetworkingConfig_UDPSendGSO, 0 );
+	SteamNetworkingUtils()->SetGlobalConfigValueInt32( k_ESteamNetworkingConfig_UDPRecvGRO, 0 );
+	#ifdef STEAMNETWORKINGSOCKETS_OPENSOURCE
+	{
+		SteamNetworkingSocketsUDPStats udpStatsAfterGSO;
+		SteamNetworkingSockets_GetUDPStats( &udpStatsAfterGSO );
+		int64 nGSOSegments = udpStatsAfterGSO.m_nSendGSOSegments - udpStatsBeforeGSO.m_nSendGSOSegments;
+		Printf( "UDP GSO: %lld packets sent as coalesced segments\n", (long long)nGSOSegments );
+
+		// Something must actually have been coalesced, if the kernel can do
+		// it.  (io_uring and AF_XDP sends don't use GSO.)
+		if ( BKernelSupportsUDPGSO() && !g_bIOUring && !g_bXDP )
+			CHECK( nGSOSegments > 0 );
+	}
+	#endif
+
+	#ifdef STEAMNETWORKINGSOCKETS_OPENSOURCE
+		SteamNetworkingSocketsUDPStats udpStats;
+		SteamNetworkingSockets_GetUDPStats( &udpStats );
+		Printf( "UDP recv: %lld packets in %lld calls (%.2f packets/call)\n",
+			(long long)udpStats.m_nRecvPackets, (long long)udpStats.m_nRecvCalls,
+			udpStats.m_nRecvCalls > 0 ? (double)udpStats.m_nRecvPackets / udpStats.m_nRecvCalls : 0.0 );
+		Printf( "UDP send: %lld packets in %lld calls (%.2f packets/call), %lld calls retried\n",
+			(long long)udpStats.m_nSendPackets, (long long)udpStats.m_nSendCalls,
+			udpStats.m_nSendCalls > 0 ? (double)udpStats.m_nSendPackets / udpStats.m_nSendCalls : 0.0,
+			(long long)udpStats.m_nSendRetries );
+		const double flTestSeconds = ( SteamNetworkingUtils()->GetLocalTimestamp() - g_logTimeZero ) * 1e-6;
+		Printf( "Service wakeups: %lld (%.1f/sec), %lld for periodic processing\n",
+			(long long)udpStats.m_nWakeups, flTestSeconds > 0.0 ? udpStats.m_nWakeups / flTestSeconds : 0.0,
+			(long long)udpStats.m_nThinkerWakeups );
+		if ( udpStats.m_nBusyPollSpins > 0 )
+			Printf( "Busy poll: %lld of %lld spins found work\n",
+				(long long)udpStats.m_nBusyPollUseful, (long long)udpStats.m_nBusyPollSpins );
+		CHECK( udpStats.m_nRecvPackets >= udpStats.m_nRecvCalls );
+		CHECK( udpStats.m_nSendPackets >= udpStats.m_nSendCalls );
+		CHECK( udpStats.m_nBusyPollUseful <= udpStats.m_nBusyPollSpins );
+		CHECK( udpStats.m_nThinkerWakeups <= udpStats.m_nWakeups );
+
+		SteamNetworkingSocketsUDPSocketStats sockStats[ 16 ];
+		int nSockets = SteamNetworkingSockets_GetUDPSocketStats( sockStats, 16 );
+		int64 nSocketRecvPackets = 0, nSocketKernelDrops = 0;
+		for ( int i = 0 ; i < nSockets && i < 16 ; ++i )
+		{
+			char szAddr[ SteamNetworkingIPAddr::k_cchMaxString ];
+			sockStats[i].m_addrLocal.ToString( szAddr, sizeof(szAddr), true );
+			Printf( "UDP socket %s: %lld packets, %lld kernel drops, %d byte recv buffer\n", szAddr,
+				(long long)sockStats[i].m_nRecvPackets, (long long)sockStats[i].m_nKernelDrops, sockStats[i].m_cbRecvBuffer );
+			nSocketRecvPackets += sockStats[i].m_nRecvPackets;
+			nSocketKernelDrops += sockStats[i].m_nKernelDrops;
+		}
+		Printf( "UDP kernel drops: %lld\n", (long long)udpStats.m_nKernelDrops );
+		CHECK( nSockets > 0 );
+		CHECK( nSocketRecvPackets <= udpStats.m_nRecvPackets );
+		CHECK( nSocketKernelDrops <= udpStats.m_nKernelDrops );
+
+		// Lock stats, worst offenders first
+		SteamNetworkingSocketsLockStats lockStats[ 64 ];
+		int nTags = std::min( SteamNetworkingSockets_GetLockStats( lockStats, 64 ), 64 );
+		std::sort( lockStats, lockStats + nTags, []( const SteamNetworkingSocketsLockStats &a, const SteamNetworkingSocketsLockStats &b ) {
+			return a.m_usecWaitTotal + a.m_usecHoldTotal > b.m_usecWaitTotal + b.m_usecHoldTotal;
+		} );
+		int64 nServiceThreadHolds = 0;
+		for ( int i = 0 ; i < nTags ; ++i )
+		{
+			const SteamNetworkingSocketsLockStats &t = lockStats[i];
+			if ( i < 8 )
+				Printf( "Lock %-40s waited %6lld times, %8.1fms total, %6.2fms max.  Held %6lld times, %8.1fms total, %6.2fms max\n", t.m_szTag,
+					(long long)t.m_nWaits, t.m_usecWaitTotal*1e-3, t.m_usecWaitMax*1e-3,
+					(long long)t.m_nHolds, t.m_usecHoldTotal*1e-3, t.m_usecHoldMax*1e-3 );
+			int64 nWaits = 0, nHolds = 0;
+			for ( int b = 0 ; b < k_nSteamNetworkingSocketsLockHistogramBuckets ; ++b )
+			{
+				nWaits += t.m_nWaitHistogram[b];
+				nHolds += t.m_nHoldHistogram[b];
+			}
+			CHECK( nWaits == t.m_nWaits );
+			CHECK( nHolds == t.m_nHolds );
+			CHECK( t.m_usecWaitMax <= t.m_usecWaitTotal );
+			CHECK( t.m_usecHoldMax <= t.m_usecHoldTotal );
+			if ( strcmp( t.m_szTag, "ServiceThread" ) == 0 )
+				nServiceThreadHolds = t.m_nHolds;
+		}
+		CHECK( nTags > 0 );
+		CHECK( g_bExternalPoll || nServiceThreadHolds > 0 );
+
+		SteamNetworkingSockets_ResetLockStats();
+		nTags = std::min( SteamNetworkingSockets_GetLockStats( lockStats, 64 ), 64 );
+		for ( int i = 0 ; i < nTags ; ++i )
+		{
+			// We haven't made any other API calls since the reset.  (But the
+			// service thread might have taken the lock.)
+			if ( strcmp( lockStats[i].m_szTag, "CloseConnection" ) == 0 || strcmp( lockStats[i].m_szTag, "ConnectByIPAddress" ) == 0 )
+				CHECK( lockStats[i].m_nHolds == 0 );
+		}
+
+		if ( g_hPollGroup != k_HSteamNetPollGroup_Invalid )
+		{
+			SteamNetworkingPollGroupRecvRingStats ringStats;
+			bool bGotRingStats = SteamNetworkingSockets_GetPollGroupRecvRingStats( g_hPollGroup, &ringStats );
+			CHECK( bGotRingStats );
+			Printf( "Poll group ring: %lld messages through the ring, %lld queued, ring full %lld times, max depth %d of %d\n",
+				(long long)ringStats.m_nMessagesRing, (long long)ringStats.m_nMessagesQueued, (long long)ringStats.m_nRingFull,
+				ringStats.m_nRingMaxDepth, ringStats.m_nRingSize );
+			CHECK( ringStats.m_nMessagesRing > 0 );
+			CHECK( ringStats.m_nRingMaxDepth <= ringStats.m_nRingSize );
+			CHECK( ringStats.m_nRingDepth <= ringStats.m_nRingMaxDepth );
+			CHECK( ringStats.m_nRingFull <= ringStats.m_nMessagesQueued );
+		}
+	#endif
+}
+
+// Measure how long it takes to get the current time.  We do this a lot,
+// multiple times per packet.  Compare to asking the OS directly.
+static void BenchmarkLocalTimestamp()
+{
+	const int N = 1000000;
+	SteamNetworkingMicroseconds usecStart = SteamNetworkingUtils()->GetLocalTimestamp();
+	auto tStart = std::chrono::steady_clock::now();
+	SteamNetworkingMicroseconds usecPrev = usecStart;
+	for ( int i = 0 ; i < N ; ++i )
+	{
+		SteamNetworkingMicroseconds usecNow = SteamNetworkingUtils()->GetLocalTimestamp();
+		CHECK( usecNow >= usecPrev );
+		usecPrev = usecNow;
+	}
+	auto tEnd = std::chrono::steady_clock::now();
+	SteamNetworkingMicroseconds usecEnd = SteamNetworkingUtils()->GetLocalTimestamp();
+	const double flNanosecondsPerCall = std::chrono::duration<double, std::nano>( tEnd - tStart ).count() / N;
+
+	auto tPrev = tEnd;
+	for ( int i = 0 ; i < N ; ++i )
+	{
+		auto t = std::chrono::steady_clock::now();
+		CHECK( t >= tPrev );
+		tPrev = t;
+	}
+	const double flNanosecondsPerCallOS = std::chrono::duration<double, std::nano>( tPrev - tEnd ).count() / N;
+
+	// Both clocks should agree on how much time elapsed
+	const int64 usecElapsed = std::chrono::duration_cast<std::chrono::microseconds>( tEnd - tStart ).count();
+	const int64 usecDisagree = ( usecEnd - usecStart ) - usecElapsed;
+	Printf( "GetLocalTimestamp: %.1fns per call.  steady_clock::now: %.1fns per call.  Elapsed %lldus, clocks disagree by %lldus\n",
+		flNanosecondsPerCall, flNanosecondsPerCallOS, (long long)usecElapsed, (long long)usecDisagree );
+	CHECK( usecDisagree > -5000 && usecDisagree < 5000 + usecElapsed/100 );
+
+	// Time doesn't go backwards, even when different threads (probably on
+	// different CPUs) take turns reading it
+	std::atomic<SteamNetworkingMicroseconds> usecLatest( SteamNetworkingUtils()->GetLocalTimestamp() );
+	std::atomic<int> nBackwards( 0 );
+	std::vector<std::thread> vecThreads;
+	for ( int t = 0 ; t < 4 ; ++t )
+	{
+		vecThreads.emplace_back( [&]{
+			for ( int i = 0 ; i < N/4 ; ++i )
+			{
+				SteamNetworkingMicroseconds usecPrevLatest = usecLatest.load();
+				SteamNetworkingMicroseconds usecNow = SteamNetworkingUtils()->GetLocalTimestamp();
+				if ( usecNow < usecPrevLatest )
+					++nBackwards;
+				while ( usecNow > usecPrevLatest && !usecLatest.compare_exchange_weak( usecPrevLatest, usecNow ) )
+					;
+			}
+		} );
+	}
+	for ( std::thread &t: vecThreads )
+		t.join();
+	CHECK( nBackwards == 0 );
+}
+
+// Idle connections should be compact.  Detailed stats and debug history are
+// not allocated unless asked for.  Measure the heap around creating a batch
+// of connections and nothing else.
+static void TestConnectionSize()
+{
+#ifdef __GLIBC__
+	ISteamNetworkingSockets *pSteamSocketNetworking = SteamNetworkingSockets();
+	const int k_nPairs = 256;
+	std::vector<HSteamNetConnection> vecConns;
+	vecConns.reserve( k_nPairs*2 );
+
+	// Returns heap bytes per connection
+	auto CreateBatch = [&]() -> int
+	{
+		size_t cbHeapStart = GetHeapBytesInUse();
+		for ( int i = 0 ; i < k_nPairs ; ++i )
+		{
+			HSteamNetConnection hConn1, hConn2;
+			bool bCreated = pSteamSocketNetworking->CreateSocketPair( &hConn1, &hConn2, false, nullptr, nullptr );
+			CHECK( bCreated );
+			vecConns.push_back( hConn1 );
+			vecConns.push_back( hConn2 );
+		}
+		return int( ( GetHeapBytesInUse() - cbHeapStart ) / vecConns.size() );
+	};
+	auto DestroyBatch = [&]
+	{
+		pSteamSocketNetworking->RunCallbacks();
+		for ( HSteamNetConnection hConn: vecConns )
+			pSteamSocketNetworking->CloseConnection( hConn, 0, nullptr, false );
+		pSteamSocketNetworking->RunCallbacks();
+		vecConns.clear();
+	};
+
+	// Once first, so that tables and pools have already grown to fit
+	CreateBatch();
+	DestroyBatch();
+
+	const int cbPerConnection = CreateBatch();
+	DestroyBatch();
+
+	// Same thing with the percentile samples allocated up front, to make
+	// sure we are measuring what we think we are
+	SteamNetworkingUtils()->SetGlobalConfigValueInt32( k_ESteamNetworkingConfig_LinkStatsDetail, 1 );
+	const int cbPerConnectionWithSamples = CreateBatch();
+	DestroyBatch();
+	SteamNetworkingUtils()->SetGlobalConfigValueInt32( k_ESteamNetworkingConfig_LinkStatsDetail, 0 );
+
+	Printf( "Heap per idle connection: %d bytes, %d with percentile samples\n", cbPerConnection, cbPerConnectionWithSamples );
+	CHECK( cbPerConnection < 10*1024 ); // Was ~20K with percentile samples inline
+	CHECK( cbPerConnectionWithSamples > cbPerConnection + 1024 );
+#endif
+}
+
+// Create more connections than used to be allowed (0x1fff), and make sure the
+// handles are unique, and go stale once the connection is destroyed.
+static void TestManyConnections()
+{
+	ISteamNetworkingSockets *pSteamSocketNetworking = SteamNetworkingSockets();
+	const int k_nPairs = 0x1fff/2 + 10;
+	std::vector<HSteamNetConnection> vecConns;
+	vecConns.reserve( k_nPairs*2 );
+
+	SteamNetworkingMicroseconds usecStart = SteamNetworkingUtils()->GetLocalTimestamp();
+	for ( int i = 0 ; i < k_nPairs ; ++i )
+	{
+		HSteamNetConnection hConn1, hConn2;
+		bool bCreated = pSteamSocketNetworking->CreateSocketPair( &hConn1, &hConn2, false, nullptr, nullptr );
+		CHECK( bCreated );
+		vecConns.push_back( hConn1 );
+		vecConns.push_back( hConn2 );
+		if ( i % 10 == 0 )
+		{
+			pSteamSocketNetworking->RunCallbacks();
+			Wait( 0 );
+		}
+	}
+	SteamNetworkingMicroseconds usecCreated = SteamNetworkingUtils()->GetLocalTimestamp();
+
+	// Asking for details allocates them on demand
+	char szDetails[ 4096 ];
+	int rDetails = pSteamSocketNetworking->GetDetailedConnectionStatus( vecConns[0], szDetails, sizeof(szDetails) );
+	CHECK( rDetails == 0 );
+
+	std::vector<HSteamNetConnection> vecSorted( vecConns );
+	std::sort( vecSorted.begin(), vecSorted.end() );
+	CHECK( vecSorted[0] != k_HSteamNetConnection_Invalid );
+	CHECK( std::adjacent_find( vecSorted.begin(), vecSorted.end() ) == vecSorted.end() );
+
+	// Every handle finds its own connection
+	for ( size_t i = 0 ; i < vecConns.size() ; ++i )
+	{
+		bool bSet = pSteamSocketNetworking->SetConnectionUserData( vecConns[i], (int64)i );
+		CHECK( bSet );
+	}
+	for ( size_t i = 0 ; i < vecConns.size() ; ++i )
+		CHECK( pSteamSocketNetworking->GetConnectionUserData( vecConns[i] ) == (int64)i );
+	SteamNetworkingMicroseconds usecLookedUp = SteamNetworkingUtils()->GetLocalTimestamp();
+
+	for ( size_t i = 0 ; i < vecConns.size() ; ++i )
+	{
+		pSteamSocketNetworking->CloseConnection( vecConns[i], 0, nullptr, false );
+		if ( i % 10 == 0 )
+		{
+			pSteamSocketNetworking->RunCallbacks();
+			Wait( 0 );
+		}
+	}
+	pSteamSocketNetworking->RunCallbacks();
+
+	// Old handles are stale, even once the slots are reused
+	HSteamNetConnection hConn1, hConn2;
+	bool bCreated = pSteamSocketNetworking->CreateSocketPair( &hConn1, &hConn2, false, nullptr, nullptr );
+	CHECK( bCreated );
+	CHECK( !std::binary_search( vecSorted.begin(), vecSorted.end(), hConn1 ) );
+	CHECK( !std::binary_search( vecSorted.begin(), vecSorted.end(), hConn2 ) );
+	for ( HSteamNetConnection hConn: vecConns )
+	{
+		bool bSet = pSteamSocketNetworking->SetConnectionUserData( hConn, 1234 );
+		CHECK( !bSet );
+	}
+	pSteamSocketNetworking->CloseConnection( hConn1, 0, nullptr, false );
+	pSteamSocketNetworking->CloseConnection( hConn2, 0, nullptr, false );
+
+	Printf( "Created %d connections in %.1fms, %.0fns per API call\n", (int)vecConns.size(),
+		( usecCreated - usecStart )*1e-3, ( usecLookedUp - usecCreated )*1e3 / ( vecConns.size()*2 ) );
+}
+
+// Destroy poll groups with delivery rings while another thread is reading
+// from them without the lock
+static void TestPollGroupRecvRingDestroy()
+{
+	ISteamNetworkingSockets *pSteamSocketNetworking = SteamNetworkingSockets();
+	SteamNetworkingUtils()->SetGlobalConfigValueInt32( k_ESteamNetworkingConfig_PollGroupRecvRingSize, 4 );
+
+	std::atomic<HSteamNetPollGroup> hPollGroup( k_HSteamNetPollGroup_Invalid );
+	std::atomic<bool> bDone( false );
+	std::atomic<int> nReads( 0 );
+	std::thread threadReader( [&] {
+		SteamNetworkingMessage_t *pMsgs[ 8 ];
+		while ( !bDone.load() )
+		{
+			int n = pSteamSocketNetworking->ReceiveMessagesOnPollGroup( hPollGroup.load(), pMsgs, 8 );
+			for ( int i = 0 ; i < n ; ++i )
+				pMsgs[i]->Release();
+			++nReads;
+		}
+	} );
+
+	const int k_nIterations = 500;
+	for ( int i = 0 ; i < k_nIterations ; ++i )
+	{
+		HSteamNetPollGroup h = pSteamSocketNetworking->CreatePollGroup();
+		CHECK( h != k_HSteamNetPollGroup_Invalid );
+		hPollGroup.store( h );
+		std::this_thread::yield();
+		CHECK( pSteamSocketNetworking->DestroyPollGroup( h ) );
+	}
+	bDone.store( true );
+	threadReader.join();
+	SteamNetworkingUtils()->SetGlobalConfigValueInt32( k_ESteamNetworkingConfig_PollGroupRecvRingSize, 0 );
+
+	Printf( "Destroyed %d poll groups with rings during %d lock-free reads\n", k_nIterations, nReads.load() );
 }
 
 // Some tests for identity string handling.  Doesn't really have anything to do with
@@ -620,21 +1186,280 @@ void TestSteamNetworkingIdentity()
 
 }
 
-int main(  )
+// If requested, drive the library from our own poll loop, rather than
+// the service thread.  Fall back to the service thread if we can't.
+static void StartExternalPoll()
+{
+	if ( !g_bExternalPoll )
+		return;
+	SteamNetworkingSockets_SetManualPollMode( true );
+	if ( SteamNetworkingSockets_GetPollFD() < 0 )
+	{
+		Printf( "No pollable descriptor on this platform, using the service thread\n" );
+		SteamNetworkingSockets_SetManualPollMode( false );
+		g_bExternalPoll = false;
+	}
+}
+
+#ifdef STEAMNETWORKINGSOCKETS_OPENSOURCE
+// Stats when the current backend phase started, for phases that check
+// the counters for their own feature
+static SteamNetworkingSocketsUDPStats s_udpStatsPhaseStart;
+static SteamNetworkingLockFreeSendStats s_lockFreeStatsPhaseStart;
+#endif
+
+// A low level option to give a short run.  Backends are selected when the
+// library is initialized, and fall back to ordinary sockets if the host
+// doesn't support them, so these should pass everywhere, they just won't
+// test much on some hosts.
+struct BackendPhase_t
+{
+	const char *m_pszName;
+
+	// Turn the option on or off, while the library is shut down
+	void (*m_fnSetOption)( bool bEnable );
+
+	// Optional.  Called once the library is running, before connecting
+	void (*m_fnStart)();
+
+	// Optional.  Called after exchanging messages, before disconnecting
+	void (*m_fnFinish)();
+};
+
+static const BackendPhase_t k_BackendPhases[] =
+{
+	{ "io_uring", []( bool bEnable ) {
+		SteamNetworkingUtils()->SetGlobalConfigValueInt32( k_ESteamNetworkingConfig_UDPIOUring, bEnable ? 1 : 0 );
+		g_bIOUring = bEnable;
+	}, nullptr, nullptr },
+
+	{ "busy poll", []( bool bEnable ) {
+		SteamNetworkingUtils()->SetGlobalConfigValueInt32( k_ESteamNetworkingConfig_ServiceThreadBusyPoll, bEnable ? 2000 : 0 );
+	}, nullptr, [] {
+		#ifdef STEAMNETWORKINGSOCKETS_OPENSOURCE
+		{
+			// The service thread must actually have spun
+			SteamNetworkingSocketsUDPStats udpStats;
+			SteamNetworkingSockets_GetUDPStats( &udpStats );
+			CHECK( udpStats.m_nBusyPollSpins > s_udpStatsPhaseStart.m_nBusyPollSpins );
+		}
+		#endif
+	} },
+
+	// The loopback interface is always there, but we might not be allowed
+	// to open an AF_XDP socket on it
+	{ "AF_XDP on lo", []( bool bEnable ) {
+		SteamNetworkingUtils()->SetGlobalConfigValueString( k_ESteamNetworkingConfig_XDP_Interface, bEnable ? "lo" : "" );
+		g_bXDP = bEnable;
+	}, nullptr, nullptr },
+
+	{ "external poll", []( bool bEnable ) {
+		if ( !bEnable )
+			SteamNetworkingSockets_SetManualPollMode( false );
+		g_bExternalPoll = bEnable;
+	}, nullptr, nullptr },
+
+	{ "lock-free send", []( bool bEnable ) {
+		SteamNetworkingUtils()->SetGlobalConfigValueInt32( k_ESteamNetworkingConfig_LockFreeSendQueueSize, bEnable ? 4*1024*1024 : 0 );
+	}, [] {
+		#ifdef STEAMNETWORKINGSOCKETS_OPENSOURCE
+		{
+			// Sending to a bad handle succeeds, but the failure is counted
+			// when the message is picked up
+			SteamNetworkingLockFreeSendStats lockFreeStats;
+			SteamNetworkingSockets_GetLockFreeSendStats( k_HSteamNetConnection_Invalid, &s_lockFreeStatsPhaseStart );
+			EResult eResult = SteamNetworkingSockets()->SendMessageToConnection( 12345, "x", 1, k_nSteamNetworkingSend_Reliable, nullptr );
+			CHECK( eResult == k_EResultOK );
+			SteamNetworkingSockets_GetLockFreeSendStats( k_HSteamNetConnection_Invalid, &lockFreeStats );
+			CHECK( lockFreeStats.m_nFailed == s_lockFreeStatsPhaseStart.m_nFailed + 1 );
+			CHECK( lockFreeStats.m_nFailedReliable > 0 );
+			CHECK( lockFreeStats.m_eLastFailure == k_EResultInvalidParam );
+		}
+		#endif
+	}, [] {
+		#ifdef STEAMNETWORKINGSOCKETS_OPENSOURCE
+		{
+			// The messages really did go through the queue
+			SteamNetworkingLockFreeSendStats lockFreeStats;
+			SteamNetworkingSockets_GetLockFreeSendStats( k_HSteamNetConnection_Invalid, &lockFreeStats );
+			Printf( "Lock-free send: %lld messages, %lld failed\n",
+				(long long)( lockFreeStats.m_nMessages - s_lockFreeStatsPhaseStart.m_nMessages ),
+				(long long)( lockFreeStats.m_nFailed - s_lockFreeStatsPhaseStart.m_nFailed ) );
+			CHECK( lockFreeStats.m_nMessages > s_lockFreeStatsPhaseStart.m_nMessages + 1 );
+			CHECK( lockFreeStats.m_nFailed == s_lockFreeStatsPhaseStart.m_nFailed + 1 );
+		}
+		#endif
+	} },
+
+	// Receive through a poll group with a tiny delivery ring.  The poll group
+	// is made and destroyed inside the phase, since it doesn't survive
+	// restarting the library
+	{ "poll group ring", []( bool bEnable ) {
+		SteamNetworkingUtils()->SetGlobalConfigValueInt32( k_ESteamNetworkingConfig_PollGroupRecvRingSize, bEnable ? 4 : 0 );
+	}, [] {
+		g_hPollGroup = SteamNetworkingSockets()->CreatePollGroup();
+		CHECK( g_hPollGroup != k_HSteamNetPollGroup_Invalid );
+	}, [] {
+		#ifdef STEAMNETWORKINGSOCKETS_OPENSOURCE
+		{
+			// Send a burst without receiving anything, so the ring fills up
+			// and messages spill into the ordinary queue
+			SteamNetworkingPollGroupRecvRingStats ringStatsBefore, ringStats;
+			SteamNetworkingSockets_GetPollGroupRecvRingStats( g_hPollGroup, &ringStatsBefore );
+			const int nBurst = 64;
+			for ( int i = 0 ; i < nBurst ; ++i )
+				g_peerClient.SendRandomMessage( true, 100 );
+			const SteamNetworkingMicroseconds usecGiveUp = SteamNetworkingUtils()->GetLocalTimestamp() + 5*1000000;
+			do
+			{
+				std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+				SteamNetworkingSockets_GetPollGroupRecvRingStats( g_hPollGroup, &ringStats );
+			} while ( ringStats.m_nMessagesRing + ringStats.m_nMessagesQueued < ringStatsBefore.m_nMessagesRing + ringStatsBefore.m_nMessagesQueued + nBurst
+				&& SteamNetworkingUtils()->GetLocalTimestamp() < usecGiveUp );
+			Printf( "Poll group ring: %lld messages through the ring, %lld queued, ring full %lld times, max depth %d of %d\n",
+				(long long)ringStats.m_nMessagesRing, (long long)ringStats.m_nMessagesQueued, (long long)ringStats.m_nRingFull,
+				ringStats.m_nRingMaxDepth, ringStats.m_nRingSize );
+			CHECK( ringStats.m_nRingSize == 4 );
+			CHECK( ringStats.m_nRingMaxDepth == ringStats.m_nRingSize );
+			CHECK( ringStats.m_nRingFull > ringStatsBefore.m_nRingFull );
+			CHECK( ringStats.m_nMessagesQueued > ringStatsBefore.m_nMessagesQueued );
+
+			// Everything still arrives, in order
+			while ( g_peerServer.m_nReliableExpectedRecvMsg <= g_peerClient.m_nReliableSendMsgCount
+				&& SteamNetworkingUtils()->GetLocalTimestamp() < usecGiveUp )
+			{
+				PumpCallbacksAndMakeSureStillConnected();
+				Recv( SteamNetworkingSockets() );
+			}
+			CHECK( g_peerServer.m_nReliableExpectedRecvMsg == g_peerClient.m_nReliableSendMsgCount + 1 );
+			SteamNetworkingSockets_GetPollGroupRecvRingStats( g_hPollGroup, &ringStats );
+			CHECK( ringStats.m_nRingDepth == 0 );
+		}
+		#endif
+		SteamNetworkingSockets()->DestroyPollGroup( g_hPollGroup );
+		g_hPollGroup = k_HSteamNetPollGroup_Invalid;
+	} },
+};
+
+// Restart the library with the option turned on, and make sure data still
+// flows
+static void TestBackend( const BackendPhase_t &phase )
+{
+	Printf( "---------------------------------------------------\n" );
+	Printf( "BACKEND: %s\n", phase.m_pszName );
+	Printf( "---------------------------------------------------\n" );
+
+	ShutdownSteamDatagramConnectionSockets();
+	phase.m_fnSetOption( true );
+	InitSteamDatagramConnectionSockets();
+	StartExternalPoll();
+	#ifdef STEAMNETWORKINGSOCKETS_OPENSOURCE
+		SteamNetworkingSockets_GetUDPStats( &s_udpStatsPhaseStart );
+	#endif
+	if ( phase.m_fnStart )
+		phase.m_fnStart();
+
+	ConnectPeers();
+	ExchangeMessages( 500 );
+	if ( phase.m_fnFinish )
+		phase.m_fnFinish();
+	DisconnectPeers();
+	#ifdef STEAMNETWORKINGSOCKETS_OPENSOURCE
+	{
+		SteamNetworkingSocketsUDPStats udpStats;
+		SteamNetworkingSockets_GetUDPStats( &udpStats );
+		CHECK( udpStats.m_nRecvPackets > s_udpStatsPhaseStart.m_nRecvPackets );
+		CHECK( udpStats.m_nSendPackets > s_udpStatsPhaseStart.m_nSendPackets );
+	}
+	#endif
+
+	ShutdownSteamDatagramConnectionSockets();
+	phase.m_fnSetOption( false );
+	InitSteamDatagramConnectionSockets();
+}
+
+// Give each low level backend a short run
+static void TestBackends()
+{
+	for ( const BackendPhase_t &phase: k_BackendPhases )
+		TestBackend( phase );
+}
+
+int main( int argc, const char **argv )
 {
 	// Test some identity printing/parsing stuff
 	TestSteamNetworkingIdentity();
 
+	// Command line options:
+	// -iouring -- use io_uring for the raw sockets, where supported
+	// -busypoll -- service thread busy polls for a while after doing any work
+	// -pin -- pin the service thread to CPU 0
+	// -xdp <interface> -- receive and send IPv4 through AF_XDP on the interface, where supported
+	// -extpoll -- no service thread, drive the library from our own poll loop, where supported
+	// -lockfreesend -- send messages without taking the lock
+	// -recvring -- receive through a poll group with a small lock-free delivery ring
+	bool bUsePollGroup = false;
+	bool bTestBackends = true;
+	for ( int i = 1 ; i < argc ; ++i )
+	{
+		if ( strcmp( argv[i], "-iouring" ) == 0 )
+		{
+			SteamNetworkingUtils()->SetGlobalConfigValueInt32( k_ESteamNetworkingConfig_UDPIOUring, 1 );
+			g_bIOUring = true;
+			bTestBackends = false;
+		}
+		else if ( strcmp( argv[i], "-pin" ) == 0 )
+			SteamNetworkingUtils()->SetGlobalConfigValueString( k_ESteamNetworkingConfig_ServiceThreadAffinity, "0" );
+		else if ( strcmp( argv[i], "-busypoll" ) == 0 )
+		{
+			SteamNetworkingUtils()->SetGlobalConfigValueInt32( k_ESteamNetworkingConfig_ServiceThreadBusyPoll, 2000 );
+			bTestBackends = false;
+		}
+		else if ( strcmp( argv[i], "-xdp" ) == 0 && i+1 < argc )
+		{
+			SteamNetworkingUtils()->SetGlobalConfigValueString( k_ESteamNetworkingConfig_XDP_Interface, argv[++i] );
+			g_bXDP = true;
+			bTestBackends = false;
+		}
+		else if ( strcmp( argv[i], "-extpoll" ) == 0 )
+		{
+			g_bExternalPoll = true;
+			bTestBackends = false;
+		}
+		else if ( strcmp( argv[i], "-lockfreesend" ) == 0 )
+			SteamNetworkingUtils()->SetGlobalConfigValueInt32( k_ESteamNetworkingConfig_LockFreeSendQueueSize, 4*1024*1024 );
+		else if ( strcmp( argv[i], "-recvring" ) == 0 )
+		{
+			SteamNetworkingUtils()->SetGlobalConfigValueInt32( k_ESteamNetworkingConfig_PollGroupRecvRingSize, 16 );
+			bUsePollGroup = true;
+			bTestBackends = false; // The poll group doesn't survive restarting the library
+		}
+	}
+
 	// Create client and server sockets
 	InitSteamDatagramConnectionSockets();
+	if ( bUsePollGroup )
+		g_hPollGroup = SteamNetworkingSockets()->CreatePollGroup();
+
+	StartExternalPoll();
+
+	BenchmarkLocalTimestamp();
+	TestConnectionSize();
+	TestManyConnections();
+	TestPollGroupRecvRingDestroy();
 
 	// Run the test
 	RunSteamDatagramConnectionTest();
+	DisconnectPeers();
+
+	// Unless a particular backend was chosen, try them all
+	if ( bTestBackends )
+		TestBackends();
 
 	ShutdownSteamDatagramConnectionSockets();
-	return 0;
+	return g_bTestFailed ? 1 : 0;
 }
 
 #ifdef NN_NINTENDO_SDK
-extern "C" void nnMain() { main(); }
+extern "C" void nnMain() { main( 0, nullptr ); }
 #endif
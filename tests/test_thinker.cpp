@@ -0,0 +1,229 @@
+#include <stdio.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <steamnetworkingsockets/steamnetworkingsockets_thinker.h>
+
+using namespace SteamNetworkingSocketsLib;
+
+// Checks that are evaluated in release builds, too
+#define CHECK(x) do { if ( !(x) ) { printf( "%s(%d): CHECK FAILED: %s\n", __FILE__, __LINE__, #x ); g_failed = true; } } while(0)
+#define CHECK_EQUAL(a,b) CHECK( (a) == (b) )
+bool g_failed = false;
+
+// These tests drive their own wheel, not the global one that
+// IThinker::SetNextThinkTime uses, so we control the time.
+// A thinker must be removed from the wheel before it is destroyed.
+struct CTestThinker : public IThinker
+{
+	int m_nIndex = -1;
+	bool m_bDue = false;
+	virtual void Think( SteamNetworkingMicroseconds usecNow ) override {}
+};
+
+// Arbitrary starting time, with plenty of bits set, so that advancing
+// carries into higher levels at various points
+static const SteamNetworkingMicroseconds k_usecStart = 0x12345678abcLL;
+
+// Remove everything on the due list, and return it in order
+static std::vector<CTestThinker *> PopDue( CThinkerWheel &wheel )
+{
+	std::vector<CTestThinker *> result;
+	while ( IThinker *p = wheel.GetFirstDue() )
+	{
+		wheel.Remove( p );
+		result.push_back( static_cast<CTestThinker *>( p ) );
+	}
+	return result;
+}
+
+// Schedule thinkers on every level, including right at the slot boundaries,
+// and advance the wheel in random steps.  Everything must come due exactly
+// once, in order, in the step where its time is passed.
+static void TestWheelAdvance()
+{
+	std::mt19937_64 rand( 12345 );
+
+	std::vector<SteamNetworkingMicroseconds> vecOffsets;
+	for ( int nBit = 0 ; nBit <= 42 ; nBit += 6 )
+	{
+		SteamNetworkingMicroseconds usecBoundary = SteamNetworkingMicroseconds(1) << nBit;
+		vecOffsets.push_back( usecBoundary );
+		vecOffsets.push_back( usecBoundary + 1 );
+		if ( usecBoundary > 1 )
+			vecOffsets.push_back( usecBoundary - 1 );
+	}
+	for ( int i = 0 ; i < 2000 ; ++i )
+	{
+		int nBits = std::uniform_int_distribution<int>( 1, 40 )( rand );
+		vecOffsets.push_back( 1 + std::uniform_int_distribution<SteamNetworkingMicroseconds>( 0, ( SteamNetworkingMicroseconds(1) << nBits ) - 1 )( rand ) );
+	}
+
+	// Bunches of ties
+	for ( int i = 0 ; i < 8 ; ++i )
+		vecOffsets.push_back( 4096 );
+
+	const int N = (int)vecOffsets.size();
+	std::vector<CTestThinker> vecThinkers( N );
+	CThinkerWheel wheel;
+	wheel.Advance( k_usecStart );
+	for ( int i = 0 ; i < N ; ++i )
+	{
+		vecThinkers[i].m_nIndex = i;
+		wheel.Insert( &vecThinkers[i], k_usecStart + vecOffsets[i] );
+	}
+	CHECK_EQUAL( wheel.Count(), N );
+	CHECK( wheel.GetFirstDue() == nullptr );
+
+	SteamNetworkingMicroseconds usecNow = k_usecStart;
+	SteamNetworkingMicroseconds usecLastDue = 0;
+	int nDue = 0;
+	int nSteps = 0;
+	while ( wheel.Count() > 0 )
+	{
+		// The earliest must be the one with the lowest think time
+		SteamNetworkingMicroseconds usecEarliest = k_nThinkTime_Never;
+		for ( const CTestThinker &t: vecThinkers )
+		{
+			if ( !t.m_bDue )
+				usecEarliest = std::min( usecEarliest, t.GetNextThinkTime() );
+		}
+		IThinker *pEarliest = wheel.GetEarliest();
+		CHECK( pEarliest != nullptr );
+		if ( !pEarliest )
+			break;
+		CHECK_EQUAL( pEarliest->GetNextThinkTime(), usecEarliest );
+		CHECK( wheel.GetEarliestLowerBound() <= usecEarliest );
+
+		// Mostly small steps, which might not get to anything, but
+		// sometimes big ones, which pass a lot
+		int nBits = std::uniform_int_distribution<int>( 0, 36 )( rand );
+		SteamNetworkingMicroseconds usecPrev = usecNow;
+		usecNow += 1 + std::uniform_int_distribution<SteamNetworkingMicroseconds>( 0, ( SteamNetworkingMicroseconds(1) << nBits ) - 1 )( rand );
+		wheel.Advance( usecNow );
+		++nSteps;
+
+		for ( CTestThinker *p: PopDue( wheel ) )
+		{
+			CHECK( !p->m_bDue );
+			CHECK( p->GetNextThinkTime() > usecPrev );
+			CHECK( p->GetNextThinkTime() <= usecNow );
+			CHECK( p->GetNextThinkTime() >= usecLastDue );
+			usecLastDue = p->GetNextThinkTime();
+			p->m_bDue = true;
+			++nDue;
+		}
+	}
+	CHECK_EQUAL( nDue, N );
+	for ( const CTestThinker &t: vecThinkers )
+		CHECK( t.m_bDue );
+
+	printf( "Timer wheel: %d thinkers came due in order over %d steps\n", N, nSteps );
+}
+
+// The earliest thinker is cached.  When it is removed, we need
+// to find the next one, on whatever level it is.
+static void TestWheelRemoveEarliest()
+{
+	CTestThinker t[4];
+	CThinkerWheel wheel;
+	wheel.Advance( k_usecStart );
+	wheel.Insert( &t[0], k_usecStart + 100 );
+	wheel.Insert( &t[1], k_usecStart + 200 ); // Same level 1 slot as t[0]
+	wheel.Insert( &t[2], k_usecStart + 5000 ); // Level 2
+	wheel.Insert( &t[3], k_usecStart + 1000000000 ); // Way up there
+
+	CHECK( wheel.GetEarliest() == &t[0] );
+	wheel.Remove( &t[0] );
+	CHECK( wheel.GetEarliestLowerBound() <= t[1].GetNextThinkTime() );
+	CHECK( wheel.GetEarliest() == &t[1] );
+	CHECK_EQUAL( wheel.GetEarliestLowerBound(), t[1].GetNextThinkTime() );
+	wheel.Remove( &t[1] );
+	CHECK( wheel.GetEarliest() == &t[2] );
+	wheel.Remove( &t[2] );
+	CHECK( wheel.GetEarliest() == &t[3] );
+
+	// Removing something that isn't the earliest doesn't change it
+	wheel.Insert( &t[0], k_usecStart + 100 );
+	wheel.Insert( &t[1], k_usecStart + 200 );
+	CHECK( wheel.GetEarliest() == &t[0] );
+	wheel.Remove( &t[1] );
+	CHECK( wheel.GetEarliest() == &t[0] );
+
+	// Rescheduling the earliest later
+	wheel.Remove( &t[0] );
+	wheel.Insert( &t[0], k_usecStart + 2000000000 );
+	CHECK( wheel.GetEarliest() == &t[3] );
+
+	wheel.Remove( &t[0] );
+	wheel.Remove( &t[3] );
+	CHECK_EQUAL( wheel.Count(), 0 );
+	CHECK( wheel.GetEarliest() == nullptr );
+	CHECK_EQUAL( wheel.GetEarliestLowerBound(), k_nThinkTime_Never );
+}
+
+// Thinkers scheduled for the same microsecond all come due together
+static void TestWheelTies()
+{
+	CTestThinker t[7];
+	CThinkerWheel wheel;
+	wheel.Advance( k_usecStart );
+	const SteamNetworkingMicroseconds usecTie = k_usecStart + 300000; // Level 3
+	wheel.Insert( &t[5], usecTie - 1 );
+	wheel.Insert( &t[6], usecTie + 1 );
+	for ( int i = 0 ; i < 5 ; ++i )
+		wheel.Insert( &t[i], usecTie );
+
+	// Not quite there yet
+	wheel.Advance( usecTie - 1 );
+	std::vector<CTestThinker *> vecDue = PopDue( wheel );
+	CHECK_EQUAL( vecDue.size(), 1u );
+	CHECK( !vecDue.empty() && vecDue[0] == &t[5] );
+	CHECK_EQUAL( wheel.GetEarliest()->GetNextThinkTime(), usecTie );
+
+	wheel.Advance( usecTie );
+	vecDue = PopDue( wheel );
+	CHECK_EQUAL( vecDue.size(), 5u );
+	for ( CTestThinker *p: vecDue )
+		CHECK_EQUAL( p->GetNextThinkTime(), usecTie );
+	CHECK( wheel.GetEarliest() == &t[6] );
+	wheel.Remove( &t[6] );
+}
+
+// Thinkers that are scheduled at or before the current time go straight
+// to the due list.  An ASAP request must go ahead of anything already due.
+static void TestWheelDueOrder()
+{
+	CTestThinker t[5];
+	CThinkerWheel wheel;
+	wheel.Advance( k_usecStart );
+	wheel.Insert( &t[0], k_usecStart - 50 );
+	wheel.Insert( &t[1], k_usecStart - 10 );
+	wheel.Insert( &t[2], k_nThinkTime_ASAP );
+	wheel.Insert( &t[3], k_usecStart - 30 );
+	wheel.Insert( &t[4], k_usecStart - 30 ); // Ties go after the ones already there
+	CHECK( wheel.GetEarliest() == &t[2] );
+
+	std::vector<CTestThinker *> vecDue = PopDue( wheel );
+	CHECK_EQUAL( vecDue.size(), 5u );
+	if ( vecDue.size() == 5 )
+	{
+		CHECK( vecDue[0] == &t[2] );
+		CHECK( vecDue[1] == &t[0] );
+		CHECK( vecDue[2] == &t[3] );
+		CHECK( vecDue[3] == &t[4] );
+		CHECK( vecDue[4] == &t[1] );
+	}
+	CHECK_EQUAL( wheel.Count(), 0 );
+}
+
+int main()
+{
+	TestWheelAdvance();
+	TestWheelRemoveEarliest();
+	TestWheelTies();
+	TestWheelDueOrder();
+
+	return g_failed ? 1 : 0;
+}